@@ -1,7 +1,14 @@
 NAME := lib_mqtt
 
-$(NAME)_SOURCES :=  
+$(NAME)_SOURCES := mqtt_api.c \
+                   mqtt_connection.c \
+                   mqtt_frame.c \
+                   mqtt_manager.c \
+                   mqtt_network.c \
+                   mqtt_pool.c \
+                   mqtt_router.c \
+                   mqtt_session.c \
+                   mqtt_store.c
 GLOBAL_INCLUDES := .
 $(NAME)_AUTO_PROTOTYPE := 1
 $(NAME)_COMPONENTS := cloud/protocols/mqtt/mqtt_wrapper
-$(NAME)_PREBUILT_LIBRARY := $(NAME)-$(BUILD_TYPE).a
\ No newline at end of file
@@ -12,6 +12,8 @@
 #include "mqtt_api.h"
 #include "mqtt_manager.h"
 #include "mqtt_internal.h"
+#include "mqtt_pool.h"
+#include "mqtt_store.h"
 #include "string.h"
 
 /******************************************************
@@ -42,7 +44,6 @@
  *               Variable Definitions
  ******************************************************/
 
-static mqtt_session_t session;
 
 /******************************************************
  *               Function Definitions
@@ -51,17 +52,68 @@ static mqtt_session_t session;
 
 zos_result_t mqtt_init( mqtt_connection_t* mqtt_connection )
 {
+    const mqtt_frame_pool_config_t pool_config =
+    {
+        .frame_count    = MQTT_FRAME_POOL_DEFAULT_COUNT,
+        .memory         = NULL,
+        .heap_fallback  = ZOS_TRUE,
+    };
+
+    return mqtt_init_with_pool( mqtt_connection, &pool_config );
+}
+
+zos_result_t mqtt_init_with_pool( mqtt_connection_t* mqtt_connection, const mqtt_frame_pool_config_t *pool_config )
+{
+    zos_result_t ret;
+
+    ret = mqtt_pool_init( pool_config );
+    if ( ret != ZOS_SUCCESS )
+    {
+        return ret;
+    }
+
+    mqtt_connection->pool_init = ZOS_TRUE;
     mqtt_connection->session_init = ZOS_TRUE;
+    mqtt_connection->publish_window = 0;
+    mqtt_connection->publish_inflight = 0;
+    mqtt_connection->flush_pending = ZOS_FALSE;
+    mqtt_connection->socket.socket_handle = ZOS_INVALID_HANDLE;
+    mqtt_connection->router.root = NULL;
+    mqtt_connection->router.dispatching = 0;
+    mqtt_connection->router.removed = ZOS_FALSE;
+    mqtt_connection->store = NULL;
     return ZOS_SUCCESS;
 }
 
 zos_result_t mqtt_deinit( mqtt_connection_t* mqtt_connection )
 {
     mqtt_network_close( mqtt_connection );
+    if ( mqtt_connection->pool_init == ZOS_TRUE )
+    {
+        mqtt_pool_deinit( );
+        mqtt_connection->pool_init = ZOS_FALSE;
+        mqtt_router_deinit( &mqtt_connection->router );
+        mqtt_store_deinit( mqtt_connection );
+    }
     mqtt_connection->session_init = ZOS_FALSE;
     return ZOS_SUCCESS;
 }
 
+zos_result_t mqtt_get_frame_pool_stats( mqtt_frame_pool_stats_t *stats )
+{
+    return mqtt_pool_get_stats( stats );
+}
+
+zos_result_t mqtt_topic_handler_add( mqtt_connection_t* mqtt_connection, const char *filter, mqtt_topic_handler_t handler, void *arg )
+{
+    return mqtt_router_add( &mqtt_connection->router, filter, handler, arg );
+}
+
+zos_result_t mqtt_topic_handler_remove( mqtt_connection_t* mqtt_connection, const char *filter, mqtt_topic_handler_t handler )
+{
+    return mqtt_router_remove( &mqtt_connection->router, filter, handler );
+}
+
 zos_result_t mqtt_open( mqtt_connection_t* mqtt_connection, const char *address, uint16_t port_number, zos_interface_t interface, mqtt_callback_t callback, zos_bool_t security )
 {
     if ( port_number == 0 )
@@ -111,17 +163,19 @@ zos_result_t mqtt_connect( mqtt_connection_t* mqtt_connection, mqtt_pkt_connect_
 
     if ( args.clean_session == 1 )
     {
-        mqtt_session_init( &session );
+        mqtt_session_init( &mqtt_connection->session_data );
+        mqtt_connection->publish_inflight = 0;
     }
     else
     {
         if ( mqtt_connection->session_init == ZOS_TRUE )
         {
-            mqtt_session_init( &session );
+            mqtt_session_init( &mqtt_connection->session_data );
+            mqtt_connection->publish_inflight = 0;
         }
         mqtt_connection->session_init = ZOS_FALSE;
     }
-    mqtt_connection->session = &session;
+    mqtt_connection->session = &mqtt_connection->session_data;
 
     current_event.send_context.event_t = MQTT_EVENT_SEND_CONNECT;
     current_event.send_context.conn = mqtt_connection;
@@ -147,6 +201,11 @@ mqtt_msgid_t mqtt_subscribe( mqtt_connection_t* mqtt_connection, uint8_t *topic,
     mqtt_event_message_t current_event;
     mqtt_subscribe_arg_t args;
 
+    if ( mqtt_connection->socket.tx_stream > 0 )
+    {
+        return 0;
+    }
+
     args.topic_filter.str = topic;
     args.topic_filter.len = (uint16_t) strlen( (char*) topic );
     args.qos = qos;
@@ -169,6 +228,11 @@ mqtt_msgid_t mqtt_unsubscribe( mqtt_connection_t* mqtt_connection, uint8_t *topi
     mqtt_event_message_t current_event;
     mqtt_unsubscribe_arg_t args;
 
+    if ( mqtt_connection->socket.tx_stream > 0 )
+    {
+        return 0;
+    }
+
     args.topic_filter.str = topic;
     args.topic_filter.len = (uint16_t) ( strlen( (char*) topic ) );
     args.packet_id = ( ++mqtt_connection->packet_id );
@@ -189,6 +253,18 @@ mqtt_msgid_t mqtt_publish( mqtt_connection_t* mqtt_connection, uint8_t *topic, u
 {
     mqtt_event_message_t current_event;
     mqtt_publish_arg_t args;
+
+    if ( ( qos != MQTT_QOS_DELIVER_AT_MOST_ONCE ) && ( mqtt_get_publish_window_free( mqtt_connection ) == 0 ) )
+    {
+        /* Window full, the caller retries after an MQTT_EVENT_TYPE_PUBLISHED event */
+        return 0;
+    }
+    if ( mqtt_connection->socket.tx_stream > 0 )
+    {
+        /* The payload of a streamed publish hasn't been written completely */
+        return 0;
+    }
+
     args.topic.str = topic;
     args.topic.len = (uint16_t) strlen( (char*) topic );
     args.data = data;
@@ -209,3 +285,58 @@ mqtt_msgid_t mqtt_publish( mqtt_connection_t* mqtt_connection, uint8_t *topic, u
     }
     return args.packet_id;
 }
+
+mqtt_msgid_t mqtt_publish_start( mqtt_connection_t* mqtt_connection, uint8_t *topic, uint32_t msg_len, uint8_t qos )
+{
+    if ( msg_len == 0 )
+    {
+        return 0;
+    }
+
+    /* Without payload only the header is sent, the payload follows with mqtt_publish_write() */
+    return mqtt_publish( mqtt_connection, topic, NULL, msg_len, qos );
+}
+
+zos_result_t mqtt_publish_write( mqtt_connection_t* mqtt_connection, const uint8_t *data, uint32_t data_len )
+{
+    return mqtt_network_send_stream( data, data_len, mqtt_connection );
+}
+
+zos_result_t mqtt_set_publish_window( mqtt_connection_t* mqtt_connection, uint16_t window )
+{
+    /* Every in-flight publish must fit the session for retransmission */
+    mqtt_connection->publish_window = ( window > MQTT_QUEUE_SIZE ) ? MQTT_QUEUE_SIZE : window;
+    return ZOS_SUCCESS;
+}
+
+uint16_t mqtt_get_publish_window_free( mqtt_connection_t* mqtt_connection )
+{
+    /* Without a window the session still bounds the un-acked publishes */
+    uint16_t window = ( mqtt_connection->publish_window != 0 ) ? mqtt_connection->publish_window : MQTT_QUEUE_SIZE;
+
+    if ( mqtt_connection->publish_inflight >= window )
+    {
+        return 0;
+    }
+    return (uint16_t) ( window - mqtt_connection->publish_inflight );
+}
+
+zos_result_t mqtt_store_enable( mqtt_connection_t* mqtt_connection, const mqtt_store_config_t *config )
+{
+    return mqtt_store_init( config, mqtt_connection );
+}
+
+zos_result_t mqtt_store_disable( mqtt_connection_t* mqtt_connection )
+{
+    return mqtt_store_deinit( mqtt_connection );
+}
+
+zos_result_t mqtt_store_commit( mqtt_connection_t* mqtt_connection )
+{
+    return mqtt_store_flush( mqtt_connection );
+}
+
+zos_result_t mqtt_publish_stored( mqtt_connection_t* mqtt_connection, uint8_t *topic, uint8_t *data, uint32_t data_len, uint8_t qos )
+{
+    return mqtt_store_append( topic, (uint16_t) strlen( (char*) topic ), data, data_len, qos, mqtt_connection );
+}
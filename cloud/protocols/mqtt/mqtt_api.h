@@ -36,10 +36,26 @@ extern "C" {
  *                                Application has to allocate it non stack memory area. And application has to free it after use
  * @return @ref zos_result_t
  * NOTE :  The mqtt_connection memory here can be freed or reused by application after calling mqtt_deinit()
+ * NOTE :  Each mqtt_connection is independent, up to MQTT_MAX_CONNECTIONS of them can be open at the same time.
+ *         mqtt_event_info_t.connection tells the callback which one an event belongs to
  *
  */
 zos_result_t mqtt_init( mqtt_connection_t* mqtt_connection );
 
+/** Initializes MQTT object with a specific frame buffer pool
+ *
+ * Frames sent and received by the library are taken from a pool of fixed size buffers
+ * instead of being allocated from the heap for every message. The pool is shared by all
+ * connections and is configured by the first one initialized, @ref mqtt_init() uses
+ * MQTT_FRAME_POOL_DEFAULT_COUNT frames with heap fallback enabled.
+ *
+ * @param[in] mqtt_connection   : Contains address of a memory location, having size of MQTT_OBJECT_MEMORY_SIZE_REQUIREMENT bytes
+ * @param[in] pool_config       : Frame pool configuration. pool_config->memory, if given, must be pointer aligned
+ *                                and stay valid until the last connection is de-initialized
+ * @return @ref zos_result_t
+ */
+zos_result_t mqtt_init_with_pool( mqtt_connection_t* mqtt_connection, const mqtt_frame_pool_config_t *pool_config );
+
 
 /** De-initializes MQTT object
  *
@@ -49,6 +65,36 @@ zos_result_t mqtt_init( mqtt_connection_t* mqtt_connection );
  */
 zos_result_t mqtt_deinit( mqtt_connection_t* mqtt_connection );
 
+/** Retrieves frame buffer pool statistics
+ * @param[out] stats            : Pool usage, including the high watermark of frames in use
+ * @return @ref zos_result_t
+ */
+zos_result_t mqtt_get_frame_pool_stats( mqtt_frame_pool_stats_t *stats );
+
+/** Routes messages received on topics matching a filter to a handler
+ *
+ * Filters may contain the '+' and '#' wildcards and are matched level by level, so the
+ * cost of routing a message depends on the depth of its topic rather than on the number
+ * of handlers. Every matching handler is called, messages no handler matches are passed
+ * to the connection callback as MQTT_EVENT_TYPE_PUBLISH_MSG_RECEIVED events.
+ * NOTE: This only routes received messages, subscribing is still done with mqtt_subscribe()
+ *
+ * @param[in] mqtt_connection   : Contains address of a memory location which is passed during MQTT init
+ * @param[in] filter            : Topic filter, e.g. "devices/+/cmd/#"
+ * @param[in] handler           : Handler for matching messages
+ * @param[in] arg               : Argument passed to the handler
+ * @return @ref zos_result_t
+ */
+zos_result_t mqtt_topic_handler_add( mqtt_connection_t* mqtt_connection, const char *filter, mqtt_topic_handler_t handler, void *arg );
+
+/** Removes a handler added with mqtt_topic_handler_add()
+ * @param[in] mqtt_connection   : Contains address of a memory location which is passed during MQTT init
+ * @param[in] filter            : Topic filter the handler was added for
+ * @param[in] handler           : Handler to remove
+ * @return @ref zos_result_t
+ */
+zos_result_t mqtt_topic_handler_remove( mqtt_connection_t* mqtt_connection, const char *filter, mqtt_topic_handler_t handler );
+
 /** Opens a TCP/TLS connection with MQTT broker.
  *
  *
@@ -115,6 +161,45 @@ zos_result_t mqtt_disconnect( mqtt_connection_t* mqtt_connection );
 mqtt_msgid_t mqtt_publish( mqtt_connection_t* mqtt_connection, uint8_t *topic, uint8_t *message, uint32_t msg_len, uint8_t qos );
 
 
+/** Starts publishing a message whose payload is written in chunks
+ *
+ * Sends the PUBLISH header for a payload of 'msg_len' bytes, which then has to be written
+ * with mqtt_publish_write(). The payload is never held in a frame buffer, so it is not
+ * limited by MQTT_CONNECTION_FRAME_MAX.
+ *
+ * NOTE:
+ *      Until all 'msg_len' bytes are written nothing else can be sent on the connection:
+ *      mqtt_publish(), mqtt_subscribe() and mqtt_unsubscribe() return 0, received messages
+ *      are left unread and the keep alive is suspended. mqtt_disconnect() drops the
+ *      connection without sending DISCONNECT.
+ *      For QoS 0 the MQTT_EVENT_TYPE_PUBLISHED event is sent once the header is written.
+ *      For QoS 1 and 2 the message is not retransmitted: if the connection is lost before
+ *      the broker acknowledges it, it is dropped from the session when resuming and no
+ *      MQTT_EVENT_TYPE_PUBLISHED event follows.
+ *
+ * @param[in] mqtt_connection   : Contains address of a memory location which is passed during MQTT init
+ * @param[in] topic             : Contains the topic on which the message to be published
+ * @param[in] msg_len           : Total length of the message, must not be 0
+ * @param[in] qos               : QoS level to be used for publishing the given message
+ *
+ * @return mqtt_msgid_t   : ID for the message being published, 0 on failure
+ */
+mqtt_msgid_t mqtt_publish_start( mqtt_connection_t* mqtt_connection, uint8_t *topic, uint32_t msg_len, uint8_t qos );
+
+/** Writes the next chunk of a message started with mqtt_publish_start()
+ *
+ * The data is copied to the network stack before returning. The message is flushed
+ * when its last byte has been written.
+ *
+ * @param[in] mqtt_connection   : Contains address of a memory location which is passed during MQTT init
+ * @param[in] data              : Next chunk of the payload
+ * @param[in] data_len          : Length of the chunk, at most the number of payload bytes still to be written
+ *
+ * @return @ref zos_result_t, ZOS_INVALID_ARG if no message is started or 'data_len' is too large
+ */
+zos_result_t mqtt_publish_write( mqtt_connection_t* mqtt_connection, const uint8_t *data, uint32_t data_len );
+
+
 /** Subscribe for a topic with MQTT Broker
  *
  * NOTE:
@@ -149,6 +234,69 @@ mqtt_msgid_t mqtt_subscribe( mqtt_connection_t* mqtt_connection, uint8_t *topic,
  */
 mqtt_msgid_t mqtt_unsubscribe( mqtt_connection_t* mqtt_connection, uint8_t *topic );
 
+/** Enables pipelined publishing with a window of un-acked QoS1/QoS2 messages
+ *
+ * Up to 'window' QoS1/QoS2 publishes may wait for their PUBACK/PUBCOMP at the same time.
+ * Publishes issued back-to-back from the same event are coalesced into a single TCP write,
+ * which is flushed when the window fills or once the current event has been handled.
+ * While the window is full, mqtt_publish() of a QoS1/QoS2 message returns 0, an
+ * MQTT_EVENT_TYPE_PUBLISHED event means a slot has been freed.
+ *
+ * @param[in] mqtt_connection   : Contains address of a memory location which is passed during MQTT init
+ * @param[in] window            : Maximum number of un-acked publishes, capped to MQTT_QUEUE_SIZE.
+ *                                0 (default) sends every publish on its own, with up to
+ *                                MQTT_QUEUE_SIZE of them un-acked
+ * @return @ref zos_result_t
+ */
+zos_result_t mqtt_set_publish_window( mqtt_connection_t* mqtt_connection, uint16_t window );
+
+/** Returns how many QoS1/QoS2 messages can be published before the window is full
+ * @param[in] mqtt_connection   : Contains address of a memory location which is passed during MQTT init
+ * @return Free window slots, counted against MQTT_QUEUE_SIZE if no window is configured
+ */
+uint16_t mqtt_get_publish_window_free( mqtt_connection_t* mqtt_connection );
+
+/** Enables the persistent outbound queue of a connection
+ *
+ * Messages published with mqtt_publish_stored() are appended to a log of segment files
+ * and survive connection loss and reboots. Segments already in the file system are
+ * picked up again, so enabling the queue after a reboot resumes where it stopped.
+ * NOTE: Delivery is at least once, messages not acknowledged before a connection
+ *       loss are published again after reconnecting
+ *
+ * @param[in] mqtt_connection   : Contains address of a memory location which is passed during MQTT init
+ * @param[in] config            : Queue configuration, two buffers of config->segment_size bytes are allocated
+ * @return @ref zos_result_t
+ */
+zos_result_t mqtt_store_enable( mqtt_connection_t* mqtt_connection, const mqtt_store_config_t *config );
+
+/** Commits pending messages and disables the persistent outbound queue
+ * @param[in] mqtt_connection   : Contains address of a memory location which is passed during MQTT init
+ * @return @ref zos_result_t
+ */
+zos_result_t mqtt_store_disable( mqtt_connection_t* mqtt_connection );
+
+/** Commits the messages batched in RAM to a segment file now
+ * @param[in] mqtt_connection   : Contains address of a memory location which is passed during MQTT init
+ * @return @ref zos_result_t
+ */
+zos_result_t mqtt_store_commit( mqtt_connection_t* mqtt_connection );
+
+/** Queues a message for publishing through the persistent outbound queue
+ *
+ * Topic and data are copied, they can be reused once the function returns.
+ * Messages are committed to the file system in batches and published in order
+ * once the connection is up, at the rate given by the queue configuration.
+ *
+ * @param[in] mqtt_connection   : Contains address of a memory location which is passed during MQTT init
+ * @param[in] topic             : Contains the topic on which the message to be published
+ * @param[in] data              : Pointer to the message to be published
+ * @param[in] data_len          : Length of the message pointed by 'data' pointer
+ * @param[in] qos               : QoS level to be used for publishing the given message
+ * @return @ref zos_result_t, ZOS_NO_MEM if the queue is full
+ */
+zos_result_t mqtt_publish_stored( mqtt_connection_t* mqtt_connection, uint8_t *topic, uint8_t *data, uint32_t data_len, uint8_t qos );
+
 /**
  * @}
  */
@@ -34,6 +34,12 @@ extern "C" {
 #define MQTT_PROTOCOL_VER3                        (3)             /* Mqtt protocol version 3 */
 #define MQTT_CONNECTION_TIMEOUT                   (5000)          /* Tcp connection timeout */
 #define MQTT_CONNECTION_NUMBER_OF_RETRIES         (3)             /* Tcp connection retries */
+#ifndef MQTT_MAX_CONNECTIONS
+#define MQTT_MAX_CONNECTIONS                      (4)             /* Broker connections that can be open at the same time */
+#endif
+#define MQTT_STORE_MAX_SEGMENTS                   (64)            /* Maximum segment files of the persistent outbound queue */
+#define MQTT_FRAME_POOL_FRAME_SIZE                (4 * 1024)      /* Size of one frame pool buffer */
+#define MQTT_FRAME_POOL_DEFAULT_COUNT             (2)             /* Frames in the pool created by mqtt_init() */
 /******************************************************
  *                  typedef Enumerations
  ******************************************************/
@@ -58,7 +64,8 @@ typedef enum mqtt_event_s
     MQTT_EVENT_TYPE_PUBLISHED,                            /* Event sent for QOS-1 and QOS-2 for the published when successfully delivered. No event will be sent for QOS-0. */
     MQTT_EVENT_TYPE_SUBCRIBED,                            /* Event sent when broker accepts SUBSCRIBED request */
     MQTT_EVENT_TYPE_UNSUBSCRIBED,                         /* Event sent when broker accepts UNSUBSCRIBED request */
-    MQTT_EVENT_TYPE_PUBLISH_MSG_RECEIVED,                 /* Event sent when PUBLISH message is received from the broker for a subscribed topic */
+    MQTT_EVENT_TYPE_PUBLISH_MSG_RECEIVED,                 /* Event sent when PUBLISH message is received from the broker for a subscribed topic,
+                                                             once per chunk for messages larger than the receive buffer */
     MQTT_EVENT_TYPE_UNKNOWN                               /* Event type not known */
 } mqtt_event_type_t;
 
@@ -91,13 +98,17 @@ typedef struct mqtt_topic_msg_s
 {
     uint8_t*    topic;                                          /* Name of the topic associated with the message. It's not 'null' terminated */
     uint32_t    topic_len;                                      /* Length of the topic */
-    uint8_t*    data;                                           /* Payload of the message */
-    uint32_t    data_len;                                       /* Length of the message payload */
+    uint8_t*    data;                                           /* Payload of the message, or the current chunk of it */
+    uint32_t    data_len;                                       /* Length of data */
+    uint32_t    offset;                                         /* Position of data in the payload, 0 unless the message is delivered in chunks */
+    uint32_t    total_len;                                      /* Length of the whole payload. Messages larger than MQTT_CONNECTION_FRAME_MAX are
+                                                                   delivered in chunks, the last one has offset + data_len == total_len */
 } mqtt_topic_msg_t;
 
 /* MQTT Event info */
 typedef struct mqtt_event_info_s
 {
+    void*                         connection;             /* The mqtt_connection_t the event belongs to */
     mqtt_event_type_t             type;                   /* Message event type */
     union
     {
@@ -120,6 +131,57 @@ typedef struct mqtt_pkt_connect_s
     uint8_t*    password;                                       /* Password to connect to Broker */
 } mqtt_pkt_connect_t;
 
+/**
+ * Frame buffer pool configuration, see @ref mqtt_init_with_pool()
+ *
+ * Every pool frame holds MQTT_FRAME_POOL_FRAME_SIZE bytes. Each open connection
+ * keeps one frame as its receive buffer and borrows one while sending a frame.
+ */
+typedef struct mqtt_frame_pool_config_s
+{
+    uint16_t    frame_count;                                    /* Number of frames in the pool */
+    uint8_t*    memory;                                         /* frame_count * MQTT_FRAME_POOL_FRAME_SIZE bytes for the pool, or NULL to allocate them once at init */
+    zos_bool_t  heap_fallback;                                  /* Allocate from the heap when the pool is exhausted instead of failing */
+} mqtt_frame_pool_config_t;
+
+/**
+ * Frame buffer pool statistics
+ */
+typedef struct mqtt_frame_pool_stats_s
+{
+    uint16_t    frame_count;                                    /* Number of frames in the pool */
+    uint16_t    in_use;                                         /* Frames currently acquired */
+    uint16_t    high_watermark;                                 /* Most frames ever acquired at the same time */
+    uint32_t    heap_allocations;                               /* Buffers served from the heap because the pool was exhausted */
+    uint32_t    failures;                                       /* Buffer requests that could not be served */
+} mqtt_frame_pool_stats_t;
+
+/**
+ * Persistent outbound queue configuration, see @ref mqtt_store_enable()
+ *
+ * Messages are batched in RAM and committed to the file system one segment file
+ * per batch. Segment files are named "<name>.<n>", n = 0 .. segment_count - 1.
+ */
+typedef struct mqtt_store_config_s
+{
+    const char* name;                                           /* File name prefix of the segment files, at most 24 characters */
+    uint16_t    segment_count;                                  /* Segments the queue may hold, at most MQTT_STORE_MAX_SEGMENTS */
+    uint32_t    segment_size;                                   /* Bytes of one segment, the largest batch committed at once */
+    uint32_t    commit_period_ms;                               /* Maximum time a message stays in RAM before being committed */
+    uint32_t    replay_period_ms;                               /* Interval of the replay after reconnecting */
+    uint16_t    replay_count;                                   /* Messages published per replay interval */
+} mqtt_store_config_t;
+
+/** Handler for messages received on topics matching a filter, see mqtt_topic_handler_add()
+ *
+ * @param[in] connection        : The mqtt_connection_t the message was received on
+ * @param[in] msg               : Received message, only valid during the call
+ * @param[in] arg               : Argument given when the handler was added
+ *
+ * @return @ref zos_result_t
+ */
+typedef zos_result_t (*mqtt_topic_handler_t)( void *connection, mqtt_topic_msg_t *msg, void *arg );
+
 /** Call-back function for MQTT events
  *
  * @param[in] event             : Pointer to event structure which contains the details about the event
@@ -98,7 +98,10 @@ zos_result_t mqtt_backend_put_connect( const mqtt_connect_arg_t *args, mqtt_conn
 zos_result_t mqtt_backend_get_connack( mqtt_connack_arg_t *args, mqtt_connection_t *conn )
 {
     zos_result_t ret = ZOS_SUCCESS;
-    UNUSED_PARAMETER(args);
+    if ( args->return_code == MQTT_RETURN_CODE_ACCEPTED )
+    {
+        ret = mqtt_manager( MQTT_EVENT_RECV_CONNACK, args, conn );
+    }
     if ( ret == ZOS_SUCCESS )
     {
         /* Publish is an async method (we don't get an OK), so we simulate the OK after sending it */
@@ -109,6 +112,7 @@ zos_result_t mqtt_backend_get_connack( mqtt_connack_arg_t *args, mqtt_connection
             mqtt_event_info_t event;
             event.type = MQTT_EVENT_TYPE_CONNECTED;
             event.data.err_code = args->return_code;
+            event.connection = conn;
             conn->callback( &event );
         }
     }
@@ -118,23 +122,24 @@ zos_result_t mqtt_backend_get_connack( mqtt_connack_arg_t *args, mqtt_connection
 zos_result_t mqtt_backend_put_publish( const mqtt_publish_arg_t *args, mqtt_connection_t *conn )
 {
     zos_result_t ret;
-    mqtt_frame_t frame;
-    mqtt_publish_arg_t final_args;
-    memcpy(&final_args, args, sizeof(mqtt_publish_arg_t));
+    /* In pipelined mode publishes are coalesced until the window fills or the current event ends.
+     * This publish is counted in flight only once sent, so the one filling the window is flushed. */
+    zos_bool_t coalesce = ( conn->publish_window != 0 ) && ( conn->publish_inflight + 1 < conn->publish_window );
 
-    /* Send Protocol Header */
-    ret = mqtt_frame_create( MQTT_CONNECTION_FRAME_MAX, &frame, &conn->socket );
-    if ( ret != ZOS_SUCCESS )
+    if ( ( args->data == NULL ) && ( args->data_len > 0 ) )
     {
-        return ret;
+        /* Streamed payload, the frame is flushed with its last chunk */
+        MQTT_LOG("Send PUBLISH header");
+        return mqtt_frame_send_publish( args, ZOS_FALSE, &conn->socket );
     }
-    mqtt_frame_put_publish( &frame, &final_args );
 
+    /* Topic and payload are written from the caller's memory, no frame is allocated */
     MQTT_LOG("Send PUBLISH frame");
-    ret = mqtt_frame_send( &frame, &conn->socket );
-
-    /* delete packet as soon as sent */
-    mqtt_frame_delete(&frame);
+    ret = mqtt_frame_send_publish( args, ( coalesce == ZOS_TRUE ) ? ZOS_FALSE : ZOS_TRUE, &conn->socket );
+    if ( ( ret == ZOS_SUCCESS ) && ( coalesce == ZOS_TRUE ) )
+    {
+        ret = mqtt_network_flush_deferred( conn );
+    }
 
     return ret;
 }
@@ -146,20 +151,65 @@ zos_result_t mqtt_backend_get_publish( mqtt_publish_arg_t *args, mqtt_connection
     ret = mqtt_manager( MQTT_EVENT_RECV_PUBLISH, args, conn );
     if ( ( ret == ZOS_SUCCESS ) && ( args->data != NULL ) )
     {
-        /* Publish is an async method (we don't get an OK), so we simulate the OK after sending it */
-        if ( conn->callback != NULL )
+        event.data.pub_recvd.topic = args->topic.str;
+        event.data.pub_recvd.topic_len = args->topic.len;
+        event.data.pub_recvd.data = args->data;
+        event.data.pub_recvd.data_len = args->data_len;
+        event.data.pub_recvd.offset = 0;
+        event.data.pub_recvd.total_len = args->data_len;
+
+        /* Messages without a topic handler go to the connection callback */
+        if ( ( mqtt_router_dispatch( &conn->router, conn, &event.data.pub_recvd ) == 0 ) && ( conn->callback != NULL ) )
         {
             event.type = MQTT_EVENT_TYPE_PUBLISH_MSG_RECEIVED;
-            event.data.pub_recvd.topic = args->topic.str;
-            event.data.pub_recvd.topic_len = args->topic.len;
-            event.data.pub_recvd.data = args->data;
-            event.data.pub_recvd.data_len = args->data_len;
+            event.connection = conn;
             conn->callback( &event );
         }
     }
     return ret;
 }
 
+/*
+ * Passes on the next piece of a PUBLISH too large for the receive buffer.
+ * The message is acknowledged once its last piece has been handled.
+ */
+zos_result_t mqtt_backend_get_publish_chunk( mqtt_rx_stream_t *stream, uint8_t *data, uint32_t length, mqtt_connection_t *conn )
+{
+    mqtt_publish_arg_t *args = &stream->args;
+    mqtt_event_info_t event;
+
+    if ( stream->offset == 0 )
+    {
+        /* Same duplicate check the manager does for QoS 2 messages received whole */
+        stream->duplicate = ( ( args->qos == MQTT_QOS_DELIVER_EXACTLY_ONCE ) &&
+                              ( mqtt_session_item_exist( MQTT_PACKET_TYPE_PUBREC, args->packet_id, conn->session ) == ZOS_SUCCESS ) ) ? ZOS_TRUE : ZOS_FALSE;
+    }
+
+    if ( stream->duplicate == ZOS_FALSE )
+    {
+        event.data.pub_recvd.topic = args->topic.str;
+        event.data.pub_recvd.topic_len = args->topic.len;
+        event.data.pub_recvd.data = data;
+        event.data.pub_recvd.data_len = length;
+        event.data.pub_recvd.offset = stream->offset;
+        event.data.pub_recvd.total_len = args->data_len;
+
+        if ( ( mqtt_router_dispatch( &conn->router, conn, &event.data.pub_recvd ) == 0 ) && ( conn->callback != NULL ) )
+        {
+            event.type = MQTT_EVENT_TYPE_PUBLISH_MSG_RECEIVED;
+            event.connection = conn;
+            conn->callback( &event );
+        }
+    }
+
+    stream->offset += length;
+    if ( stream->offset < args->data_len )
+    {
+        return ZOS_SUCCESS;
+    }
+    return mqtt_manager( MQTT_EVENT_RECV_PUBLISH, args, conn );
+}
+
 zos_result_t mqtt_backend_put_puback( const mqtt_puback_arg_t *args, mqtt_connection_t *conn )
 {
     zos_result_t ret;
@@ -193,6 +243,7 @@ zos_result_t mqtt_backend_get_puback( mqtt_puback_arg_t *args, mqtt_connection_t
             mqtt_event_info_t event;
             event.type = MQTT_EVENT_TYPE_PUBLISHED;
             event.data.msgid = args->packet_id;
+            event.connection = conn;
             conn->callback( &event );
         }
     }
@@ -233,6 +284,7 @@ zos_result_t mqtt_backend_get_pubrec( mqtt_pubrec_arg_t *args, mqtt_connection_t
             mqtt_event_info_t event;
             event.type = MQTT_EVENT_TYPE_UNKNOWN;
             event.data.msgid = args->packet_id;
+            event.connection = conn;
             conn->callback( &event );
         }
 
@@ -273,6 +325,7 @@ zos_result_t mqtt_backend_get_pubrel( mqtt_pubrel_arg_t *args, mqtt_connection_t
             mqtt_event_info_t event;
             event.type = MQTT_EVENT_TYPE_UNKNOWN;
             event.data.msgid = args->packet_id;
+            event.connection = conn;
             conn->callback( &event );
         }
 
@@ -314,6 +367,7 @@ zos_result_t mqtt_backend_get_pubcomp( mqtt_pubcomp_arg_t *args, mqtt_connection
             mqtt_event_info_t event;
             event.type = MQTT_EVENT_TYPE_PUBLISHED;
             event.data.msgid = args->packet_id;
+            event.connection = conn;
             conn->callback( &event );
         }
 
@@ -359,6 +413,7 @@ zos_result_t mqtt_backend_get_suback( mqtt_suback_arg_t *args, mqtt_connection_t
             mqtt_event_info_t event;
             event.type = MQTT_EVENT_TYPE_SUBCRIBED;
             event.data.msgid = args->packet_id;
+            event.connection = conn;
             conn->callback( &event );
         }
 
@@ -371,7 +426,7 @@ zos_result_t mqtt_backend_put_unsubscribe( const mqtt_unsubscribe_arg_t *args, m
     zos_result_t ret;
     mqtt_frame_t frame;
     mqtt_unsubscribe_arg_t final_args;
-    memcpy(&final_args, args, sizeof(mqtt_subscribe_arg_t));
+    memcpy(&final_args, args, sizeof(mqtt_unsubscribe_arg_t));
 
     /* Generate packet ID */
     // final_args.packet_id = conn->packet_id++;
@@ -407,6 +462,8 @@ zos_result_t mqtt_backend_get_unsuback( mqtt_unsuback_arg_t *args, mqtt_connecti
             event.type = MQTT_EVENT_TYPE_UNSUBSCRIBED;
             event.data.msgid = args->packet_id;
 
+            event.connection = conn;
+
             conn->callback( &event );
         }
     }
@@ -447,6 +504,7 @@ zos_result_t mqtt_backend_connection_close( mqtt_connection_t *conn )
 
             mqtt_event_info_t event;
             event.type = MQTT_EVENT_TYPE_DISCONNECTED;
+            event.connection = conn;
             conn->callback( &event );
         }
     }
@@ -65,6 +65,7 @@ zos_result_t mqtt_backend_put_connect                     ( const mqtt_connect_a
 zos_result_t mqtt_backend_get_connack                     (       mqtt_connack_arg_t     *args, mqtt_connection_t *conn );
 zos_result_t mqtt_backend_put_publish                     ( const mqtt_publish_arg_t     *args, mqtt_connection_t *conn );
 zos_result_t mqtt_backend_get_publish                     (       mqtt_publish_arg_t     *args, mqtt_connection_t *conn );
+zos_result_t mqtt_backend_get_publish_chunk               (       mqtt_rx_stream_t       *stream, uint8_t *data, uint32_t length, mqtt_connection_t *conn );
 zos_result_t mqtt_backend_get_puback                      (       mqtt_puback_arg_t      *args, mqtt_connection_t *conn );
 zos_result_t mqtt_backend_put_puback                      ( const mqtt_puback_arg_t      *args, mqtt_connection_t *conn );
 zos_result_t mqtt_backend_put_subscribe                   ( const mqtt_subscribe_arg_t   *args, mqtt_connection_t *conn );
@@ -480,26 +480,87 @@ zos_result_t mqtt_frame_get_connack( mqtt_frame_t *frame, mqtt_connack_arg_t *ar
     return ZOS_SUCCESS;
 }
 
-zos_result_t mqtt_frame_put_publish( mqtt_frame_t *frame, const mqtt_publish_arg_t *args )
+/* Sends a PUBLISH without copying topic or payload, only the headers are serialized */
+zos_result_t mqtt_frame_send_publish( const mqtt_publish_arg_t *args, zos_bool_t flush, mqtt_socket_t *socket )
 {
-    uint32_t    size = ( uint32_t ) ( args->qos == MQTT_QOS_DELIVER_AT_MOST_ONCE ? 0 : 2)   /* Packet identifier  */
-                       + ( uint32_t ) ( args->topic.len + sizeof(args->topic.len))          /* will topic if sent */
-                       + ( uint32_t ) args->data_len;                                       /* size of message    */
-
-    /* A long value carrying string MQTT */
-    MQTT_BUFFER_PUT_BIT( &frame->buffer, args->retain, 0, 0 );
-    MQTT_BUFFER_PUT_2BIT( &frame->buffer, args->qos, 1, 0 );
-    MQTT_BUFFER_PUT_BIT( &frame->buffer, args->dup, 3, 0 );
-    MQTT_BUFFER_PUT_4BIT( &frame->buffer, MQTT_PACKET_TYPE_PUBLISH, 4, 1 );
-    MQTT_BUFFER_PUT_VARIABLE_LENGTH( &frame->buffer, size, frame->size );
-    MQTT_BUFFER_PUT_STRING( &frame->buffer, args->topic.str, args->topic.len );
+    uint8_t       header[1 + 4 + 2] = { 0 };  /* type-flags + remaining length + topic length */
+    uint8_t       packet_id[2];
+    mqtt_frame_t  frame;
+    mqtt_buffer_t packet_id_buffer = { packet_id };
+    mqtt_iovec_t  iovec[4];
+    uint32_t      count = 0;
+    zos_result_t  result;
+    uint32_t      size = ( uint32_t ) ( args->qos == MQTT_QOS_DELIVER_AT_MOST_ONCE ? 0 : 2)   /* Packet identifier  */
+                         + ( uint32_t ) ( args->topic.len + sizeof(args->topic.len))          /* topic              */
+                         + ( uint32_t ) args->data_len;                                       /* size of message    */
+
+    frame.size = 0;
+    frame.start = header;
+    frame.buffer.data = header;
+
+    MQTT_BUFFER_PUT_BIT( &frame.buffer, args->retain, 0, 0 );
+    MQTT_BUFFER_PUT_2BIT( &frame.buffer, args->qos, 1, 0 );
+    MQTT_BUFFER_PUT_BIT( &frame.buffer, args->dup, 3, 0 );
+    MQTT_BUFFER_PUT_4BIT( &frame.buffer, MQTT_PACKET_TYPE_PUBLISH, 4, 1 );
+    MQTT_BUFFER_PUT_VARIABLE_LENGTH( &frame.buffer, size, frame.size );
+    MQTT_BUFFER_PUT_SHORT( &frame.buffer, args->topic.len );
+
+    iovec[count].data = header;
+    iovec[count++].size = (uint32_t) ( frame.buffer.data - header );
+    iovec[count].data = args->topic.str;
+    iovec[count++].size = args->topic.len;
     if ( args->qos != MQTT_QOS_DELIVER_AT_MOST_ONCE )
     {
-        MQTT_BUFFER_PUT_SHORT( &frame->buffer, args->packet_id );
+        MQTT_BUFFER_PUT_SHORT( &packet_id_buffer, args->packet_id );
+        iovec[count].data = packet_id;
+        iovec[count++].size = sizeof(packet_id);
     }
-    memcpy( frame->buffer.data, args->data, args->data_len );
-    frame->buffer.data += args->data_len;
-    return ZOS_SUCCESS;
+    if ( args->data != NULL )
+    {
+        iovec[count].data = args->data;
+        iovec[count++].size = args->data_len;
+    }
+
+    result = mqtt_network_send_iovec( iovec, count, flush, socket );
+    if ( ( result == ZOS_SUCCESS ) && ( args->data == NULL ) )
+    {
+        /* Header only, the payload follows through mqtt_network_send_stream() */
+        socket->tx_stream = args->data_len;
+    }
+    return result;
+}
+
+/*
+ * Parses the header of a PUBLISH frame without needing its payload. header_size is the
+ * size of the fixed and variable headers, 0 while not even the topic length has arrived.
+ * Returns ZOS_PENDING until the whole header is within length.
+ */
+zos_result_t mqtt_frame_get_publish_header( uint8_t *data, uint32_t length, mqtt_publish_arg_t *args, uint32_t *header_size )
+{
+    mqtt_frame_t frame;
+    uint32_t     i = 1;
+
+    *header_size = 0;
+
+    /* Remaining length octets */
+    while ( ( i < length ) && ( i < 4 ) && ( ( data[i] & 0x80 ) != 0 ) )
+    {
+        i++;
+    }
+    if ( i + 3 > length )
+    {
+        return ZOS_PENDING;
+    }
+
+    *header_size = i + 1 + 2 + ( ( (uint32_t) data[i + 1] << 8 ) | data[i + 2] ) + ( ( ( data[0] >> 1 ) & 0x03 ) != 0 ? 2 : 0 );
+    if ( *header_size > length )
+    {
+        return ZOS_PENDING;
+    }
+
+    frame.start = data;
+    frame.buffer.data = data;
+    return mqtt_frame_get_publish( &frame, args );
 }
 
 zos_result_t mqtt_frame_get_publish( mqtt_frame_t *frame, mqtt_publish_arg_t *args )
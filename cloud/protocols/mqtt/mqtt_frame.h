@@ -129,6 +129,12 @@ typedef struct mqtt_buffer_s
     uint8_t* data;
 }mqtt_buffer_t;
 
+typedef struct mqtt_iovec_s
+{
+    const uint8_t* data;
+    uint32_t       size;
+}mqtt_iovec_t;
+
 typedef long long mqtt_timestamp_t;
 
 typedef enum mqtt_frame_type_e
@@ -228,11 +234,30 @@ typedef struct mqtt_unsuback_arg_s
 } mqtt_unsuback_arg_t;
 
 
+typedef struct
+{
+    mqtt_publish_arg_t              args;       /* Header of the PUBLISH, topic points into the receive buffer and data_len is the whole payload */
+    uint32_t                        header;     /* Bytes at the start of the receive buffer holding the header, 0 when no PUBLISH is streamed */
+    uint32_t                        offset;     /* Payload bytes passed on so far */
+    zos_bool_t                      duplicate;  /* QoS 2 message that was delivered before, only acknowledged */
+}mqtt_rx_stream_t;
+
+typedef struct
+{
+    uint8_t                        *data;       /* Persistent receive buffer of MQTT_CONNECTION_FRAME_MAX bytes */
+    uint32_t                        length;     /* Bytes of incomplete frames held in data */
+    uint32_t                        discard;    /* Bytes still to drop of a frame larger than the buffer */
+    mqtt_rx_stream_t                stream;     /* PUBLISH larger than the buffer, passed on in chunks as it arrives */
+}mqtt_rx_buffer_t;
+
 typedef struct
 {
     uint32_t                        socket_handle;
     char                            server_ip_address[100];
     uint16_t                        portnumber;
+    mqtt_rx_buffer_t                rx;
+    uint32_t                        tx_stream;  /* Payload bytes still to be written of a PUBLISH sent in chunks */
+    uint32_t                        generation; /* Incremented on every close, a reconnect can get the same receive buffer back */
 }mqtt_socket_t;
 
 typedef mqtt_unsuback_arg_t mqtt_puback_arg_t;
@@ -268,10 +293,11 @@ zos_result_t  mqtt_frame_create( uint16_t max_size, mqtt_frame_t *frame, mqtt_so
 zos_result_t  mqtt_frame_send  ( mqtt_frame_t *frame, mqtt_socket_t *socket );
 zos_result_t  mqtt_frame_recv  ( mqtt_buffer_t *buffer, void *p_user );
 zos_result_t  mqtt_frame_delete( mqtt_frame_t *frame );
+zos_result_t  mqtt_frame_send_publish( const mqtt_publish_arg_t *args, zos_bool_t flush, mqtt_socket_t *socket );
+zos_result_t  mqtt_frame_get_publish_header( uint8_t *data, uint32_t length, mqtt_publish_arg_t *args, uint32_t *header_size );
 
 zos_result_t mqtt_frame_put_connect            ( mqtt_frame_t *frame, const mqtt_connect_arg_t     *args );
 zos_result_t mqtt_frame_get_connack            ( mqtt_frame_t *frame,       mqtt_connack_arg_t     *args );
-zos_result_t mqtt_frame_put_publish            ( mqtt_frame_t *frame, const mqtt_publish_arg_t     *args );
 zos_result_t mqtt_frame_get_publish            ( mqtt_frame_t *frame,       mqtt_publish_arg_t     *args );
 zos_result_t mqtt_frame_put_puback             ( mqtt_frame_t *frame, const mqtt_puback_arg_t      *args );
 zos_result_t mqtt_frame_get_puback             ( mqtt_frame_t *frame,       mqtt_puback_arg_t      *args );
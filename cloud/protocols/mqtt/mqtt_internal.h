@@ -17,6 +17,7 @@
 #include "mqtt_frame.h"
 #include "mqtt_network.h"
 #include "mqtt_session.h"
+#include "mqtt_router.h"
 
 
 #ifdef __cplusplus
@@ -27,7 +28,7 @@ extern "C" {
 /******************************************************
  *                    Macros
  ******************************************************/
-#define MQTT_CONNECTION_FRAME_MAX                     (4 * 1024)        /* Maximum frame size for a connection          */
+#define MQTT_CONNECTION_FRAME_MAX                     MQTT_FRAME_POOL_FRAME_SIZE /* Maximum frame size for a connection   */
 #define MQTT_CONNECTION_DATA_SIZE_MAX                 (MQTT_CONNECTION_FRAME_MAX - 8) /* Maximum size to put in a frame */
 
 /******************************************************
@@ -79,11 +80,18 @@ typedef struct mqtt_connection_s
 {
     uint8_t                         session_init;
     uint8_t                         net_init_ok;
+    uint8_t                         pool_init;
     uint16_t                        packet_id;
+    uint16_t                        publish_window;     /* Maximum un-acked QoS1/2 publishes, 0 for MQTT_QUEUE_SIZE and a flush per publish */
+    uint16_t                        publish_inflight;   /* QoS1/2 publishes waiting for PUBACK/PUBCOMP */
+    uint8_t                         flush_pending;      /* A deferred flush of coalesced writes is scheduled */
     mqtt_socket_t                   socket;
     mqtt_callback_t                 callback;
     mqtt_heartbeat_t                heartbeat;
     mqtt_session_t*                 session;
+    mqtt_session_t                  session_data;
+    mqtt_router_t                   router;             /* Topic filters with their own handlers */
+    struct mqtt_store_s*            store;              /* Persistent outbound queue, NULL if not enabled */
 } mqtt_connection_t;
 
 typedef struct mqtt_send_context_t
@@ -19,6 +19,7 @@
 #include "mqtt_connection.h"
 #include "mqtt_frame.h"
 #include "mqtt_manager.h"
+#include "mqtt_store.h"
 #include "mqtt_wrapper/mqtt_zentrios_wrapper.h"
 
 /******************************************************
@@ -50,7 +51,7 @@ inline static void mqtt_manager_heartbeat_send_reset( mqtt_heartbeat_t *heartbea
 inline static void mqtt_manager_heartbeat_recv_reset( mqtt_heartbeat_t *heartbeat );
 inline static zos_result_t mqtt_manager_heartbeat_send_step( mqtt_heartbeat_t *heartbeat );
 inline static zos_result_t mqtt_manager_heartbeat_recv_step( mqtt_heartbeat_t *heartbeat );
-static void mqtt_manager_heartbeat_deinit( mqtt_heartbeat_t *heartbeat );
+static void mqtt_manager_heartbeat_deinit( void *p_user, mqtt_heartbeat_t *heartbeat );
 
 /******************************************************
  *               Variable Definitions
@@ -73,6 +74,7 @@ static void mqtt_manager_tick( void* arg )
             mqtt_event_info_t event;
             event.type = MQTT_EVENT_TYPE_DISCONNECTED;
             event.data.err_code = MQTT_CONN_ERR_CODE_INVALID;
+            event.connection = conn;
             conn->callback( &event );
         }
     }
@@ -124,9 +126,10 @@ inline static zos_result_t mqtt_manager_heartbeat_recv_step( mqtt_heartbeat_t *h
     return ( heartbeat->recv_counter == 0 ) ? ZOS_ERROR : ZOS_SUCCESS;
 }
 
-static void mqtt_manager_heartbeat_deinit( mqtt_heartbeat_t *heartbeat )
+static void mqtt_manager_heartbeat_deinit( void *p_user, mqtt_heartbeat_t *heartbeat )
 {
-    mqtt_event_unregister( mqtt_manager_tick, NULL );
+    /* Only stop the timer of this connection */
+    mqtt_event_unregister( mqtt_manager_tick, p_user );
 }
 
 zos_result_t mqtt_manager( mqtt_event_t event, void *args, mqtt_connection_t *conn )
@@ -148,8 +151,13 @@ zos_result_t mqtt_manager( mqtt_event_t event, void *args, mqtt_connection_t *co
 
         case MQTT_EVENT_SEND_DISCONNECT:
         {
-            mqtt_manager_heartbeat_deinit( &conn->heartbeat );
-            if ( ( result = mqtt_backend_put_disconnect( conn ) ) == ZOS_SUCCESS )
+            mqtt_manager_heartbeat_deinit( conn, &conn->heartbeat );
+            if ( conn->socket.tx_stream > 0 )
+            {
+                /* A PUBLISH cut short can't be followed by DISCONNECT, drop the connection */
+                result = mqtt_backend_connection_close( conn );
+            }
+            else if ( ( result = mqtt_backend_put_disconnect( conn ) ) == ZOS_SUCCESS )
             {
                 mqtt_backend_connection_close( conn );
             }
@@ -175,23 +183,31 @@ zos_result_t mqtt_manager( mqtt_event_t event, void *args, mqtt_connection_t *co
         case MQTT_EVENT_SEND_PUBLISH:
         {
             mqtt_publish_arg_t *publish_args = (mqtt_publish_arg_t *) args;
-            mqtt_session_add_item( MQTT_PACKET_TYPE_PUBLISH, args, conn->session );
-            result = mqtt_backend_put_publish( args, conn );
-            if ( ( publish_args->qos != MQTT_QOS_DELIVER_AT_MOST_ONCE ) )
+            if ( publish_args->qos != MQTT_QOS_DELIVER_AT_MOST_ONCE )
             {
-                mqtt_manager_heartbeat_send_reset( &conn->heartbeat );
-            }
-
-            if ( publish_args->qos == MQTT_QOS_DELIVER_AT_MOST_ONCE )
-            {
-                if ( mqtt_session_remove_item( MQTT_PACKET_TYPE_PUBLISH, publish_args->packet_id, conn->session ) != ZOS_SUCCESS )
+                /* Tracked before it is sent, so an acknowledge can't arrive for an unknown packet */
+                if ( ( result = mqtt_session_add_item( MQTT_PACKET_TYPE_PUBLISH, args, conn->session ) ) != ZOS_SUCCESS )
+                {
+                    MQTT_LOG( "No session space for publish packet %d", publish_args->packet_id );
+                }
+                else if ( ( result = mqtt_backend_put_publish( args, conn ) ) != ZOS_SUCCESS )
+                {
+                    mqtt_session_remove_item( MQTT_PACKET_TYPE_PUBLISH, publish_args->packet_id, conn->session );
+                }
+                else
                 {
-                    MQTT_LOG( "Publish packet %d not in session queue", publish_args->packet_id );
+                    conn->publish_inflight++;
+                    mqtt_manager_heartbeat_send_reset( &conn->heartbeat );
                 }
+            }
+            else
+            {
+                result = mqtt_backend_put_publish( args, conn );
                 if ( ( result == ZOS_SUCCESS ) & ( conn->callback != NULL ) )
                 {
                     mqtt_event_info_t callback_event;
                     callback_event.type = MQTT_EVENT_TYPE_PUBLISHED;
+                    callback_event.connection = conn;
                     conn->callback( &callback_event );
                 }
             }
@@ -259,6 +275,11 @@ zos_result_t mqtt_manager( mqtt_event_t event, void *args, mqtt_connection_t *co
             {
                 MQTT_LOG( "Puback packet %d not in session queue", puback_args->packet_id );
             }
+            else if ( conn->publish_inflight > 0 )
+            {
+                conn->publish_inflight--;
+            }
+            mqtt_store_acked( puback_args->packet_id, conn );
         }
             break;
 
@@ -308,36 +329,54 @@ zos_result_t mqtt_manager( mqtt_event_t event, void *args, mqtt_connection_t *co
             {
                 MQTT_LOG( "Pubrel packet %d not in session queue", pubcomp_args->packet_id );
             }
+            else if ( conn->publish_inflight > 0 )
+            {
+                conn->publish_inflight--;
+            }
+            mqtt_store_acked( pubcomp_args->packet_id, conn );
         }
             break;
 
         case MQTT_EVENT_RECV_PINGRES:
         {
             mqtt_manager_heartbeat_recv_reset( &conn->heartbeat );
-            /* Resend any thing in the session */
-            if ( mqtt_session_iterate_through_items( mqtt_manager_resend_packet, conn, conn->session ) != ZOS_SUCCESS )
-            {
-                MQTT_LOG( "Error resending session messages" );
-            }
         }
             break;
 
         case MQTT_EVENT_RECV_CONNACK:
         {
+            mqtt_connack_arg_t *connack_args = (mqtt_connack_arg_t *) args;
             mqtt_manager_heartbeat_recv_reset( &conn->heartbeat );
-            /* Resend any thing in the session */
-            if ( mqtt_session_iterate_through_items( mqtt_manager_resend_packet, conn, conn->session ) != ZOS_SUCCESS )
+            if ( connack_args->session_present )
             {
-                MQTT_LOG( "Error resending session messages" );
+                /* Resend what the broker's copy of the session has not acknowledged yet */
+                if ( mqtt_session_iterate_through_items( mqtt_manager_resend_packet, conn, conn->session ) != ZOS_SUCCESS )
+                {
+                    MQTT_LOG( "Error resending session messages" );
+                }
             }
+            else
+            {
+                /* The broker started a new session, the old one must be discarded */
+                mqtt_session_init( conn->session );
+                conn->publish_inflight = 0;
+            }
+            /* Start draining the persistent queue on the new connection */
+            mqtt_store_resume( conn );
         }
             break;
 
         case MQTT_EVENT_TICK:
         {
-            if ( mqtt_manager_heartbeat_recv_step( &conn->heartbeat ) != ZOS_SUCCESS )
+            if ( conn->socket.tx_stream > 0 )
+            {
+                /* Replies are not read and PINGREQ can't be sent while a PUBLISH is streamed out */
+                mqtt_manager_heartbeat_recv_reset( &conn->heartbeat );
+                mqtt_manager_heartbeat_send_reset( &conn->heartbeat );
+            }
+            else if ( mqtt_manager_heartbeat_recv_step( &conn->heartbeat ) != ZOS_SUCCESS )
             {
-                mqtt_manager_heartbeat_deinit( &conn->heartbeat );
+                mqtt_manager_heartbeat_deinit( conn, &conn->heartbeat );
 
                 /* Reset counter timed out and we didn't receive any thing from broker */
                 MQTT_LOG("Heartbeat timeout. Connection closed with broker. Close local connection");
@@ -391,7 +430,23 @@ static zos_result_t mqtt_manager_resend_packet( mqtt_frame_type_t type, void *ar
             break;
         case MQTT_PACKET_TYPE_PUBLISH:
         {
-            result = mqtt_backend_put_publish( arg, conn );
+            mqtt_publish_arg_t *publish_args = (mqtt_publish_arg_t *) arg;
+            if ( ( publish_args->data == NULL ) && ( publish_args->data_len > 0 ) )
+            {
+                /* The payload of a streamed publish is not kept, so it can't be sent again */
+                MQTT_LOG( "Dropping streamed publish packet %d", publish_args->packet_id );
+                mqtt_session_remove_item( MQTT_PACKET_TYPE_PUBLISH, publish_args->packet_id, conn->session );
+                if ( conn->publish_inflight > 0 )
+                {
+                    conn->publish_inflight--;
+                }
+                result = ZOS_SUCCESS;
+            }
+            else
+            {
+                publish_args->dup = 1;
+                result = mqtt_backend_put_publish( arg, conn );
+            }
         }
             break;
         case MQTT_PACKET_TYPE_PUBREC:
@@ -18,6 +18,7 @@
 #include "mqtt_network.h"
 #include "mqtt_connection.h"
 #include "mqtt_manager.h"
+#include "mqtt_pool.h"
 #include "mqtt_wrapper/mqtt_zentrios_wrapper.h"
 
 /******************************************************
@@ -49,12 +50,18 @@ typedef struct mqtt_network_message_s
  ******************************************************/
 static void mqtt_receive_handler( uint32_t handle );
 static void mqtt_disconnect_handler( uint32_t handle );
+static zos_result_t mqtt_network_get_frame_size( const uint8_t *data, uint32_t length, uint32_t *frame_size );
+static zos_result_t mqtt_network_dispatch_frames( mqtt_connection_t *conn );
+static mqtt_connection_t** mqtt_network_find_connection( uint32_t handle );
+static mqtt_connection_t** mqtt_network_find_entry( const mqtt_connection_t *conn );
+static void mqtt_network_flush_handler( void *arg );
+static void mqtt_network_resume_handler( void *arg );
 
 /******************************************************
  *               Variable Definitions
  ******************************************************/
-// ToDo: global variable? remove!!
-mqtt_connection_t *gConn;
+/* Open connections, the stream handlers only get the socket handle */
+static mqtt_connection_t *connections[MQTT_MAX_CONNECTIONS];
 /******************************************************
  *               Function Definitions
  ******************************************************/
@@ -62,7 +69,13 @@ zos_result_t mqtt_network_open( const char *server_ip_address, uint16_t portnumb
 {
     zos_result_t result = ZOS_SUCCESS;
     mqtt_connection_t *conn = (mqtt_connection_t *)p_user;
-    gConn = conn;
+    mqtt_connection_t **entry = mqtt_network_find_entry(NULL);
+
+    if(entry == NULL)
+    {
+        MQTT_LOG("Already %d connections open", MQTT_MAX_CONNECTIONS);
+        return ZOS_ERROR;
+    }
 
     if(!mqtt_network_is_up(ZOS_WLAN))
     {
@@ -91,6 +104,20 @@ zos_result_t mqtt_network_open( const char *server_ip_address, uint16_t portnumb
         }
     }
 
+    socket->rx.length = 0;
+    socket->rx.discard = 0;
+    socket->rx.stream.header = 0;
+    socket->tx_stream = 0;
+    result = mqtt_pool_acquire(&socket->rx.data, MQTT_CONNECTION_FRAME_MAX);
+    if(result != ZOS_SUCCESS)
+    {
+        MQTT_LOG("Don't have memory to allocate for receive buffer");
+        mqtt_tcp_disconnect(socket->socket_handle);
+        socket->rx.data = NULL;
+        goto ERROR_CREATE_SOCKET;
+    }
+
+    *entry = conn;
     mqtt_tcp_register_client_event_handlers(socket->socket_handle, mqtt_disconnect_handler, mqtt_receive_handler);
     conn->net_init_ok = ZOS_TRUE;
     return result;
@@ -103,12 +130,27 @@ ERROR_CREATE_SOCKET:
 zos_result_t mqtt_network_close( void *p_user )
 {
     mqtt_connection_t *conn = (mqtt_connection_t *)p_user;
+    mqtt_connection_t **entry;
+
     if(conn->net_init_ok != ZOS_TRUE)
     {
         // Already deinitialized before. Do nothing
         return ZOS_SUCCESS;
     }
 
+    entry = mqtt_network_find_entry(conn);
+    if(entry != NULL)
+    {
+        *entry = NULL;
+    }
+
+    if(conn->flush_pending == ZOS_TRUE)
+    {
+        mqtt_event_unregister(mqtt_network_flush_handler, conn);
+        conn->flush_pending = ZOS_FALSE;
+    }
+    mqtt_event_unregister(mqtt_network_resume_handler, conn);
+
     // MQTT_LOG("Server disconnected, attempting to read any remaining data");
     // mqtt_network_receive_buffer(conn->socket.socket_handle);
 
@@ -116,14 +158,26 @@ zos_result_t mqtt_network_close( void *p_user )
     mqtt_tcp_disconnect(conn->socket.socket_handle);
 
     conn->net_init_ok = ZOS_FALSE;
-    conn->socket.socket_handle = 0;
+    conn->socket.socket_handle = ZOS_INVALID_HANDLE;
+    conn->socket.generation++;
+
+    if(conn->socket.rx.data != NULL)
+    {
+        mqtt_pool_release(conn->socket.rx.data);
+        conn->socket.rx.data = NULL;
+    }
+    conn->socket.rx.length = 0;
+    conn->socket.rx.discard = 0;
+    conn->socket.rx.stream.header = 0;
+    conn->socket.tx_stream = 0;
+
     return ZOS_SUCCESS;
 }
 
 zos_result_t mqtt_network_create_buffer( mqtt_buffer_t *buffer, uint16_t size, mqtt_socket_t *socket )
 {
-    /* Create the TCP packet. Memory for the tx_data is automatically allocated */
-    mqtt_malloc(&buffer->data, size);
+    /* Frames come from the pool, the heap is only used if the pool allows it */
+    mqtt_pool_acquire(&buffer->data, size);
     if ( buffer->data == NULL )
     {
         MQTT_LOG("Don't have memory to allocate for buffer...\n");
@@ -136,49 +190,345 @@ zos_result_t mqtt_network_create_buffer( mqtt_buffer_t *buffer, uint16_t size, m
 zos_result_t mqtt_network_delete_buffer( uint8_t *data )
 {
     /* Delete frame data allocated by mqtt_network_create_buffer */
-    return mqtt_free( data );
+    return mqtt_pool_release( data );
 }
 
 zos_result_t mqtt_network_send_buffer( uint8_t *data, uint32_t size, mqtt_socket_t *socket )
 {
+    if(socket->tx_stream > 0)
+    {
+        /* Would end up inside the payload of the PUBLISH being streamed */
+        return ZOS_PENDING;
+    }
     return mqtt_tcp_write(socket->socket_handle, data, size, ZOS_FALSE);
 }
 
-zos_result_t mqtt_network_receive_buffer(uint32_t socket_handle, void *p_user)
+/*
+ * Writes the pieces of one frame straight from their owners' memory. With
+ * flush set the frame leaves right away, otherwise it is held back to share
+ * TCP segments with the frames that follow.
+ */
+zos_result_t mqtt_network_send_iovec( const mqtt_iovec_t *iovec, uint32_t count, zos_bool_t flush, mqtt_socket_t *socket )
 {
     zos_result_t result;
-    uint32_t bytes_read;
-    mqtt_buffer_t buffer;
+
+    if(socket->tx_stream > 0)
+    {
+        return ZOS_PENDING;
+    }
+
+    for(; count > 0; --count, ++iovec)
+    {
+        if(iovec->size == 0)
+        {
+            continue;
+        }
+        result = mqtt_tcp_write(socket->socket_handle, iovec->data, iovec->size, ZOS_FALSE);
+        if(result != ZOS_SUCCESS)
+        {
+            return result;
+        }
+    }
+
+    return (flush == ZOS_TRUE) ? mqtt_tcp_flush(socket->socket_handle) : ZOS_SUCCESS;
+}
+
+/*
+ * Writes the next piece of a PUBLISH payload whose header went out with
+ * mqtt_frame_send_publish(). The frame is flushed with its last piece, then
+ * whatever was received meanwhile is handled.
+ */
+zos_result_t mqtt_network_send_stream( const uint8_t *data, uint32_t size, void *p_user )
+{
     mqtt_connection_t *conn = (mqtt_connection_t *)p_user;
+    mqtt_socket_t *socket = &conn->socket;
+    zos_result_t result;
 
-    mqtt_malloc(&buffer.data, MQTT_CONNECTION_FRAME_MAX);
+    if(conn->net_init_ok != ZOS_TRUE || size > socket->tx_stream)
+    {
+        return ZOS_INVALID_ARG;
+    }
 
-    result = mqtt_tcp_read(socket_handle, buffer.data, MQTT_CONNECTION_FRAME_MAX, &bytes_read);
+    result = mqtt_tcp_write(socket->socket_handle, data, size, ZOS_FALSE);
     if(result != ZOS_SUCCESS)
     {
-        MQTT_LOG("Failed to read data (error %d)", result);
+        return result;
     }
-    else if(bytes_read == 0)
+
+    socket->tx_stream -= size;
+    if(socket->tx_stream == 0)
     {
-        result = ZOS_NO_DATA;
+        result = mqtt_tcp_flush(socket->socket_handle);
+        mqtt_event_issue(mqtt_network_resume_handler, conn, 0);
     }
-    else
+
+    return result;
+}
+
+/*
+ * Flushes un-flushed writes once the current event has finished, so every
+ * frame written while handling it goes out in one TCP write.
+ */
+zos_result_t mqtt_network_flush_deferred( void *p_user )
+{
+    mqtt_connection_t *conn = (mqtt_connection_t *)p_user;
+
+    if(conn->flush_pending == ZOS_TRUE)
+    {
+        return ZOS_SUCCESS;
+    }
+
+    conn->flush_pending = ZOS_TRUE;
+    return mqtt_event_issue(mqtt_network_flush_handler, conn, 0);
+}
+
+/*
+ * Reads everything the socket has into the connection's receive buffer and
+ * dispatches every complete frame. A frame split across reads stays in the
+ * buffer until the rest of it arrives.
+ */
+zos_result_t mqtt_network_receive_buffer(uint32_t socket_handle, void *p_user)
+{
+    zos_result_t result = ZOS_NO_DATA;
+    mqtt_connection_t *conn = (mqtt_connection_t *)p_user;
+    mqtt_rx_buffer_t *rx = &conn->socket.rx;
+    const uint32_t generation = conn->socket.generation;
+
+    while(rx->data != NULL && conn->socket.generation == generation)
     {
-        mqtt_frame_recv( &buffer, conn );
+        zos_result_t read_result;
+        uint32_t bytes_read;
+
+        read_result = mqtt_tcp_read(socket_handle, &rx->data[rx->length], MQTT_CONNECTION_FRAME_MAX - rx->length, &bytes_read);
+        if(read_result != ZOS_SUCCESS)
+        {
+            MQTT_LOG("Failed to read data (error %d)", read_result);
+            result = read_result;
+            break;
+        }
+        else if(bytes_read == 0)
+        {
+            break;
+        }
+
+        rx->length += bytes_read;
+        result = mqtt_network_dispatch_frames(conn);
+        if(result != ZOS_SUCCESS)
+        {
+            break;
+        }
     }
 
-    mqtt_free( buffer.data );
     return result;
 }
+/*
+ * Returns the table entry of the open connection using the socket handle.
+ */
+static mqtt_connection_t** mqtt_network_find_connection( uint32_t handle )
+{
+    uint32_t i;
+
+    for(i = 0; i < MQTT_MAX_CONNECTIONS; i++)
+    {
+        if(connections[i] != NULL && connections[i]->socket.socket_handle == handle)
+        {
+            return &connections[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Returns the table entry holding the connection, or a free entry for NULL.
+ */
+static mqtt_connection_t** mqtt_network_find_entry( const mqtt_connection_t *conn )
+{
+    uint32_t i;
+
+    for(i = 0; i < MQTT_MAX_CONNECTIONS; i++)
+    {
+        if(connections[i] == conn)
+        {
+            return &connections[i];
+        }
+    }
+
+    return NULL;
+}
+
 static void mqtt_disconnect_handler( uint32_t handle )
 {
+    mqtt_connection_t **entry = mqtt_network_find_connection(handle);
+
     MQTT_LOG("Disconnect handler invoked (socket %d)", handle);
-    mqtt_network_close( gConn );
+    if(entry != NULL)
+    {
+        mqtt_network_close( *entry );
+    }
+}
+
+static void mqtt_network_flush_handler( void *arg )
+{
+    mqtt_connection_t *conn = (mqtt_connection_t *)arg;
+
+    conn->flush_pending = ZOS_FALSE;
+    if(conn->net_init_ok == ZOS_TRUE)
+    {
+        mqtt_tcp_flush(conn->socket.socket_handle);
+    }
+}
+
+/* Catches up with the frames left unread while a PUBLISH was streamed out */
+static void mqtt_network_resume_handler( void *arg )
+{
+    mqtt_connection_t *conn = (mqtt_connection_t *)arg;
+
+    if(conn->net_init_ok == ZOS_TRUE && conn->socket.tx_stream == 0 && mqtt_network_dispatch_frames(conn) == ZOS_SUCCESS)
+    {
+        mqtt_network_receive_buffer(conn->socket.socket_handle, conn);
+    }
 }
 
 static void mqtt_receive_handler( uint32_t handle )
 {
+    mqtt_connection_t **entry = mqtt_network_find_connection(handle);
+
     //MQTT_LOG("Receive handler invoked: socket %d", handle);
-    mqtt_network_receive_buffer(handle, gConn);
+    if(entry != NULL && (*entry)->socket.tx_stream == 0)
+    {
+        mqtt_network_receive_buffer(handle, *entry);
+    }
 }
 
+static zos_result_t mqtt_network_get_frame_size( const uint8_t *data, uint32_t length, uint32_t *frame_size )
+{
+    uint32_t remaining_length = 0;
+    uint32_t multiplier = 1;
+
+    *frame_size = 0;
+
+    /* Fixed header: type octet, then 1 to 4 remaining length octets */
+    for(uint32_t i = 1; i < length; ++i)
+    {
+        remaining_length += (data[i] & 127) * multiplier;
+        if((data[i] & 128) == 0)
+        {
+            *frame_size = 1 + i + remaining_length;
+            return ZOS_SUCCESS;
+        }
+        else if(i == 4)
+        {
+            MQTT_LOG("Malformed remaining length");
+            return ZOS_ERROR;
+        }
+        multiplier *= 128;
+    }
+
+    /* Header not complete yet */
+    return ZOS_SUCCESS;
+}
+
+static zos_result_t mqtt_network_dispatch_frames( mqtt_connection_t *conn )
+{
+    mqtt_rx_buffer_t *rx = &conn->socket.rx;
+    const uint32_t generation = conn->socket.generation;
+    uint32_t offset = rx->stream.header;
+
+    while(offset < rx->length)
+    {
+        uint32_t frame_size;
+        mqtt_buffer_t buffer;
+
+        if(conn->socket.tx_stream > 0)
+        {
+            /* No reply can be sent before the PUBLISH being streamed out is complete */
+            break;
+        }
+
+        if(rx->discard > 0)
+        {
+            const uint32_t chunk = MIN(rx->discard, rx->length - offset);
+            rx->discard -= chunk;
+            offset += chunk;
+            continue;
+        }
+
+        if(rx->stream.header > 0)
+        {
+            const uint32_t chunk = MIN(rx->stream.args.data_len - rx->stream.offset, rx->length - offset);
+
+            offset += chunk;
+            mqtt_backend_get_publish_chunk(&rx->stream, &rx->data[offset - chunk], chunk, conn);
+            if(conn->socket.generation != generation)
+            {
+                return ZOS_SUCCESS;
+            }
+            if(rx->stream.offset == rx->stream.args.data_len)
+            {
+                rx->stream.header = 0;
+            }
+            continue;
+        }
+
+        if(mqtt_network_get_frame_size(&rx->data[offset], rx->length - offset, &frame_size) != ZOS_SUCCESS)
+        {
+            /* Stream is out of sync, nothing after this can be trusted */
+            mqtt_network_close(conn);
+            return ZOS_ERROR;
+        }
+        else if(frame_size == 0)
+        {
+            break;
+        }
+        else if(frame_size > MQTT_CONNECTION_FRAME_MAX)
+        {
+            zos_result_t result = ZOS_ERROR;
+            uint32_t header_size = 0;
+
+            if((rx->data[offset] >> 4) == MQTT_PACKET_TYPE_PUBLISH)
+            {
+                result = mqtt_frame_get_publish_header(&rx->data[offset], rx->length - offset, &rx->stream.args, &header_size);
+            }
+            if(result == ZOS_PENDING && header_size <= MQTT_CONNECTION_FRAME_MAX / 2)
+            {
+                break;
+            }
+            else if(result != ZOS_SUCCESS || header_size > MQTT_CONNECTION_FRAME_MAX / 2)
+            {
+                MQTT_LOG("Dropping %u byte frame, larger than receive buffer", frame_size);
+                rx->discard = frame_size;
+                continue;
+            }
+
+            /* The header, and so the topic, stays at the start of the buffer while the payload is passed on */
+            rx->length -= offset;
+            memmove(rx->data, &rx->data[offset], rx->length);
+            mqtt_frame_get_publish_header(rx->data, rx->length, &rx->stream.args, &header_size);
+            rx->stream.header = header_size;
+            rx->stream.offset = 0;
+            offset = header_size;
+            continue;
+        }
+        else if(frame_size > rx->length - offset)
+        {
+            break;
+        }
+
+        buffer.data = &rx->data[offset];
+        offset += frame_size;
+        mqtt_frame_recv(&buffer, conn);
+
+        if(conn->socket.generation != generation)
+        {
+            /* Connection was closed, and maybe reopened, while handling the frame */
+            return ZOS_SUCCESS;
+        }
+    }
+
+    /* Keep the incomplete frame, after the header of a streamed PUBLISH, for the next read */
+    memmove(&rx->data[rx->stream.header], &rx->data[offset], rx->length - offset);
+    rx->length = rx->stream.header + (rx->length - offset);
+
+    return ZOS_SUCCESS;
+}
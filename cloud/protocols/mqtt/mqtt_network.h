@@ -64,6 +64,9 @@ zos_result_t mqtt_network_close           ( void *p_user );
 
 zos_result_t mqtt_network_create_buffer   ( mqtt_buffer_t *buffer, uint16_t size, mqtt_socket_t *socket );
 zos_result_t mqtt_network_send_buffer     ( uint8_t *data, uint32_t size, mqtt_socket_t *socket );
+zos_result_t mqtt_network_send_iovec      ( const mqtt_iovec_t *iovec, uint32_t count, zos_bool_t flush, mqtt_socket_t *socket );
+zos_result_t mqtt_network_send_stream     ( const uint8_t *data, uint32_t size, void *p_user );
+zos_result_t mqtt_network_flush_deferred  ( void *p_user );
 zos_result_t mqtt_network_receive_buffer  ( uint32_t socket_handle, void *p_user );
 zos_result_t mqtt_network_delete_buffer   ( uint8_t *data );
 
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2015, Broadcom Corporation
+ * All Rights Reserved.
+ *
+ * This is UNPUBLISHED PROPRIETARY SOURCE CODE of Broadcom Corporation;
+ * the contents of this file may not be disclosed to third parties, copied
+ * or duplicated in any form, in whole or in part, without the prior
+ * written permission of Broadcom Corporation.
+ */
+
+/** @file
+ *  Frame buffer pool
+ *
+ *  Fixed size frames carved out of one block of memory. Free frames are kept
+ *  in a singly linked list threaded through the frames themselves, so acquire
+ *  and release are O(1) and the heap is only touched at init, or when the pool
+ *  runs dry and heap fallback is enabled.
+ */
+
+#include "zos_types.h"
+#include "mqtt_common.h"
+#include "mqtt_pool.h"
+#include "mqtt_wrapper/mqtt_zentrios_wrapper.h"
+#include "string.h"
+
+/******************************************************
+ *                      Macros
+ ******************************************************/
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+/******************************************************
+ *                   Enumerations
+ ******************************************************/
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+typedef struct mqtt_pool_frame_s
+{
+    struct mqtt_pool_frame_s *next;
+} mqtt_pool_frame_t;
+
+/******************************************************
+ *                    Structures
+ ******************************************************/
+typedef struct mqtt_pool_s
+{
+    uint16_t                    users;          /* Connections initialized with the pool */
+    uint8_t                    *memory;         /* Start of the pool frames */
+    uint8_t                    *memory_end;     /* First byte after the pool frames */
+    zos_bool_t                  memory_owned;   /* memory was allocated by the pool */
+    zos_bool_t                  heap_fallback;
+    mqtt_pool_frame_t          *free_list;
+    mqtt_frame_pool_stats_t     stats;
+} mqtt_pool_t;
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+static mqtt_pool_t pool;
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+zos_result_t mqtt_pool_init( const mqtt_frame_pool_config_t *config )
+{
+    uint16_t i;
+    uint8_t *frame;
+
+    /* The pool is shared, only the first connection configures it */
+    if ( pool.users++ > 0 )
+    {
+        return ZOS_SUCCESS;
+    }
+
+    memset( &pool, 0, sizeof( pool ) );
+    pool.users = 1;
+    pool.heap_fallback = config->heap_fallback;
+
+    if ( config->frame_count > 0 )
+    {
+        pool.memory = config->memory;
+        if ( pool.memory == NULL )
+        {
+            if ( mqtt_malloc( &pool.memory, (uint32_t) config->frame_count * MQTT_FRAME_POOL_FRAME_SIZE ) != ZOS_SUCCESS || pool.memory == NULL )
+            {
+                pool.users = 0;
+                return ZOS_NO_MEM;
+            }
+            pool.memory_owned = ZOS_TRUE;
+        }
+        pool.memory_end = pool.memory + (uint32_t) config->frame_count * MQTT_FRAME_POOL_FRAME_SIZE;
+
+        /* Chain the frames, lowest address first */
+        for ( i = config->frame_count, frame = pool.memory_end; i > 0; --i )
+        {
+            mqtt_pool_frame_t *free_frame;
+
+            frame -= MQTT_FRAME_POOL_FRAME_SIZE;
+            free_frame = (mqtt_pool_frame_t *) frame;
+            free_frame->next = pool.free_list;
+            pool.free_list = free_frame;
+        }
+    }
+
+    pool.stats.frame_count = config->frame_count;
+
+    return ZOS_SUCCESS;
+}
+
+zos_result_t mqtt_pool_deinit( void )
+{
+    if ( pool.users == 0 || --pool.users > 0 )
+    {
+        return ZOS_SUCCESS;
+    }
+
+    if ( pool.memory_owned == ZOS_TRUE )
+    {
+        mqtt_free( pool.memory );
+    }
+    memset( &pool, 0, sizeof( pool ) );
+
+    return ZOS_SUCCESS;
+}
+
+zos_result_t mqtt_pool_acquire( uint8_t **data, uint32_t size )
+{
+    *data = NULL;
+
+    if ( size <= MQTT_FRAME_POOL_FRAME_SIZE && pool.free_list != NULL )
+    {
+        *data = (uint8_t *) pool.free_list;
+        pool.free_list = pool.free_list->next;
+
+        if ( ++pool.stats.in_use > pool.stats.high_watermark )
+        {
+            pool.stats.high_watermark = pool.stats.in_use;
+        }
+        return ZOS_SUCCESS;
+    }
+
+    /* Without a pool (mqtt_init() not called) the heap is the only option */
+    if ( pool.heap_fallback == ZOS_TRUE || pool.users == 0 )
+    {
+        if ( mqtt_malloc( data, size ) == ZOS_SUCCESS && *data != NULL )
+        {
+            ++pool.stats.heap_allocations;
+            return ZOS_SUCCESS;
+        }
+        *data = NULL;
+    }
+
+    ++pool.stats.failures;
+    return ZOS_NO_MEM;
+}
+
+zos_result_t mqtt_pool_release( uint8_t *data )
+{
+    mqtt_pool_frame_t *frame;
+
+    if ( data == NULL )
+    {
+        return ZOS_SUCCESS;
+    }
+
+    if ( data < pool.memory || data >= pool.memory_end )
+    {
+        return mqtt_free( data );
+    }
+
+    frame = (mqtt_pool_frame_t *) data;
+    frame->next = pool.free_list;
+    pool.free_list = frame;
+    --pool.stats.in_use;
+
+    return ZOS_SUCCESS;
+}
+
+zos_result_t mqtt_pool_get_stats( mqtt_frame_pool_stats_t *stats )
+{
+    memcpy( stats, &pool.stats, sizeof( mqtt_frame_pool_stats_t ) );
+    return ZOS_SUCCESS;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2015, Broadcom Corporation
+ * All Rights Reserved.
+ *
+ * This is UNPUBLISHED PROPRIETARY SOURCE CODE of Broadcom Corporation;
+ * the contents of this file may not be disclosed to third parties, copied
+ * or duplicated in any form, in whole or in part, without the prior
+ * written permission of Broadcom Corporation.
+ */
+
+/** @file
+ *  MQTT frame buffer pool.
+ *
+ *  Internal functions not to be used directly by applications.
+ */
+#pragma once
+
+#include "zos_types.h"
+#include "mqtt_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************
+ *                      Macros
+ ******************************************************/
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+/******************************************************
+ *                   Enumerations
+ ******************************************************/
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+/******************************************************
+ *                    Structures
+ ******************************************************/
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+zos_result_t mqtt_pool_init     ( const mqtt_frame_pool_config_t *config );
+zos_result_t mqtt_pool_deinit   ( void );
+zos_result_t mqtt_pool_acquire  ( uint8_t **data, uint32_t size );
+zos_result_t mqtt_pool_release  ( uint8_t *data );
+zos_result_t mqtt_pool_get_stats( mqtt_frame_pool_stats_t *stats );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -0,0 +1,423 @@
+/*
+ * Copyright 2015, Broadcom Corporation
+ * All Rights Reserved.
+ *
+ * This is UNPUBLISHED PROPRIETARY SOURCE CODE of Broadcom Corporation;
+ * the contents of this file may not be disclosed to third parties, copied
+ * or duplicated in any form, in whole or in part, without the prior
+ * written permission of Broadcom Corporation.
+ */
+
+/** @file
+ *  Topic router
+ *
+ *  Subscribed filters are split at '/' into a trie of topic levels, '+' and
+ *  '#' levels get their own slots in the parent node. A received topic walks
+ *  the trie one level at a time, so matching costs depend on the depth of the
+ *  topic and the number of '+' branches it meets, not on how many filters are
+ *  registered.
+ */
+
+#include "zos_types.h"
+#include "mqtt_common.h"
+#include "mqtt_router.h"
+#include "mqtt_wrapper/mqtt_zentrios_wrapper.h"
+#include "string.h"
+
+/******************************************************
+ *                      Macros
+ ******************************************************/
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+/******************************************************
+ *                   Enumerations
+ ******************************************************/
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+/******************************************************
+ *                    Structures
+ ******************************************************/
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+static uint16_t             mqtt_router_level_length ( const uint8_t *level, uint32_t length );
+static mqtt_router_node_t*  mqtt_router_node_create  ( const uint8_t *level, uint16_t level_len );
+static mqtt_router_node_t** mqtt_router_node_find    ( mqtt_router_node_t *node, const uint8_t *level, uint16_t level_len );
+static zos_bool_t           mqtt_router_node_is_empty( const mqtt_router_node_t *node );
+static void                 mqtt_router_node_free    ( mqtt_router_node_t *node );
+static void                 mqtt_router_node_prune   ( mqtt_router_node_t **node );
+static zos_result_t         mqtt_router_handler_del  ( mqtt_router_handler_t **list, mqtt_topic_handler_t handler );
+static zos_result_t         mqtt_router_handler_clear( mqtt_router_handler_t *list, mqtt_topic_handler_t handler );
+static zos_result_t         mqtt_router_remove_level ( mqtt_router_node_t *node, const uint8_t *filter, uint32_t length, mqtt_topic_handler_t handler, zos_bool_t defer );
+static uint32_t             mqtt_router_match        ( mqtt_router_node_t *node, const uint8_t *topic, uint32_t length, zos_bool_t wildcards, void *connection, mqtt_topic_msg_t *msg );
+static uint32_t             mqtt_router_call         ( mqtt_router_handler_t *list, void *connection, mqtt_topic_msg_t *msg );
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+static uint16_t mqtt_router_level_length( const uint8_t *level, uint32_t length )
+{
+    uint16_t i = 0;
+
+    while ( ( i < length ) && ( level[i] != '/' ) )
+    {
+        i++;
+    }
+    return i;
+}
+
+static mqtt_router_node_t* mqtt_router_node_create( const uint8_t *level, uint16_t level_len )
+{
+    mqtt_router_node_t *node = NULL;
+
+    if ( mqtt_malloc( (uint8_t**) &node, sizeof( mqtt_router_node_t ) + level_len ) != ZOS_SUCCESS || node == NULL )
+    {
+        return NULL;
+    }
+    memset( node, 0, sizeof( mqtt_router_node_t ) );
+    node->level_len = level_len;
+    memcpy( node->level, level, level_len );
+
+    return node;
+}
+
+static mqtt_router_node_t** mqtt_router_node_find( mqtt_router_node_t *node, const uint8_t *level, uint16_t level_len )
+{
+    mqtt_router_node_t **child;
+
+    if ( ( level_len == 1 ) && ( level[0] == '+' ) )
+    {
+        return &node->plus;
+    }
+
+    for ( child = &node->children; *child != NULL; child = &( *child )->sibling )
+    {
+        if ( ( ( *child )->level_len == level_len ) && ( memcmp( ( *child )->level, level, level_len ) == 0 ) )
+        {
+            break;
+        }
+    }
+    return child;
+}
+
+static zos_bool_t mqtt_router_node_is_empty( const mqtt_router_node_t *node )
+{
+    return ( node->children == NULL && node->plus == NULL && node->handlers == NULL && node->hash_handlers == NULL ) ? ZOS_TRUE : ZOS_FALSE;
+}
+
+static void mqtt_router_node_free( mqtt_router_node_t *node )
+{
+    while ( node != NULL )
+    {
+        mqtt_router_node_t *sibling = node->sibling;
+
+        mqtt_router_node_free( node->children );
+        mqtt_router_node_free( node->plus );
+        while ( node->handlers != NULL )
+        {
+            mqtt_router_handler_del( &node->handlers, node->handlers->handler );
+        }
+        while ( node->hash_handlers != NULL )
+        {
+            mqtt_router_handler_del( &node->hash_handlers, node->hash_handlers->handler );
+        }
+        mqtt_free( node );
+        node = sibling;
+    }
+}
+
+/* Frees the handlers cleared while dispatching and the levels left without filters */
+static void mqtt_router_node_prune( mqtt_router_node_t **node )
+{
+    while ( *node != NULL )
+    {
+        mqtt_router_node_t *entry = *node;
+
+        mqtt_router_node_prune( &entry->children );
+        mqtt_router_node_prune( &entry->plus );
+        while ( mqtt_router_handler_del( &entry->handlers, NULL ) == ZOS_SUCCESS )
+        {
+        }
+        while ( mqtt_router_handler_del( &entry->hash_handlers, NULL ) == ZOS_SUCCESS )
+        {
+        }
+
+        if ( mqtt_router_node_is_empty( entry ) == ZOS_TRUE )
+        {
+            *node = entry->sibling;
+            mqtt_free( entry );
+        }
+        else
+        {
+            node = &entry->sibling;
+        }
+    }
+}
+
+static zos_result_t mqtt_router_handler_del( mqtt_router_handler_t **list, mqtt_topic_handler_t handler )
+{
+    for ( ; *list != NULL; list = &( *list )->next )
+    {
+        if ( ( *list )->handler == handler )
+        {
+            mqtt_router_handler_t *entry = *list;
+            *list = entry->next;
+            mqtt_free( entry );
+            return ZOS_SUCCESS;
+        }
+    }
+    return ZOS_NOT_FOUND;
+}
+
+/* Disables a handler without unlinking it, the lists may be walked by mqtt_router_dispatch() */
+static zos_result_t mqtt_router_handler_clear( mqtt_router_handler_t *list, mqtt_topic_handler_t handler )
+{
+    for ( ; list != NULL; list = list->next )
+    {
+        if ( list->handler == handler )
+        {
+            list->handler = NULL;
+            return ZOS_SUCCESS;
+        }
+    }
+    return ZOS_NOT_FOUND;
+}
+
+zos_result_t mqtt_router_add( mqtt_router_t *router, const char *filter, mqtt_topic_handler_t handler, void *arg )
+{
+    mqtt_router_node_t **root = &router->root;
+    const uint8_t *level = (const uint8_t*) filter;
+    uint32_t length = (uint32_t) strlen( filter );
+    mqtt_router_node_t *node;
+    mqtt_router_handler_t **list;
+    mqtt_router_handler_t *entry = NULL;
+
+    if ( ( length == 0 ) || ( handler == NULL ) )
+    {
+        return ZOS_INVALID_ARG;
+    }
+
+    if ( *root == NULL )
+    {
+        *root = mqtt_router_node_create( NULL, 0 );
+        if ( *root == NULL )
+        {
+            return ZOS_NO_MEM;
+        }
+    }
+
+    /* Walk down the levels, creating the missing ones */
+    for ( node = *root; ; )
+    {
+        uint16_t level_len = mqtt_router_level_length( level, length );
+        mqtt_router_node_t **child;
+
+        if ( ( level_len == 1 ) && ( level[0] == '#' ) )
+        {
+            /* '#' must be the last level */
+            if ( length != 1 )
+            {
+                return ZOS_INVALID_ARG;
+            }
+            list = &node->hash_handlers;
+            break;
+        }
+        if ( ( memchr( level, '+', level_len ) != NULL && level_len != 1 ) || ( memchr( level, '#', level_len ) != NULL ) )
+        {
+            /* Wildcards must occupy an entire level */
+            return ZOS_INVALID_ARG;
+        }
+
+        child = mqtt_router_node_find( node, level, level_len );
+        if ( *child == NULL )
+        {
+            *child = mqtt_router_node_create( level, level_len );
+            if ( *child == NULL )
+            {
+                return ZOS_NO_MEM;
+            }
+        }
+        node = *child;
+
+        if ( level_len == length )
+        {
+            list = &node->handlers;
+            break;
+        }
+        level  += level_len + 1;
+        length -= level_len + 1;
+    }
+
+    if ( mqtt_malloc( (uint8_t**) &entry, sizeof( mqtt_router_handler_t ) ) != ZOS_SUCCESS || entry == NULL )
+    {
+        return ZOS_NO_MEM;
+    }
+    entry->handler = handler;
+    entry->arg = arg;
+    entry->next = *list;
+    *list = entry;
+
+    return ZOS_SUCCESS;
+}
+
+static zos_result_t mqtt_router_remove_level( mqtt_router_node_t *node, const uint8_t *filter, uint32_t length, mqtt_topic_handler_t handler, zos_bool_t defer )
+{
+    uint16_t level_len = mqtt_router_level_length( filter, length );
+    mqtt_router_node_t **child;
+    zos_result_t result;
+
+    if ( ( level_len == 1 ) && ( length == 1 ) && ( filter[0] == '#' ) )
+    {
+        return ( defer == ZOS_TRUE ) ? mqtt_router_handler_clear( node->hash_handlers, handler ) : mqtt_router_handler_del( &node->hash_handlers, handler );
+    }
+
+    child = mqtt_router_node_find( node, filter, level_len );
+    if ( *child == NULL )
+    {
+        return ZOS_NOT_FOUND;
+    }
+
+    if ( level_len == length )
+    {
+        result = ( defer == ZOS_TRUE ) ? mqtt_router_handler_clear( ( *child )->handlers, handler ) : mqtt_router_handler_del( &( *child )->handlers, handler );
+    }
+    else
+    {
+        result = mqtt_router_remove_level( *child, filter + level_len + 1, length - level_len - 1, handler, defer );
+    }
+
+    /* Prune levels no filter uses anymore */
+    if ( ( result == ZOS_SUCCESS ) && ( defer == ZOS_FALSE ) && ( mqtt_router_node_is_empty( *child ) == ZOS_TRUE ) )
+    {
+        mqtt_router_node_t *empty = *child;
+        *child = empty->sibling;
+        mqtt_free( empty );
+    }
+    return result;
+}
+
+zos_result_t mqtt_router_remove( mqtt_router_t *router, const char *filter, mqtt_topic_handler_t handler )
+{
+    mqtt_router_node_t **root = &router->root;
+    zos_result_t result;
+
+    if ( ( *root == NULL ) || ( handler == NULL ) )
+    {
+        return ZOS_NOT_FOUND;
+    }
+
+    if ( router->dispatching > 0 )
+    {
+        /* Called from a handler, nothing the dispatch is walking can be freed before it returns */
+        result = mqtt_router_remove_level( *root, (const uint8_t*) filter, (uint32_t) strlen( filter ), handler, ZOS_TRUE );
+        if ( result == ZOS_SUCCESS )
+        {
+            router->removed = ZOS_TRUE;
+        }
+        return result;
+    }
+
+    result = mqtt_router_remove_level( *root, (const uint8_t*) filter, (uint32_t) strlen( filter ), handler, ZOS_FALSE );
+    if ( mqtt_router_node_is_empty( *root ) == ZOS_TRUE )
+    {
+        mqtt_free( *root );
+        *root = NULL;
+    }
+    return result;
+}
+
+zos_result_t mqtt_router_deinit( mqtt_router_t *router )
+{
+    mqtt_router_node_free( router->root );
+    router->root = NULL;
+    router->removed = ZOS_FALSE;
+    return ZOS_SUCCESS;
+}
+
+static uint32_t mqtt_router_call( mqtt_router_handler_t *list, void *connection, mqtt_topic_msg_t *msg )
+{
+    uint32_t count = 0;
+
+    for ( ; list != NULL; list = list->next )
+    {
+        /* Handlers removed during this dispatch are cleared, not unlinked */
+        if ( list->handler != NULL )
+        {
+            list->handler( connection, msg, list->arg );
+            count++;
+        }
+    }
+    return count;
+}
+
+static uint32_t mqtt_router_match( mqtt_router_node_t *node, const uint8_t *topic, uint32_t length, zos_bool_t wildcards, void *connection, mqtt_topic_msg_t *msg )
+{
+    uint16_t level_len = mqtt_router_level_length( topic, length );
+    mqtt_router_node_t *child = *mqtt_router_node_find( node, topic, level_len );
+    mqtt_router_node_t *branch[2];
+    uint32_t count = 0;
+    uint32_t i;
+
+    /* Received topics never contain wildcards, so the lookup above only finds literal levels */
+    branch[0] = child;
+    branch[1] = ( wildcards == ZOS_TRUE ) ? node->plus : NULL;
+
+    if ( wildcards == ZOS_TRUE )
+    {
+        count += mqtt_router_call( node->hash_handlers, connection, msg );
+    }
+
+    for ( i = 0; i < 2; i++ )
+    {
+        if ( branch[i] == NULL )
+        {
+            continue;
+        }
+        if ( level_len == length )
+        {
+            /* "a/b/#" also matches "a/b" */
+            count += mqtt_router_call( branch[i]->handlers, connection, msg );
+            count += mqtt_router_call( branch[i]->hash_handlers, connection, msg );
+        }
+        else
+        {
+            count += mqtt_router_match( branch[i], topic + level_len + 1, length - level_len - 1, ZOS_TRUE, connection, msg );
+        }
+    }
+
+    return count;
+}
+
+uint32_t mqtt_router_dispatch( mqtt_router_t *router, void *connection, mqtt_topic_msg_t *msg )
+{
+    uint32_t count;
+
+    if ( ( router->root == NULL ) || ( msg->topic_len == 0 ) )
+    {
+        return 0;
+    }
+
+    /* Topics starting with '$' are not matched by a wildcard in the first level */
+    router->dispatching++;
+    count = mqtt_router_match( router->root, msg->topic, msg->topic_len, ( msg->topic[0] == '$' ) ? ZOS_FALSE : ZOS_TRUE, connection, msg );
+    router->dispatching--;
+
+    if ( ( router->dispatching == 0 ) && ( router->removed == ZOS_TRUE ) )
+    {
+        router->removed = ZOS_FALSE;
+        mqtt_router_node_prune( &router->root );
+    }
+    return count;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2015, Broadcom Corporation
+ * All Rights Reserved.
+ *
+ * This is UNPUBLISHED PROPRIETARY SOURCE CODE of Broadcom Corporation;
+ * the contents of this file may not be disclosed to third parties, copied
+ * or duplicated in any form, in whole or in part, without the prior
+ * written permission of Broadcom Corporation.
+ */
+
+/** @file
+ *  MQTT topic router.
+ *
+ *  Internal functions not to be used directly by applications.
+ */
+#pragma once
+
+#include "zos_types.h"
+#include "mqtt_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************
+ *                      Macros
+ ******************************************************/
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+/******************************************************
+ *                   Enumerations
+ ******************************************************/
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+typedef struct mqtt_router_handler_s
+{
+    struct mqtt_router_handler_s   *next;
+    mqtt_topic_handler_t            handler;
+    void                           *arg;
+} mqtt_router_handler_t;
+
+/* One topic level of the subscribed filters */
+typedef struct mqtt_router_node_s
+{
+    struct mqtt_router_node_s      *sibling;
+    struct mqtt_router_node_s      *children;       /* Children matching a literal level */
+    struct mqtt_router_node_s      *plus;           /* Child for a '+' level */
+    mqtt_router_handler_t          *handlers;       /* Filters ending at this level */
+    mqtt_router_handler_t          *hash_handlers;  /* Filters ending with '#' after this level */
+    uint16_t                        level_len;
+    uint8_t                         level[1];       /* Level name, level_len bytes */
+} mqtt_router_node_t;
+
+/* Topic filters of a connection */
+typedef struct
+{
+    mqtt_router_node_t             *root;
+    uint16_t                        dispatching;    /* Nesting depth of mqtt_router_dispatch() */
+    zos_bool_t                      removed;        /* Handlers were removed while dispatching, pruned once it returns */
+} mqtt_router_t;
+
+/******************************************************
+ *                    Structures
+ ******************************************************/
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+zos_result_t mqtt_router_add        ( mqtt_router_t *router, const char *filter, mqtt_topic_handler_t handler, void *arg );
+zos_result_t mqtt_router_remove     ( mqtt_router_t *router, const char *filter, mqtt_topic_handler_t handler );
+zos_result_t mqtt_router_deinit     ( mqtt_router_t *router );
+uint32_t     mqtt_router_dispatch   ( mqtt_router_t *router, void *connection, mqtt_topic_msg_t *msg );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
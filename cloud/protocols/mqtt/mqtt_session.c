@@ -41,6 +41,10 @@
 /******************************************************
  *               Static Function Declarations
  ******************************************************/
+static uint16_t             mqtt_session_hash       ( mqtt_frame_type_t type, uint16_t packet_id );
+static mqtt_session_item_t* mqtt_session_find_item  ( mqtt_frame_type_t type, uint16_t packet_id, mqtt_session_t *session );
+static void                 mqtt_session_index_add  ( mqtt_session_item_t *item, mqtt_session_t *session );
+static void                 mqtt_session_index_del  ( mqtt_session_item_t *item, mqtt_session_t *session );
 
 /******************************************************
  *               Variable Definitions
@@ -49,35 +53,153 @@
 /******************************************************
  *               Function Definitions
  ******************************************************/
+static uint16_t mqtt_session_hash( mqtt_frame_type_t type, uint16_t packet_id )
+{
+    /* Outgoing packet ids are sequential, so they spread well on their own */
+    return (uint16_t) ( ( (uint32_t) packet_id * 5 + (uint32_t) type ) % SESSION_INDEX_SIZE );
+}
+
+static mqtt_session_item_t* mqtt_session_find_item( mqtt_frame_type_t type, uint16_t packet_id, mqtt_session_t *session )
+{
+    uint16_t slot = mqtt_session_hash( type, packet_id );
+
+    /* The index is never full, so an empty slot always ends the probe */
+    while ( session->index[slot] != SESSION_INDEX_EMPTY )
+    {
+        mqtt_session_item_t *item = &session->items[session->index[slot]];
+        if ( ( item->type == type ) && ( item->packet_id == packet_id ) )
+        {
+            return item;
+        }
+        slot = (uint16_t) ( ( slot + 1 ) % SESSION_INDEX_SIZE );
+    }
+
+    return NULL;
+}
+
+static void mqtt_session_index_add( mqtt_session_item_t *item, mqtt_session_t *session )
+{
+    uint16_t slot = mqtt_session_hash( item->type, item->packet_id );
+
+    while ( session->index[slot] != SESSION_INDEX_EMPTY )
+    {
+        slot = (uint16_t) ( ( slot + 1 ) % SESSION_INDEX_SIZE );
+    }
+    session->index[slot] = (uint16_t) ( item - session->items );
+    item->slot = slot;
+}
+
+static void mqtt_session_index_del( mqtt_session_item_t *item, mqtt_session_t *session )
+{
+    uint16_t hole = item->slot;
+    uint16_t slot = hole;
+
+    session->index[hole] = SESSION_INDEX_EMPTY;
+
+    /* Shift back entries of the probe chain so no tombstones are needed */
+    for ( ;; )
+    {
+        mqtt_session_item_t *next;
+        uint16_t home;
+
+        slot = (uint16_t) ( ( slot + 1 ) % SESSION_INDEX_SIZE );
+        if ( session->index[slot] == SESSION_INDEX_EMPTY )
+        {
+            break;
+        }
+
+        next = &session->items[session->index[slot]];
+        home = mqtt_session_hash( next->type, next->packet_id );
+
+        /* Entry stays if its home slot lies cyclically in (hole, slot] */
+        if ( ( hole <= slot ) ? ( ( home > hole ) && ( home <= slot ) ) : ( ( home > hole ) || ( home <= slot ) ) )
+        {
+            continue;
+        }
+
+        session->index[hole] = session->index[slot];
+        session->index[slot] = SESSION_INDEX_EMPTY;
+        next->slot = hole;
+        hole = slot;
+    }
+}
 
 /******************************************************
  *               Interface functions
  ******************************************************/
 zos_result_t mqtt_session_init( mqtt_session_t *session )
 {
+    uint16_t i;
+
     /* Initialize both list heads used and non used */
     INIT_LIST_HEAD( &session->used_list );
     INIT_LIST_HEAD( &session->nonused_list );
 
+    for ( i = 0; i < SESSION_ITEMS_SIZE; i++ )
+    {
+        list_add_tail( &session->items[i].list, &session->nonused_list );
+    }
+    for ( i = 0; i < SESSION_INDEX_SIZE; i++ )
+    {
+        session->index[i] = SESSION_INDEX_EMPTY;
+    }
+
     return ZOS_SUCCESS;
 }
 
 zos_result_t mqtt_session_add_item( mqtt_frame_type_t type, void *args, mqtt_session_t *session)
 {
     mqtt_session_item_t *item;
+    uint16_t packet_id;
 
-    /* Check if there are any non used slots to grab */
-    if ( list_empty( &session->nonused_list ) )
+    if ( type == MQTT_PACKET_TYPE_PUBLISH )
     {
-        return ZOS_SUCCESS;
+        packet_id = ((mqtt_publish_arg_t *) args)->packet_id;
+    }
+    else if ( type == MQTT_PACKET_TYPE_SUBSCRIBE )
+    {
+        packet_id = ((mqtt_subscribe_arg_t *) args)->packet_id;
+    }
+    else if ( type == MQTT_PACKET_TYPE_UNSUBSCRIBE )
+    {
+        packet_id = ((mqtt_unsubscribe_arg_t *) args)->packet_id;
+    }
+    else if ( type == MQTT_PACKET_TYPE_PUBREC )
+    {
+        packet_id = ((mqtt_pubrec_arg_t *) args)->packet_id;
+    }
+    else if ( type == MQTT_PACKET_TYPE_PUBREL )
+    {
+        packet_id = ((mqtt_pubrel_arg_t *) args)->packet_id;
+    }
+    else
+    {
+        return ZOS_ERROR;
     }
 
-    /* Get first item in the empty list */
-    item = list_entry( session->nonused_list.next, mqtt_session_item_t, list );
-    list_del( &item->list );
+    /* An item is tracked once, adding it again only refreshes its arguments */
+    item = mqtt_session_find_item( type, packet_id, session );
+    if ( item == NULL )
+    {
+        /* Check if there are any non used slots to grab */
+        if ( list_empty( &session->nonused_list ) )
+        {
+            return ZOS_NO_MEM;
+        }
+
+        /* Get first item in the empty list */
+        item = list_entry( session->nonused_list.next, mqtt_session_item_t, list );
+        list_del( &item->list );
+
+        item->type = type;
+        item->packet_id = packet_id;
+        mqtt_session_index_add( item, session );
+
+        /* Add it to the used list */
+        list_add_tail( &item->list, &session->used_list );
+    }
 
     /* Fill data */
-    item->type = type;
     if ( type == MQTT_PACKET_TYPE_PUBLISH )
     {
         item->args.publish = *((mqtt_publish_arg_t *) args);
@@ -94,83 +216,43 @@ zos_result_t mqtt_session_add_item( mqtt_frame_type_t type, void *args, mqtt_ses
     {
         item->args.pubrec = *((mqtt_pubrec_arg_t *) args);
     }
-    else if ( type == MQTT_PACKET_TYPE_PUBREL )
-    {
-        item->args.pubrel = *((mqtt_pubrel_arg_t *) args);
-    }
     else
     {
-        list_add( &item->list, &session->nonused_list );
-        return ZOS_ERROR;
+        item->args.pubrel = *((mqtt_pubrel_arg_t *) args);
     }
 
-    /* Add it to the used list */
-    list_add_tail( &item->list, &session->used_list );
-
     return ZOS_SUCCESS;
 }
 
 zos_result_t mqtt_session_remove_item( mqtt_frame_type_t type, uint16_t packet_id, mqtt_session_t *session)
 {
-    struct list_head *pos, *q;
-    mqtt_session_item_t *item = NULL;
+    mqtt_session_item_t *item = mqtt_session_find_item( type, packet_id, session );
 
-    if ( list_empty( &session->used_list ) )
+    if ( item == NULL )
     {
-        return ZOS_SUCCESS;
+        /* No match */
+        return ZOS_ERROR;
     }
 
-    list_for_each_safe( pos, q, &session->used_list )
-    {
-        item = list_entry( pos, mqtt_session_item_t, list );
-        if ( ( ( type == MQTT_PACKET_TYPE_PUBLISH     ) && ( item->args.publish.packet_id     == packet_id ) ) ||
-             ( ( type == MQTT_PACKET_TYPE_SUBSCRIBE   ) && ( item->args.subscribe.packet_id   == packet_id ) ) ||
-             ( ( type == MQTT_PACKET_TYPE_UNSUBSCRIBE ) && ( item->args.unsubscribe.packet_id == packet_id ) ) ||
-             ( ( type == MQTT_PACKET_TYPE_PUBREC      ) && ( item->args.pubrec.packet_id      == packet_id ) ) ||
-             ( ( type == MQTT_PACKET_TYPE_PUBREL      ) && ( item->args.pubrel.packet_id      == packet_id ) ) )
-        {
-            /* Remove item from used lists */
-            list_del( &item->list );
-            /* Add Item to non used list */
-            list_add( &item->list, &session->nonused_list );
+    mqtt_session_index_del( item, session );
+    /* Remove item from used lists */
+    list_del( &item->list );
+    /* Add Item to non used list */
+    list_add( &item->list, &session->nonused_list );
 
-            return ZOS_SUCCESS;
-        }
-    }
-    /* No match */
-    return ZOS_ERROR;
+    return ZOS_SUCCESS;
 }
 
 
 zos_result_t mqtt_session_item_exist( mqtt_frame_type_t type, uint16_t packet_id, mqtt_session_t *session)
 {
-    struct list_head *pos;
-    mqtt_session_item_t *item = NULL;
-
-    if ( list_empty( &session->used_list ) )
-    {
-        return ZOS_ERROR;
-    }
-
-    list_for_each( pos, &session->used_list )
-    {
-        item = list_entry( pos, mqtt_session_item_t, list );
-        if ( ( ( type == MQTT_PACKET_TYPE_PUBLISH     ) && ( item->args.publish.packet_id == packet_id     ) ) ||
-             ( ( type == MQTT_PACKET_TYPE_SUBSCRIBE   ) && ( item->args.subscribe.packet_id == packet_id   ) ) ||
-             ( ( type == MQTT_PACKET_TYPE_UNSUBSCRIBE ) && ( item->args.unsubscribe.packet_id == packet_id ) ) ||
-             ( ( type == MQTT_PACKET_TYPE_PUBREC      ) && ( item->args.pubrec.packet_id == packet_id      ) ) ||
-             ( ( type == MQTT_PACKET_TYPE_PUBREL      ) && ( item->args.pubrel.packet_id == packet_id      ) ) )
-        {
-            return ZOS_SUCCESS;
-        }
-    }
-    /* No match */
-    return ZOS_ERROR;
+    return ( mqtt_session_find_item( type, packet_id, session ) != NULL ) ? ZOS_SUCCESS : ZOS_ERROR;
 }
 
 zos_result_t mqtt_session_iterate_through_items( zos_result_t (*iter_func)(mqtt_frame_type_t type, void *arg, void *p_user ), void* p_user, mqtt_session_t *session)
 {
     struct list_head *pos;
+    struct list_head *n;
     mqtt_session_item_t *item = NULL;
 
     if ( list_empty( &session->used_list ) )
@@ -178,7 +260,8 @@ zos_result_t mqtt_session_iterate_through_items( zos_result_t (*iter_func)(mqtt_
         return ZOS_SUCCESS;
     }
 
-    list_for_each( pos, &session->used_list )
+    /* Oldest first, so retransmissions keep the original order. iter_func may remove the item it is given */
+    list_for_each_safe( pos, n, &session->used_list )
     {
         item = list_entry( pos, mqtt_session_item_t, list );
         if ( iter_func( item->type, &item->args, p_user ) != ZOS_SUCCESS )
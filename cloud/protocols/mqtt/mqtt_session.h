@@ -30,7 +30,13 @@ extern "C" {
 /******************************************************
  *                    Constants
  ******************************************************/
+#ifndef MQTT_QUEUE_SIZE
+#define     MQTT_QUEUE_SIZE         (8)
+#endif
+
 #define     SESSION_ITEMS_SIZE      (MQTT_QUEUE_SIZE * 2)
+#define     SESSION_INDEX_SIZE      (SESSION_ITEMS_SIZE * 2)    /* Keeps the index at most half full */
+#define     SESSION_INDEX_EMPTY     (0xFFFF)
 
 /******************************************************
  *                   Enumerations
@@ -52,13 +58,17 @@ typedef struct mqtt_session_item_s
 {
     struct list_head          list;
     mqtt_frame_type_t         type;
+    uint16_t                  packet_id;
+    uint16_t                  slot;     /* Position in the session index */
     mqtt_session_item_args_t  args;
 }mqtt_session_item_t;
 
 typedef struct mqtt_session_s
 {
-    struct list_head used_list;
-    struct list_head nonused_list;
+    struct list_head     used_list;                     /* Items in the order they were added, for retransmission */
+    struct list_head     nonused_list;
+    mqtt_session_item_t  items[SESSION_ITEMS_SIZE];
+    uint16_t             index[SESSION_INDEX_SIZE];     /* Item number keyed by type and packet id, linear probing */
 }mqtt_session_t;
 /******************************************************
  *             Content Frame Type Definitions
@@ -0,0 +1,507 @@
+/*
+ * Copyright 2015, Broadcom Corporation
+ * All Rights Reserved.
+ *
+ * This is UNPUBLISHED PROPRIETARY SOURCE CODE of Broadcom Corporation;
+ * the contents of this file may not be disclosed to third parties, copied
+ * or duplicated in any form, in whole or in part, without the prior
+ * written permission of Broadcom Corporation.
+ */
+
+/** @file
+ *  Persistent outbound queue
+ *
+ *  An append-only log of segment files. Messages are packed into a RAM batch
+ *  which is committed as one segment file, with a single sequential write, when
+ *  it is full or old enough. Once connected the oldest segment is read back in
+ *  one go and replayed at a limited rate, its file is deleted when every QoS1/2
+ *  message in it has been acknowledged.
+ *
+ *  Segment file: header (magic, sequence number, length, CRC-32 of the messages,
+ *  so a commit cut short is detected on load) followed by messages
+ *  of topic length (2 bytes), data length (4 bytes), QoS (1 byte), the topic
+ *  with a terminating NUL and the data.
+ */
+
+#include "zos_types.h"
+#include "mqtt_api.h"
+#include "mqtt_store.h"
+#include "mqtt_wrapper/mqtt_zentrios_wrapper.h"
+#include "string.h"
+
+/******************************************************
+ *                      Macros
+ ******************************************************/
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+#define MQTT_STORE_MAGIC                (0x5154514DUL)     /* "MQTQ" */
+#define MQTT_STORE_HEADER_SIZE          (16)
+#define MQTT_STORE_RECORD_HEADER_SIZE   (7)
+
+/******************************************************
+ *                   Enumerations
+ ******************************************************/
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+/******************************************************
+ *                    Structures
+ ******************************************************/
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+static void         mqtt_store_tick           ( void *arg );
+static void         mqtt_store_replay         ( mqtt_connection_t *conn );
+static void         mqtt_store_rewind         ( mqtt_store_t *store );
+static zos_result_t mqtt_store_load           ( mqtt_store_t *store );
+static zos_result_t mqtt_store_read_header    ( mqtt_store_t *store, uint32_t seq, uint32_t *handle, uint32_t *file_seq, uint32_t *length, uint32_t *crc );
+static void         mqtt_store_segment_name   ( const mqtt_store_t *store, uint32_t seq, char *name );
+static void         mqtt_store_put_u32        ( uint8_t *data, uint32_t value );
+static uint32_t     mqtt_store_get_u32        ( const uint8_t *data );
+static uint32_t     mqtt_store_crc32          ( const uint8_t *data, uint32_t length );
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+static void mqtt_store_put_u32( uint8_t *data, uint32_t value )
+{
+    data[0] = (uint8_t) ( value );
+    data[1] = (uint8_t) ( value >> 8 );
+    data[2] = (uint8_t) ( value >> 16 );
+    data[3] = (uint8_t) ( value >> 24 );
+}
+
+static uint32_t mqtt_store_get_u32( const uint8_t *data )
+{
+    return (uint32_t) data[0] | ( (uint32_t) data[1] << 8 ) | ( (uint32_t) data[2] << 16 ) | ( (uint32_t) data[3] << 24 );
+}
+
+static uint32_t mqtt_store_crc32( const uint8_t *data, uint32_t length )
+{
+    /* Nibble table of the reflected 0xEDB88320 polynomial */
+    static const uint32_t table[16] =
+    {
+        0x00000000UL, 0x1DB71064UL, 0x3B6E20C8UL, 0x26D930ACUL, 0x76DC4190UL, 0x6B6B51F4UL, 0x4DB26158UL, 0x5005713CUL,
+        0xEDB88320UL, 0xF00F9344UL, 0xD6D6A3E8UL, 0xCB61B38CUL, 0x9B64C2B0UL, 0x86D3D2D4UL, 0xA00AE278UL, 0xBDBDF21CUL
+    };
+    uint32_t crc = 0xFFFFFFFFUL;
+
+    while ( length-- > 0 )
+    {
+        crc ^= *data++;
+        crc = ( crc >> 4 ) ^ table[crc & 0x0F];
+        crc = ( crc >> 4 ) ^ table[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+static void mqtt_store_segment_name( const mqtt_store_t *store, uint32_t seq, char *name )
+{
+    uint32_t slot = seq % store->config.segment_count;
+    size_t len = strlen( store->name );
+    char digits[4];
+    int i = 0;
+
+    memcpy( name, store->name, len );
+    name[len++] = '.';
+    do
+    {
+        digits[i++] = (char) ( '0' + ( slot % 10 ) );
+        slot /= 10;
+    } while ( slot > 0 );
+    while ( i > 0 )
+    {
+        name[len++] = digits[--i];
+    }
+    name[len] = 0;
+}
+
+static zos_result_t mqtt_store_read_header( mqtt_store_t *store, uint32_t seq, uint32_t *handle, uint32_t *file_seq, uint32_t *length, uint32_t *crc )
+{
+    char name[MQTT_STORE_NAME_MAX + 4];
+    uint8_t header[MQTT_STORE_HEADER_SIZE];
+    uint32_t bytes_read = 0;
+
+    mqtt_store_segment_name( store, seq, name );
+    if ( mqtt_file_open( name, handle ) != ZOS_SUCCESS )
+    {
+        return ZOS_NOT_FOUND;
+    }
+
+    if ( ( mqtt_file_read( *handle, header, sizeof( header ), &bytes_read ) != ZOS_SUCCESS ) ||
+         ( bytes_read != sizeof( header ) ) ||
+         ( mqtt_store_get_u32( &header[0] ) != MQTT_STORE_MAGIC ) ||
+         ( mqtt_store_get_u32( &header[8] ) > store->config.segment_size ) )
+    {
+        /* Interrupted commit, the segment never became part of the queue */
+        mqtt_file_close( *handle );
+        mqtt_file_delete( name );
+        return ZOS_ERROR;
+    }
+
+    *file_seq = mqtt_store_get_u32( &header[4] );
+    *length = mqtt_store_get_u32( &header[8] );
+    *crc = mqtt_store_get_u32( &header[12] );
+    return ZOS_SUCCESS;
+}
+
+zos_result_t mqtt_store_init( const mqtt_store_config_t *config, mqtt_connection_t *conn )
+{
+    mqtt_store_t *store = NULL;
+    zos_bool_t found = ZOS_FALSE;
+    uint32_t seq;
+
+    if ( ( config->name == NULL ) || ( strlen( config->name ) >= MQTT_STORE_NAME_MAX - 8 ) ||
+         ( config->segment_count == 0 ) || ( config->segment_count > MQTT_STORE_MAX_SEGMENTS ) ||
+         ( config->segment_size == 0 ) || ( config->replay_period_ms == 0 ) || ( config->replay_count == 0 ) )
+    {
+        return ZOS_INVALID_ARG;
+    }
+
+    if ( conn->store != NULL )
+    {
+        mqtt_store_deinit( conn );
+    }
+
+    /* State and both buffers in one allocation, done once */
+    if ( ( mqtt_malloc( (uint8_t**) &store, sizeof( mqtt_store_t ) + 2 * config->segment_size ) != ZOS_SUCCESS ) || ( store == NULL ) )
+    {
+        return ZOS_NO_MEM;
+    }
+    memset( store, 0, sizeof( mqtt_store_t ) );
+    store->config = *config;
+    strcpy( store->name, config->name );
+    store->config.name = store->name;
+    store->batch = (uint8_t*) ( store + 1 );
+    store->replay = store->batch + config->segment_size;
+
+    /* Segments are committed and deleted in order, so the queue is the range of sequence numbers found */
+    for ( seq = 0; seq < config->segment_count; seq++ )
+    {
+        uint32_t handle, file_seq, length, crc;
+
+        if ( mqtt_store_read_header( store, seq, &handle, &file_seq, &length, &crc ) != ZOS_SUCCESS )
+        {
+            continue;
+        }
+        mqtt_file_close( handle );
+
+        if ( found == ZOS_FALSE || (int32_t) ( file_seq - store->head ) < 0 )
+        {
+            store->head = file_seq;
+        }
+        if ( found == ZOS_FALSE || (int32_t) ( file_seq + 1 - store->tail ) > 0 )
+        {
+            store->tail = file_seq + 1;
+        }
+        found = ZOS_TRUE;
+    }
+    MQTT_LOG( "Outbound queue holds %u segments", (unsigned) ( store->tail - store->head ) );
+
+    conn->store = store;
+    return mqtt_event_register_periodic( mqtt_store_tick, conn, config->replay_period_ms, 0 );
+}
+
+zos_result_t mqtt_store_deinit( mqtt_connection_t *conn )
+{
+    zos_result_t result;
+
+    if ( conn->store == NULL )
+    {
+        return ZOS_SUCCESS;
+    }
+
+    mqtt_event_unregister( mqtt_store_tick, conn );
+    result = mqtt_store_flush( conn );
+    mqtt_free( conn->store );
+    conn->store = NULL;
+
+    return result;
+}
+
+zos_result_t mqtt_store_append( const uint8_t *topic, uint16_t topic_len, const uint8_t *data, uint32_t data_len, uint8_t qos, mqtt_connection_t *conn )
+{
+    mqtt_store_t *store = conn->store;
+    uint32_t size = MQTT_STORE_RECORD_HEADER_SIZE + topic_len + 1 + data_len;
+    uint8_t *record;
+
+    if ( store == NULL )
+    {
+        return ZOS_ERROR;
+    }
+    if ( size > store->config.segment_size )
+    {
+        return ZOS_INVALID_ARG;
+    }
+
+    if ( store->batch_length + size > store->config.segment_size )
+    {
+        zos_result_t result = mqtt_store_flush( conn );
+        if ( result != ZOS_SUCCESS )
+        {
+            return result;
+        }
+    }
+
+    if ( store->batch_length == 0 )
+    {
+        store->batch_age_ms = 0;
+    }
+
+    record = &store->batch[store->batch_length];
+    record[0] = (uint8_t) ( topic_len );
+    record[1] = (uint8_t) ( topic_len >> 8 );
+    mqtt_store_put_u32( &record[2], data_len );
+    record[6] = qos;
+    memcpy( &record[MQTT_STORE_RECORD_HEADER_SIZE], topic, topic_len );
+    record[MQTT_STORE_RECORD_HEADER_SIZE + topic_len] = 0;
+    memcpy( &record[MQTT_STORE_RECORD_HEADER_SIZE + topic_len + 1], data, data_len );
+    store->batch_length += size;
+
+    return ZOS_SUCCESS;
+}
+
+zos_result_t mqtt_store_flush( mqtt_connection_t *conn )
+{
+    mqtt_store_t *store = conn->store;
+    char name[MQTT_STORE_NAME_MAX + 4];
+    uint8_t header[MQTT_STORE_HEADER_SIZE];
+    uint32_t handle;
+    zos_result_t result;
+
+    if ( ( store == NULL ) || ( store->batch_length == 0 ) )
+    {
+        return ZOS_SUCCESS;
+    }
+
+    if ( store->tail - store->head >= store->config.segment_count )
+    {
+        MQTT_LOG( "Outbound queue full" );
+        return ZOS_NO_MEM;
+    }
+
+    mqtt_store_put_u32( &header[0], MQTT_STORE_MAGIC );
+    mqtt_store_put_u32( &header[4], store->tail );
+    mqtt_store_put_u32( &header[8], store->batch_length );
+    mqtt_store_put_u32( &header[12], mqtt_store_crc32( store->batch, store->batch_length ) );
+
+    mqtt_store_segment_name( store, store->tail, name );
+    mqtt_file_delete( name );
+    result = mqtt_file_create( name, MQTT_STORE_HEADER_SIZE + store->batch_length, &handle );
+    if ( result != ZOS_SUCCESS )
+    {
+        return result;
+    }
+
+    /* The whole batch goes out in one write */
+    if ( ( ( result = mqtt_file_write( handle, header, sizeof( header ) ) ) != ZOS_SUCCESS ) ||
+         ( ( result = mqtt_file_write( handle, store->batch, store->batch_length ) ) != ZOS_SUCCESS ) )
+    {
+        mqtt_file_close( handle );
+        mqtt_file_delete( name );
+        return result;
+    }
+    mqtt_file_close( handle );
+
+    store->tail++;
+    store->batch_length = 0;
+
+    return ZOS_SUCCESS;
+}
+
+void mqtt_store_resume( mqtt_connection_t *conn )
+{
+    if ( conn->store != NULL )
+    {
+        mqtt_store_rewind( conn->store );
+        conn->store->online = ZOS_TRUE;
+    }
+}
+
+void mqtt_store_acked( uint16_t packet_id, mqtt_connection_t *conn )
+{
+    mqtt_store_t *store = conn->store;
+    uint16_t i;
+
+    if ( store == NULL )
+    {
+        return;
+    }
+
+    for ( i = 0; i < store->pending_count; i++ )
+    {
+        if ( store->pending[i].packet_id == packet_id )
+        {
+            store->pending[i] = store->pending[--store->pending_count];
+            return;
+        }
+    }
+}
+
+/* Messages that were not acknowledged on the lost connection are published again */
+static void mqtt_store_rewind( mqtt_store_t *store )
+{
+    uint16_t i;
+
+    for ( i = 0; i < store->pending_count; i++ )
+    {
+        if ( store->pending[i].offset < store->replay_offset )
+        {
+            store->replay_offset = store->pending[i].offset;
+        }
+    }
+    store->pending_count = 0;
+}
+
+static zos_result_t mqtt_store_load( mqtt_store_t *store )
+{
+    uint32_t handle, file_seq, length, crc;
+    uint32_t bytes_read = 0;
+    zos_result_t result;
+
+    result = mqtt_store_read_header( store, store->head, &handle, &file_seq, &length, &crc );
+    if ( result == ZOS_SUCCESS )
+    {
+        /* The header is written before the messages, only the CRC shows they all made it */
+        if ( ( file_seq != store->head ) ||
+             ( mqtt_file_read( handle, store->replay, length, &bytes_read ) != ZOS_SUCCESS ) ||
+             ( bytes_read != length ) ||
+             ( mqtt_store_crc32( store->replay, length ) != crc ) )
+        {
+            result = ZOS_ERROR;
+        }
+        mqtt_file_close( handle );
+    }
+
+    if ( result != ZOS_SUCCESS )
+    {
+        char name[MQTT_STORE_NAME_MAX + 4];
+
+        /* Unreadable segment, skip it rather than block the queue */
+        MQTT_LOG( "Dropping unreadable segment %u", (unsigned) store->head );
+        mqtt_store_segment_name( store, store->head, name );
+        mqtt_file_delete( name );
+        store->head++;
+        return result;
+    }
+
+    store->replay_length = length;
+    store->replay_offset = 0;
+    store->replay_loaded = ZOS_TRUE;
+
+    return ZOS_SUCCESS;
+}
+
+static void mqtt_store_replay( mqtt_connection_t *conn )
+{
+    mqtt_store_t *store = conn->store;
+    uint16_t count = 0;
+
+    while ( count < store->config.replay_count )
+    {
+        uint8_t *record;
+        uint16_t topic_len;
+        uint32_t data_len;
+        uint8_t qos;
+        mqtt_msgid_t id;
+
+        if ( store->replay_loaded == ZOS_FALSE )
+        {
+            if ( store->head == store->tail )
+            {
+                break;
+            }
+            if ( mqtt_store_load( store ) != ZOS_SUCCESS )
+            {
+                continue;
+            }
+        }
+
+        if ( store->replay_offset + MQTT_STORE_RECORD_HEADER_SIZE > store->replay_length )
+        {
+            char name[MQTT_STORE_NAME_MAX + 4];
+
+            if ( store->pending_count > 0 )
+            {
+                /* Segment sent, waiting for the last acknowledgements */
+                break;
+            }
+            mqtt_store_segment_name( store, store->head, name );
+            mqtt_file_delete( name );
+            store->head++;
+            store->replay_loaded = ZOS_FALSE;
+            continue;
+        }
+
+        record = &store->replay[store->replay_offset];
+        topic_len = (uint16_t) ( record[0] | ( record[1] << 8 ) );
+        data_len = mqtt_store_get_u32( &record[2] );
+        qos = record[6];
+
+        if ( data_len > store->replay_length - store->replay_offset - MQTT_STORE_RECORD_HEADER_SIZE - topic_len - 1 ||
+             topic_len > store->replay_length - store->replay_offset - MQTT_STORE_RECORD_HEADER_SIZE - 1 )
+        {
+            /* Truncated message, nothing after it can be trusted */
+            store->replay_offset = store->replay_length;
+            continue;
+        }
+
+        if ( ( qos != MQTT_QOS_DELIVER_AT_MOST_ONCE ) &&
+             ( ( store->pending_count >= MQTT_QUEUE_SIZE ) || ( mqtt_get_publish_window_free( conn ) == 0 ) ) )
+        {
+            break;
+        }
+
+        id = mqtt_publish( conn, &record[MQTT_STORE_RECORD_HEADER_SIZE], &record[MQTT_STORE_RECORD_HEADER_SIZE + topic_len + 1], data_len, qos );
+        if ( id == 0 )
+        {
+            break;
+        }
+        if ( qos != MQTT_QOS_DELIVER_AT_MOST_ONCE )
+        {
+            store->pending[store->pending_count].packet_id = id;
+            store->pending[store->pending_count].offset = store->replay_offset;
+            store->pending_count++;
+        }
+
+        store->replay_offset += MQTT_STORE_RECORD_HEADER_SIZE + topic_len + 1 + data_len;
+        count++;
+    }
+}
+
+static void mqtt_store_tick( void *arg )
+{
+    mqtt_connection_t *conn = (mqtt_connection_t *) arg;
+    mqtt_store_t *store = conn->store;
+
+    store->batch_age_ms += store->config.replay_period_ms;
+    if ( ( store->batch_length > 0 ) && ( store->batch_age_ms >= store->config.commit_period_ms ) )
+    {
+        mqtt_store_flush( conn );
+    }
+
+    if ( conn->net_init_ok != ZOS_TRUE )
+    {
+        if ( store->online == ZOS_TRUE )
+        {
+            store->online = ZOS_FALSE;
+            mqtt_store_rewind( store );
+        }
+        return;
+    }
+
+    if ( store->online == ZOS_TRUE )
+    {
+        mqtt_store_replay( conn );
+    }
+}
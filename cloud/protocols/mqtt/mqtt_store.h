@@ -0,0 +1,89 @@
+/*
+ * Copyright 2015, Broadcom Corporation
+ * All Rights Reserved.
+ *
+ * This is UNPUBLISHED PROPRIETARY SOURCE CODE of Broadcom Corporation;
+ * the contents of this file may not be disclosed to third parties, copied
+ * or duplicated in any form, in whole or in part, without the prior
+ * written permission of Broadcom Corporation.
+ */
+
+/** @file
+ *  MQTT persistent outbound queue.
+ *
+ *  Internal functions not to be used directly by applications.
+ */
+#pragma once
+
+#include "zos_types.h"
+#include "mqtt_internal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************
+ *                      Macros
+ ******************************************************/
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+#define MQTT_STORE_NAME_MAX             (32)
+
+/******************************************************
+ *                   Enumerations
+ ******************************************************/
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+typedef struct mqtt_store_pending_s
+{
+    uint16_t                    packet_id;
+    uint32_t                    offset;         /* Offset of the message in the replayed segment */
+} mqtt_store_pending_t;
+
+typedef struct mqtt_store_s
+{
+    mqtt_store_config_t         config;
+    char                        name[MQTT_STORE_NAME_MAX];
+    uint32_t                    head;           /* Sequence number of the oldest committed segment */
+    uint32_t                    tail;           /* Sequence number of the next segment to commit */
+    uint8_t                    *batch;          /* Messages not committed yet, segment_size bytes */
+    uint32_t                    batch_length;
+    uint32_t                    batch_age_ms;
+    uint8_t                    *replay;         /* Segment being replayed, segment_size bytes */
+    uint32_t                    replay_length;
+    uint32_t                    replay_offset;  /* Next message to publish */
+    zos_bool_t                  replay_loaded;
+    zos_bool_t                  online;         /* CONNACK received on the current connection */
+    uint16_t                    pending_count;
+    mqtt_store_pending_t        pending[MQTT_QUEUE_SIZE];   /* Replayed messages waiting for PUBACK/PUBCOMP */
+} mqtt_store_t;
+
+/******************************************************
+ *                    Structures
+ ******************************************************/
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+zos_result_t mqtt_store_init    ( const mqtt_store_config_t *config, mqtt_connection_t *conn );
+zos_result_t mqtt_store_deinit  ( mqtt_connection_t *conn );
+zos_result_t mqtt_store_append  ( const uint8_t *topic, uint16_t topic_len, const uint8_t *data, uint32_t data_len, uint8_t qos, mqtt_connection_t *conn );
+zos_result_t mqtt_store_flush   ( mqtt_connection_t *conn );
+void         mqtt_store_resume  ( mqtt_connection_t *conn );
+void         mqtt_store_acked   ( uint16_t packet_id, mqtt_connection_t *conn );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -44,6 +44,11 @@ zos_result_t mqtt_tcp_write(uint32_t handle, const void *data, uint32_t size, zo
     return zn_tcp_write(handle, data, size, auto_flush);
 }
 
+zos_result_t mqtt_tcp_flush(uint32_t handle)
+{
+    return zn_tcp_flush(handle);
+}
+
 zos_result_t mqtt_malloc(uint8_t **ptr, uint32_t size)
 {
     return zn_malloc(ptr, size);
@@ -64,6 +69,48 @@ zos_result_t mqtt_event_register_periodic(zos_event_handler_t handler, void *arg
     return zn_event_register_periodic(handler, arg, period_ms, flags);
 }
 
+zos_result_t mqtt_event_issue(zos_event_handler_t handler, void *arg, zos_event_flag_t flags)
+{
+    return zn_event_issue(handler, arg, flags);
+}
+
+zos_result_t mqtt_file_create(const char *name, uint32_t size, uint32_t *handle)
+{
+    zos_file_t file;
+
+    memset(&file, 0, sizeof(file));
+    strncpy(file.name, name, sizeof(file.name) - 1);
+    file.size = size;
+    file.type = ZOS_FILE_TYPE_MISC_FIX_LEN;
+
+    return zn_file_create(&file, handle);
+}
+
+zos_result_t mqtt_file_open(const char *name, uint32_t *handle)
+{
+    return zn_file_open(name, handle);
+}
+
+zos_result_t mqtt_file_write(uint32_t handle, const void *data, uint32_t size)
+{
+    return zn_file_write(handle, data, size);
+}
+
+zos_result_t mqtt_file_read(uint32_t handle, void *data, uint32_t size, uint32_t *bytes_read)
+{
+    return zn_file_read(handle, data, size, bytes_read);
+}
+
+zos_result_t mqtt_file_close(uint32_t handle)
+{
+    return zn_file_close(handle);
+}
+
+zos_result_t mqtt_file_delete(const char *name)
+{
+    return zn_file_delete(name);
+}
+
 void mqtt_log(const char *fmt, ...)
 {
     va_list args;
@@ -27,6 +27,8 @@ zos_result_t mqtt_tcp_read(uint32_t handle, void *data, uint32_t max_size, uint3
 
 zos_result_t mqtt_tcp_write(uint32_t handle, const void *data, uint32_t size, zos_bool_t auto_flush);
 
+zos_result_t mqtt_tcp_flush(uint32_t handle);
+
 zos_result_t mqtt_malloc(uint8_t **ptr, uint32_t size);
 
 zos_result_t mqtt_free(void *ptr);
@@ -35,6 +37,20 @@ zos_result_t mqtt_event_unregister(zos_event_handler_t handler, void *arg);
 
 zos_result_t mqtt_event_register_periodic(zos_event_handler_t handler, void *arg, uint32_t period_ms, zos_event_flag_t flags);
 
+zos_result_t mqtt_event_issue(zos_event_handler_t handler, void *arg, zos_event_flag_t flags);
+
+zos_result_t mqtt_file_create(const char *name, uint32_t size, uint32_t *handle);
+
+zos_result_t mqtt_file_open(const char *name, uint32_t *handle);
+
+zos_result_t mqtt_file_write(uint32_t handle, const void *data, uint32_t size);
+
+zos_result_t mqtt_file_read(uint32_t handle, void *data, uint32_t size, uint32_t *bytes_read);
+
+zos_result_t mqtt_file_close(uint32_t handle);
+
+zos_result_t mqtt_file_delete(const char *name);
+
 void mqtt_log(const char *fmt, ...);
 
 #ifdef DEBUG
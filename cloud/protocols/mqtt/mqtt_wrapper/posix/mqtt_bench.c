@@ -0,0 +1,254 @@
+/*
+ * ZentriOS SDK LICENSE AGREEMENT | Zentri.com, 2016.
+ *
+ * Use of source code and/or libraries contained in the ZentriOS SDK is
+ * subject to the Zentri Operating System SDK license agreement and
+ * applicable open source license agreements.
+ *
+ */
+
+/*
+ * Host throughput benchmark for the MQTT library.
+ *
+ * Connects to the loopback broker in the same process and publishes the
+ * same message over and over at QoS 0, 1 and 2, reporting per level:
+ *  - messages and payload megabytes per second, until the last one is acknowledged
+ *    (QoS 1/2) or has reached the broker (QoS 0)
+ *  - PUBLISH to PUBACK/PUBCOMP latency percentiles, QoS 1/2 only
+ *  - mqtt_malloc() calls and TCP writes per message
+ *
+ * Build and run from cloud/protocols/mqtt:
+ *
+ *   gcc -O2 -std=gnu99 -Imqtt_wrapper/posix -I. mqtt_*.c \
+ *       mqtt_wrapper/posix/mqtt_posix_wrapper.c mqtt_wrapper/posix/mqtt_loopback_broker.c \
+ *       mqtt_wrapper/posix/mqtt_bench.c -o mqtt_bench
+ *   ./mqtt_bench [-n messages] [-s payload_size] [-w publish_window]
+ */
+
+#include "mqtt_api.h"
+#include "mqtt_posix_wrapper.h"
+#include "mqtt_loopback_broker.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+
+#define BENCH_TOPIC         "bench/data"
+#define BENCH_TIMEOUT_US    (10 * 1000000ULL)
+#define BENCH_POLL_EVERY    32      // QoS 0 messages published between two loop passes
+
+
+typedef struct
+{
+    zos_bool_t connected;
+    zos_bool_t failed;
+    uint32_t acked;
+    uint64_t sent_us[65536];        // Send time by packet id
+    uint32_t *latency_us;
+} bench_state_t;
+
+
+static zos_result_t bench_callback(mqtt_event_info_t *event);
+static zos_bool_t bench_wait(zos_bool_t *done, uint64_t deadline);
+static zos_bool_t bench_run(uint8_t qos, uint32_t count, uint8_t *payload, uint32_t size);
+static int compare_u32(const void *a, const void *b);
+
+
+static mqtt_connection_t connection;
+static bench_state_t state;
+
+
+
+/*************************************************************************************************/
+int main(int argc, char *argv[])
+{
+    mqtt_pkt_connect_t conninfo;
+    uint32_t count = 10000, size = 64, window = MQTT_QUEUE_SIZE;
+    uint16_t port;
+    uint8_t *payload;
+    zos_bool_t ok = ZOS_TRUE;
+    int opt;
+
+    while((opt = getopt(argc, argv, "n:s:w:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'n': count = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 's': size = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'w': window = (uint32_t)strtoul(optarg, NULL, 0); break;
+        default:
+            fprintf(stderr, "usage: %s [-n messages] [-s payload_size] [-w publish_window]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    payload = malloc(size + 1);
+    state.latency_us = malloc(sizeof(uint32_t) * (count + 1));
+    if(payload == NULL || state.latency_us == NULL || count == 0)
+    {
+        return 1;
+    }
+    memset(payload, 'x', size);
+
+    if(mqtt_loopback_broker_start(0, &port) != ZOS_SUCCESS ||
+       mqtt_init(&connection) != ZOS_SUCCESS ||
+       mqtt_open(&connection, "127.0.0.1", port, ZOS_WLAN, bench_callback, ZOS_FALSE) != ZOS_SUCCESS)
+    {
+        fprintf(stderr, "Failed to open the connection\n");
+        return 1;
+    }
+
+    memset(&conninfo, 0, sizeof(conninfo));
+    conninfo.mqtt_version = MQTT_PROTOCOL_VER4;
+    conninfo.clean_session = 1;
+    conninfo.client_id = (uint8_t*)"mqtt_bench";
+    conninfo.keep_alive = 60;
+
+    if(mqtt_connect(&connection, &conninfo) != ZOS_SUCCESS ||
+       !bench_wait(&state.connected, mqtt_posix_time_us() + BENCH_TIMEOUT_US))
+    {
+        fprintf(stderr, "Failed to connect\n");
+        return 1;
+    }
+
+    mqtt_set_publish_window(&connection, (uint16_t)window);
+
+    printf("%u messages, %u byte payload, publish window %u\n\n", count, size, window);
+    printf("qos     msg/s     MB/s   p50 us   p90 us   p99 us   max us  allocs/msg  writes/msg\n");
+
+    for(uint8_t qos = MQTT_QOS_DELIVER_AT_MOST_ONCE; qos <= MQTT_QOS_DELIVER_EXACTLY_ONCE && ok; ++qos)
+    {
+        ok = bench_run(qos, count, payload, size);
+    }
+
+    mqtt_disconnect(&connection);
+    mqtt_posix_poll(0);
+    mqtt_deinit(&connection);
+    mqtt_loopback_broker_stop();
+
+    free(state.latency_us);
+    free(payload);
+
+    return ok ? 0 : 1;
+}
+
+
+
+/*************************************************************************************************/
+static zos_result_t bench_callback(mqtt_event_info_t *event)
+{
+    switch(event->type)
+    {
+    case MQTT_EVENT_TYPE_CONNECTED:
+        state.connected = ZOS_TRUE;
+        break;
+
+    case MQTT_EVENT_TYPE_DISCONNECTED:
+        state.failed = ZOS_TRUE;
+        break;
+
+    case MQTT_EVENT_TYPE_PUBLISHED:
+        state.latency_us[state.acked++] = (uint32_t)(mqtt_posix_time_us() - state.sent_us[event->data.msgid]);
+        break;
+
+    default:
+        break;
+    }
+
+    return ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+static zos_bool_t bench_wait(zos_bool_t *done, uint64_t deadline)
+{
+    while(!*done && !state.failed && mqtt_posix_time_us() < deadline)
+    {
+        mqtt_posix_poll(10);
+    }
+
+    return (*done && !state.failed) ? ZOS_TRUE : ZOS_FALSE;
+}
+
+/*************************************************************************************************/
+static zos_bool_t bench_run(uint8_t qos, uint32_t count, uint8_t *payload, uint32_t size)
+{
+    mqtt_loopback_broker_stats_t broker;
+    mqtt_posix_stats_t before, after;
+    uint64_t start, elapsed, deadline;
+    uint32_t sent = 0, received;
+
+    mqtt_posix_poll(0);
+    mqtt_loopback_broker_get_stats(&broker);
+    received = broker.publishes[qos];
+    mqtt_posix_get_stats(&before);
+    state.acked = 0;
+
+    start = mqtt_posix_time_us();
+    deadline = start + BENCH_TIMEOUT_US;
+
+    while(sent < count && !state.failed && mqtt_posix_time_us() < deadline)
+    {
+        if(qos != MQTT_QOS_DELIVER_AT_MOST_ONCE && mqtt_get_publish_window_free(&connection) == 0)
+        {
+            // Wait for an acknowledgement to free a slot
+            mqtt_posix_poll(10);
+            continue;
+        }
+
+        // The packet id can legitimately be 0 when it wraps, so it is not checked
+        state.sent_us[(uint16_t)(connection.packet_id + 1)] = mqtt_posix_time_us();
+        mqtt_publish(&connection, (uint8_t*)BENCH_TOPIC, payload, size, qos);
+        ++sent;
+
+        if(qos == MQTT_QOS_DELIVER_AT_MOST_ONCE && (sent % BENCH_POLL_EVERY) == 0)
+        {
+            mqtt_posix_poll(0);
+        }
+    }
+
+    // Done once everything is acknowledged, or at QoS 0 once the broker has it all
+    for(;;)
+    {
+        mqtt_loopback_broker_get_stats(&broker);
+        if(state.failed || mqtt_posix_time_us() >= deadline ||
+           ((qos == MQTT_QOS_DELIVER_AT_MOST_ONCE) ? (broker.publishes[qos] - received >= count) : (state.acked >= count)))
+        {
+            break;
+        }
+        mqtt_posix_poll(10);
+    }
+
+    elapsed = mqtt_posix_time_us() - start;
+    mqtt_posix_get_stats(&after);
+
+    if(state.failed || sent < count || (qos != MQTT_QOS_DELIVER_AT_MOST_ONCE && state.acked < count))
+    {
+        fprintf(stderr, "QoS %u run failed after %u of %u messages\n", qos, (qos ? state.acked : sent), count);
+        return ZOS_FALSE;
+    }
+
+    printf("%3u %9.0f %8.2f", qos, count * 1e6 / elapsed, (double)count * size / elapsed);
+    if(qos == MQTT_QOS_DELIVER_AT_MOST_ONCE)
+    {
+        printf("        -        -        -        -");
+    }
+    else
+    {
+        qsort(state.latency_us, count, sizeof(uint32_t), compare_u32);
+        printf(" %8u %8u %8u %8u", state.latency_us[count / 2], state.latency_us[(uint64_t)count * 90 / 100],
+                                   state.latency_us[(uint64_t)count * 99 / 100], state.latency_us[count - 1]);
+    }
+    printf(" %11.2f %11.2f\n", (double)(after.malloc_count - before.malloc_count) / count,
+                               (double)(after.send_calls - before.send_calls) / count);
+
+    return ZOS_TRUE;
+}
+
+/*************************************************************************************************/
+static int compare_u32(const void *a, const void *b)
+{
+    const uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+
+    return (x > y) - (x < y);
+}
@@ -0,0 +1,448 @@
+/*
+ * ZentriOS SDK LICENSE AGREEMENT | Zentri.com, 2016.
+ *
+ * Use of source code and/or libraries contained in the ZentriOS SDK is
+ * subject to the Zentri Operating System SDK license agreement and
+ * applicable open source license agreements.
+ *
+ */
+
+#include "mqtt_wrapper/mqtt_zentrios_wrapper.h"
+#include "mqtt_posix_wrapper.h"
+#include "mqtt_loopback_broker.h"
+
+
+#define RX_BUFFER_MIN_SIZE  4096
+
+#define PACKET_CONNECT      1
+#define PACKET_PUBLISH      3
+#define PACKET_PUBREL       6
+#define PACKET_SUBSCRIBE    8
+#define PACKET_UNSUBSCRIBE  10
+#define PACKET_PINGREQ      12
+#define PACKET_DISCONNECT   14
+
+#define READ_U16(p)         (uint16_t)(((p)[0] << 8) | (p)[1])
+
+
+typedef struct
+{
+    uint32_t handle;                                            // 0: entry is free
+    uint8_t *rx;
+    uint32_t rx_length;
+    uint32_t rx_size;
+    char *subscriptions[MQTT_LOOPBACK_MAX_SUBSCRIPTIONS];
+} broker_client_t;
+
+
+static void broker_accept_handler(uint32_t handle);
+static void broker_receive_handler(uint32_t handle);
+static void broker_disconnect_handler(uint32_t handle);
+static broker_client_t* broker_find_client(uint32_t handle);
+static void broker_client_close(broker_client_t *client);
+static zos_bool_t broker_process(broker_client_t *client, uint8_t type_flags, const uint8_t *p, uint32_t length);
+static void broker_publish(const uint8_t *topic, uint16_t topic_len, const uint8_t *payload, uint32_t payload_len);
+static void broker_subscribe(broker_client_t *client, const uint8_t *filter, uint16_t filter_len, uint8_t *granted);
+static void broker_unsubscribe(broker_client_t *client, const uint8_t *filter, uint16_t filter_len);
+static void broker_send_ack(uint32_t handle, uint8_t header, const uint8_t *id);
+static zos_bool_t topic_matches(const char *filter, const uint8_t *topic, uint16_t topic_len);
+
+
+static broker_client_t clients[MQTT_LOOPBACK_MAX_CLIENTS];
+static mqtt_loopback_broker_stats_t stats;
+static uint32_t listen_handle;
+
+
+
+/*************************************************************************************************/
+zos_result_t mqtt_loopback_broker_start(uint16_t port, uint16_t *bound_port)
+{
+    memset(clients, 0, sizeof(clients));
+    memset(&stats, 0, sizeof(stats));
+
+    return mqtt_posix_listen(port, broker_accept_handler, &listen_handle, bound_port);
+}
+
+/*************************************************************************************************/
+void mqtt_loopback_broker_stop(void)
+{
+    for(int i = 0; i < MQTT_LOOPBACK_MAX_CLIENTS; ++i)
+    {
+        if(clients[i].handle != 0)
+        {
+            mqtt_tcp_disconnect(clients[i].handle);
+            broker_client_close(&clients[i]);
+        }
+    }
+
+    if(listen_handle != 0)
+    {
+        mqtt_tcp_disconnect(listen_handle);
+        listen_handle = 0;
+    }
+}
+
+/*************************************************************************************************/
+void mqtt_loopback_broker_get_stats(mqtt_loopback_broker_stats_t *out)
+{
+    *out = stats;
+}
+
+
+
+/*************************************************************************************************/
+static void broker_accept_handler(uint32_t handle)
+{
+    uint32_t client_handle;
+
+    while(mqtt_posix_accept(handle, &client_handle) == ZOS_SUCCESS)
+    {
+        broker_client_t *client = broker_find_client(0);
+
+        if(client == NULL)
+        {
+            mqtt_tcp_disconnect(client_handle);
+            continue;
+        }
+
+        client->handle = client_handle;
+        mqtt_tcp_register_client_event_handlers(client_handle, broker_disconnect_handler, broker_receive_handler);
+    }
+}
+
+/*************************************************************************************************/
+static void broker_receive_handler(uint32_t handle)
+{
+    broker_client_t *client = broker_find_client(handle);
+
+    while(client != NULL && client->handle == handle)
+    {
+        uint32_t bytes_read, offset = 0;
+
+        if(client->rx_length == client->rx_size)
+        {
+            const uint32_t new_size = MAX(client->rx_size * 2, RX_BUFFER_MIN_SIZE);
+            uint8_t *rx = realloc(client->rx, new_size);
+
+            if(rx == NULL)
+            {
+                break;
+            }
+            client->rx = rx;
+            client->rx_size = new_size;
+        }
+
+        if(mqtt_tcp_read(handle, &client->rx[client->rx_length], client->rx_size - client->rx_length, &bytes_read) != ZOS_SUCCESS || bytes_read == 0)
+        {
+            break;
+        }
+        client->rx_length += bytes_read;
+
+        // Handle every complete packet, the remaining length is 1 to 4 bytes
+        while(client->rx_length - offset >= 2)
+        {
+            const uint8_t *p = &client->rx[offset];
+            const uint32_t available = client->rx_length - offset;
+            uint32_t length = 0, header_size = 1;
+
+            do
+            {
+                length |= (uint32_t)(p[header_size] & 0x7F) << (7 * (header_size - 1));
+            } while((p[header_size++] & 0x80) && header_size < 5 && header_size < available);
+
+            if((p[header_size - 1] & 0x80) || header_size + length > available)
+            {
+                break;
+            }
+            if(!broker_process(client, p[0], &p[header_size], length))
+            {
+                mqtt_tcp_disconnect(handle);
+                broker_client_close(client);
+                return;
+            }
+            offset += header_size + length;
+        }
+
+        client->rx_length -= offset;
+        memmove(client->rx, &client->rx[offset], client->rx_length);
+    }
+}
+
+/*************************************************************************************************/
+static void broker_disconnect_handler(uint32_t handle)
+{
+    broker_client_t *client = broker_find_client(handle);
+
+    if(client != NULL)
+    {
+        mqtt_tcp_disconnect(handle);
+        broker_client_close(client);
+    }
+}
+
+/*************************************************************************************************/
+static broker_client_t* broker_find_client(uint32_t handle)
+{
+    for(int i = 0; i < MQTT_LOOPBACK_MAX_CLIENTS; ++i)
+    {
+        if(clients[i].handle == handle)
+        {
+            return &clients[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*************************************************************************************************/
+static void broker_client_close(broker_client_t *client)
+{
+    for(int i = 0; i < MQTT_LOOPBACK_MAX_SUBSCRIPTIONS; ++i)
+    {
+        free(client->subscriptions[i]);
+    }
+    free(client->rx);
+    memset(client, 0, sizeof(broker_client_t));
+}
+
+/*************************************************************************************************/
+static zos_bool_t broker_process(broker_client_t *client, uint8_t type_flags, const uint8_t *p, uint32_t length)
+{
+    const uint8_t *end = p + length;
+
+    switch(type_flags >> 4)
+    {
+    case PACKET_CONNECT:
+    {
+        const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+
+        ++stats.connects;
+        mqtt_tcp_write(client->handle, connack, sizeof(connack), ZOS_FALSE);
+        break;
+    }
+
+    case PACKET_PUBLISH:
+    {
+        const uint8_t qos = (type_flags >> 1) & 0x03;
+        uint16_t topic_len;
+        const uint8_t *topic, *payload;
+
+        if(length < 2 || qos > 2 || (topic_len = READ_U16(p)) + 2u + (qos ? 2u : 0u) > length)
+        {
+            return ZOS_FALSE;
+        }
+        topic = p + 2;
+        payload = topic + topic_len + (qos ? 2 : 0);
+
+        ++stats.publishes[qos];
+        stats.payload_bytes += (uint64_t)(end - payload);
+
+        if(qos == 1)
+        {
+            broker_send_ack(client->handle, 0x40, topic + topic_len);
+        }
+        else if(qos == 2)
+        {
+            broker_send_ack(client->handle, 0x50, topic + topic_len);
+        }
+        broker_publish(topic, topic_len, payload, (uint32_t)(end - payload));
+        break;
+    }
+
+    case PACKET_PUBREL:
+        if(length < 2)
+        {
+            return ZOS_FALSE;
+        }
+        broker_send_ack(client->handle, 0x70, p);
+        break;
+
+    case PACKET_SUBSCRIBE:
+    case PACKET_UNSUBSCRIBE:
+    {
+        const zos_bool_t subscribe = ((type_flags >> 4) == PACKET_SUBSCRIBE);
+        uint8_t reply[4 + MQTT_LOOPBACK_MAX_SUBSCRIPTIONS];
+        uint8_t count = 0;
+
+        if(length < 2)
+        {
+            return ZOS_FALSE;
+        }
+        reply[2] = p[0];
+        reply[3] = p[1];
+
+        for(p += 2; p + 2 <= end; )
+        {
+            const uint16_t filter_len = READ_U16(p);
+
+            if(p + 2 + filter_len + (subscribe ? 1 : 0) > end || count == MQTT_LOOPBACK_MAX_SUBSCRIPTIONS)
+            {
+                return ZOS_FALSE;
+            }
+            if(subscribe)
+            {
+                broker_subscribe(client, p + 2, filter_len, &reply[4 + count++]);
+                p += 3 + filter_len;
+            }
+            else
+            {
+                broker_unsubscribe(client, p + 2, filter_len);
+                p += 2 + filter_len;
+            }
+        }
+
+        reply[0] = subscribe ? 0x90 : 0xB0;
+        reply[1] = 2 + count;
+        mqtt_tcp_write(client->handle, reply, 4 + count, ZOS_FALSE);
+        break;
+    }
+
+    case PACKET_PINGREQ:
+    {
+        const uint8_t pingresp[] = { 0xD0, 0x00 };
+
+        mqtt_tcp_write(client->handle, pingresp, sizeof(pingresp), ZOS_FALSE);
+        break;
+    }
+
+    case PACKET_DISCONNECT:
+        return ZOS_FALSE;
+
+    default:
+        // PUBACK, PUBREC and PUBCOMP for messages delivered at QoS 0 can't happen
+        break;
+    }
+
+    return ZOS_TRUE;
+}
+
+/*************************************************************************************************/
+static void broker_publish(const uint8_t *topic, uint16_t topic_len, const uint8_t *payload, uint32_t payload_len)
+{
+    for(int i = 0; i < MQTT_LOOPBACK_MAX_CLIENTS; ++i)
+    {
+        for(int j = 0; clients[i].handle != 0 && j < MQTT_LOOPBACK_MAX_SUBSCRIPTIONS; ++j)
+        {
+            if(clients[i].subscriptions[j] != NULL && topic_matches(clients[i].subscriptions[j], topic, topic_len))
+            {
+                uint8_t header[9];
+                uint32_t remaining = 2 + topic_len + payload_len;
+                uint32_t n = 0;
+
+                header[n++] = 0x30;
+                do
+                {
+                    header[n] = remaining & 0x7F;
+                    remaining >>= 7;
+                    header[n++] |= (remaining > 0) ? 0x80 : 0;
+                } while(remaining > 0);
+                header[n++] = topic_len >> 8;
+                header[n++] = topic_len & 0xFF;
+
+                mqtt_tcp_write(clients[i].handle, header, n, ZOS_FALSE);
+                mqtt_tcp_write(clients[i].handle, topic, topic_len, ZOS_FALSE);
+                mqtt_tcp_write(clients[i].handle, payload, payload_len, ZOS_FALSE);
+                ++stats.delivered;
+                break;
+            }
+        }
+    }
+}
+
+/*************************************************************************************************/
+static void broker_subscribe(broker_client_t *client, const uint8_t *filter, uint16_t filter_len, uint8_t *granted)
+{
+    char **free_entry = NULL;
+
+    broker_unsubscribe(client, filter, filter_len);
+
+    for(int i = 0; i < MQTT_LOOPBACK_MAX_SUBSCRIPTIONS && free_entry == NULL; ++i)
+    {
+        free_entry = (client->subscriptions[i] == NULL) ? &client->subscriptions[i] : NULL;
+    }
+
+    *granted = 0x80;
+    if(free_entry != NULL && (*free_entry = malloc(filter_len + 1)) != NULL)
+    {
+        memcpy(*free_entry, filter, filter_len);
+        (*free_entry)[filter_len] = '\0';
+        *granted = 0;
+    }
+}
+
+/*************************************************************************************************/
+static void broker_unsubscribe(broker_client_t *client, const uint8_t *filter, uint16_t filter_len)
+{
+    for(int i = 0; i < MQTT_LOOPBACK_MAX_SUBSCRIPTIONS; ++i)
+    {
+        char *entry = client->subscriptions[i];
+
+        if(entry != NULL && strlen(entry) == filter_len && memcmp(entry, filter, filter_len) == 0)
+        {
+            free(entry);
+            client->subscriptions[i] = NULL;
+        }
+    }
+}
+
+/*************************************************************************************************/
+static void broker_send_ack(uint32_t handle, uint8_t header, const uint8_t *id)
+{
+    const uint8_t ack[] = { header, 0x02, id[0], id[1] };
+
+    mqtt_tcp_write(handle, ack, sizeof(ack), ZOS_FALSE);
+}
+
+/*************************************************************************************************/
+static zos_bool_t topic_matches(const char *filter, const uint8_t *topic, uint16_t topic_len)
+{
+    uint16_t t = 0;
+
+    // Wildcards at the first level don't match topics starting with '$'
+    if(topic_len > 0 && topic[0] == '$' && (filter[0] == '+' || filter[0] == '#'))
+    {
+        return ZOS_FALSE;
+    }
+
+    for(;;)
+    {
+        if(*filter == '#')
+        {
+            return ZOS_TRUE;
+        }
+        else if(*filter == '+')
+        {
+            while(t < topic_len && topic[t] != '/')
+            {
+                ++t;
+            }
+            ++filter;
+        }
+        else
+        {
+            for(; *filter != '\0' && *filter != '/'; ++filter, ++t)
+            {
+                if(t >= topic_len || topic[t] != (uint8_t)*filter)
+                {
+                    return ZOS_FALSE;
+                }
+            }
+            if(t < topic_len && topic[t] != '/')
+            {
+                return ZOS_FALSE;
+            }
+        }
+
+        if(*filter != '/')
+        {
+            return (t == topic_len) ? ZOS_TRUE : ZOS_FALSE;
+        }
+        if(t == topic_len)
+        {
+            // "a/#" also matches "a"
+            return (strcmp(filter, "/#") == 0) ? ZOS_TRUE : ZOS_FALSE;
+        }
+        ++filter;
+        ++t;
+    }
+}
@@ -0,0 +1,69 @@
+/*
+ * ZentriOS SDK LICENSE AGREEMENT | Zentri.com, 2016.
+ *
+ * Use of source code and/or libraries contained in the ZentriOS SDK is
+ * subject to the Zentri Operating System SDK license agreement and
+ * applicable open source license agreements.
+ *
+ */
+
+/*
+ * Minimal MQTT 3.1.1 broker stand-in for host measurements.
+ *
+ * Runs on the mqtt_posix_poll() loop of the same process, listening on
+ * 127.0.0.1. It accepts every CONNECT and acknowledges every PUBLISH,
+ * PUBREL, SUBSCRIBE, UNSUBSCRIBE and PINGREQ. Published messages are
+ * delivered to matching subscribers of any client at QoS 0, which is
+ * enough to exercise the receive path. There is no retained message,
+ * will or persistent session support.
+ */
+
+#pragma once
+
+
+#include "zos_types.h"
+
+
+/** Maximum number of connected clients */
+#ifndef MQTT_LOOPBACK_MAX_CLIENTS
+#define MQTT_LOOPBACK_MAX_CLIENTS       4
+#endif
+
+/** Maximum number of subscriptions per client */
+#ifndef MQTT_LOOPBACK_MAX_SUBSCRIPTIONS
+#define MQTT_LOOPBACK_MAX_SUBSCRIPTIONS 8
+#endif
+
+
+/**
+ * Broker counters
+ */
+typedef struct
+{
+    uint32_t connects;          //!< CONNECT packets accepted
+    uint32_t publishes[3];      //!< PUBLISH packets received, per QoS level
+    uint32_t delivered;         //!< PUBLISH packets sent to subscribers
+    uint64_t payload_bytes;     //!< Payload bytes of the received PUBLISH packets
+} mqtt_loopback_broker_stats_t;
+
+
+/**
+ * Start listening
+ *
+ * @param[in] port: TCP port, 0 to let the kernel choose
+ * @param[out] bound_port: Port the broker listens on, may be NULL
+ * @return ZOS_SUCCESS, or the error of @ref mqtt_posix_listen()
+ */
+zos_result_t mqtt_loopback_broker_start(uint16_t port, uint16_t *bound_port);
+
+/**
+ * Close the listening socket and all client connections
+ */
+void mqtt_loopback_broker_stop(void);
+
+/**
+ * Get the broker counters
+ *
+ * @param[out] stats: Current counter values
+ */
+void mqtt_loopback_broker_get_stats(mqtt_loopback_broker_stats_t *stats);
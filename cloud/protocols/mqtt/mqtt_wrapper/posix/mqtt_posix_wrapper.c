@@ -0,0 +1,790 @@
+/*
+ * ZentriOS SDK LICENSE AGREEMENT | Zentri.com, 2016.
+ *
+ * Use of source code and/or libraries contained in the ZentriOS SDK is
+ * subject to the Zentri Operating System SDK license agreement and
+ * applicable open source license agreements.
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include "mqtt_wrapper/mqtt_zentrios_wrapper.h"
+#include "mqtt_posix_wrapper.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+
+#ifndef POLLRDHUP
+#define POLLRDHUP 0
+#endif
+
+#define TX_BUFFER_MIN_SIZE 4096
+
+
+typedef struct
+{
+    int fd;                                 // -1: entry is free
+    zos_bool_t listening;
+    zos_bool_t eof;
+    zos_stream_event_handler_t disconnect;
+    zos_stream_event_handler_t receive;
+    uint8_t *tx;
+    uint32_t tx_length;
+    uint32_t tx_size;
+} posix_socket_t;
+
+typedef struct
+{
+    zos_event_handler_t handler;            // NULL: entry is free
+    void *arg;
+    uint32_t period_ms;                     // 0: issued event, runs once
+    uint64_t due_us;
+    uint32_t pass;                          // Loop pass the event was added in
+} posix_event_t;
+
+// Keeps the size of an allocation in front of it for the byte counters
+typedef union
+{
+    uint32_t size;
+    uint64_t align[2];
+} alloc_header_t;
+
+
+static posix_socket_t* socket_get(uint32_t handle);
+static posix_socket_t* socket_add(int fd);
+static void socket_remove(posix_socket_t *s);
+static zos_result_t socket_flush(posix_socket_t *s);
+static zos_result_t socket_configure(int fd);
+static void run_events(void);
+static int next_event_timeout(int timeout_ms);
+
+
+static posix_socket_t sockets[MQTT_POSIX_MAX_SOCKETS];
+static posix_event_t events[MQTT_POSIX_MAX_EVENTS];
+static FILE *files[MQTT_POSIX_MAX_FILES];
+static mqtt_posix_stats_t stats;
+static zos_bool_t sockets_init;
+static uint32_t loop_pass;
+
+
+
+/*************************************************************************************************/
+zos_result_t mqtt_posix_poll(uint32_t timeout_ms)
+{
+    struct pollfd fds[MQTT_POSIX_MAX_SOCKETS];
+    nfds_t count = 0;
+    int ready;
+
+    socket_get(0);
+
+    for(int i = 0; i < MQTT_POSIX_MAX_SOCKETS; ++i)
+    {
+        if(sockets[i].fd != -1)
+        {
+            fds[count].fd = sockets[i].fd;
+            fds[count].events = POLLIN | POLLRDHUP | ((sockets[i].tx_length > 0) ? POLLOUT : 0);
+            fds[count].revents = 0;
+            ++count;
+        }
+    }
+
+    ready = poll(fds, count, next_event_timeout((int)timeout_ms));
+    if(ready < 0 && errno != EINTR)
+    {
+        return ZOS_ERROR;
+    }
+
+    run_events();
+
+    for(nfds_t i = 0; ready > 0 && i < count; ++i)
+    {
+        // Handlers may close sockets, look each one up again by its descriptor
+        posix_socket_t *s = socket_get((uint32_t)fds[i].fd);
+
+        if(s == NULL || fds[i].revents == 0)
+        {
+            continue;
+        }
+
+        if(fds[i].revents & POLLOUT)
+        {
+            socket_flush(s);
+        }
+        if((fds[i].revents & POLLIN) && s->receive != NULL)
+        {
+            s->receive((uint32_t)s->fd);
+        }
+
+        s = socket_get((uint32_t)fds[i].fd);
+        if(s != NULL && !s->listening && (s->eof || (fds[i].revents & (POLLHUP | POLLERR | POLLRDHUP))))
+        {
+            if(s->disconnect != NULL)
+            {
+                s->disconnect((uint32_t)s->fd);
+            }
+            // The handle is only valid until the disconnect handler returns
+            s = socket_get((uint32_t)fds[i].fd);
+            if(s != NULL)
+            {
+                socket_remove(s);
+            }
+        }
+    }
+
+    // Events issued by the socket handlers, e.g. deferred flushes
+    run_events();
+
+    // What the device stack does when it goes idle: push out un-flushed writes
+    for(int i = 0; i < MQTT_POSIX_MAX_SOCKETS; ++i)
+    {
+        if(sockets[i].fd != -1 && sockets[i].tx_length > 0)
+        {
+            socket_flush(&sockets[i]);
+        }
+    }
+
+    return ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+zos_result_t mqtt_posix_listen(uint16_t port, zos_stream_event_handler_t accept, uint32_t *handle, uint16_t *bound_port)
+{
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    posix_socket_t *s;
+    const int on = 1;
+    int fd;
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0)
+    {
+        return ZOS_ERROR;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+       listen(fd, MQTT_POSIX_MAX_SOCKETS) != 0 ||
+       getsockname(fd, (struct sockaddr*)&addr, &addr_len) != 0 ||
+       fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) != 0)
+    {
+        close(fd);
+        return ZOS_ERROR;
+    }
+
+    s = socket_add(fd);
+    if(s == NULL)
+    {
+        close(fd);
+        return ZOS_NO_MEM;
+    }
+
+    s->listening = ZOS_TRUE;
+    s->receive = accept;
+    *handle = (uint32_t)fd;
+    if(bound_port != NULL)
+    {
+        *bound_port = ntohs(addr.sin_port);
+    }
+
+    return ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+zos_result_t mqtt_posix_accept(uint32_t listen_handle, uint32_t *handle)
+{
+    posix_socket_t *listener = socket_get(listen_handle);
+    int fd;
+
+    if(listener == NULL || !listener->listening)
+    {
+        return ZOS_INVALID_ARG;
+    }
+
+    fd = accept(listener->fd, NULL, NULL);
+    if(fd < 0)
+    {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? ZOS_NO_DATA : ZOS_ERROR;
+    }
+
+    if(socket_configure(fd) != ZOS_SUCCESS || socket_add(fd) == NULL)
+    {
+        close(fd);
+        return ZOS_NO_MEM;
+    }
+
+    *handle = (uint32_t)fd;
+
+    return ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+void mqtt_posix_get_stats(mqtt_posix_stats_t *out)
+{
+    *out = stats;
+}
+
+/*************************************************************************************************/
+uint64_t mqtt_posix_time_us(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+}
+
+
+
+/*************************************************************************************************/
+zos_bool_t mqtt_network_is_up(zos_interface_t interface)
+{
+    UNUSED_PARAMETER(interface);
+
+    return ZOS_TRUE;
+}
+
+/*************************************************************************************************/
+zos_result_t mqtt_tcp_connect(zos_interface_t interface, const char *host, uint16_t port, uint32_t *handle)
+{
+    struct addrinfo hints, *info;
+    char service[8];
+    int fd;
+
+    UNUSED_PARAMETER(interface);
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf(service, sizeof(service), "%u", port);
+
+    if(getaddrinfo(host, service, &hints, &info) != 0)
+    {
+        return ZOS_NOT_FOUND;
+    }
+
+    fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+    if(fd < 0 || connect(fd, info->ai_addr, info->ai_addrlen) != 0)
+    {
+        freeaddrinfo(info);
+        if(fd >= 0)
+        {
+            close(fd);
+        }
+        return ZOS_ERROR;
+    }
+    freeaddrinfo(info);
+
+    if(socket_configure(fd) != ZOS_SUCCESS || socket_add(fd) == NULL)
+    {
+        close(fd);
+        return ZOS_NO_MEM;
+    }
+
+    *handle = (uint32_t)fd;
+
+    return ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+zos_result_t mqtt_tls_connect(zos_interface_t interface, const char *host, uint16_t port, uint32_t *handle)
+{
+    UNUSED_PARAMETER(interface);
+    UNUSED_PARAMETER(host);
+    UNUSED_PARAMETER(port);
+    UNUSED_PARAMETER(handle);
+
+    return ZOS_UNSUPPORTED;
+}
+
+/*************************************************************************************************/
+zos_result_t mqtt_tcp_register_client_event_handlers(uint32_t handle, zos_stream_event_handler_t disconnect, zos_stream_event_handler_t receive)
+{
+    posix_socket_t *s = socket_get(handle);
+
+    if(s == NULL)
+    {
+        return ZOS_INVALID_ARG;
+    }
+
+    s->disconnect = disconnect;
+    s->receive = receive;
+
+    return ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+zos_result_t mqtt_tcp_disconnect(uint32_t handle)
+{
+    posix_socket_t *s = socket_get(handle);
+
+    if(s == NULL)
+    {
+        return ZOS_INVALID_ARG;
+    }
+
+    // Best effort, e.g. a DISCONNECT frame written right before closing
+    socket_flush(s);
+    socket_remove(s);
+
+    return ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+zos_result_t mqtt_tcp_read(uint32_t handle, void *data, uint32_t max_size, uint32_t *bytes_read)
+{
+    posix_socket_t *s = socket_get(handle);
+    ssize_t n;
+
+    *bytes_read = 0;
+    if(s == NULL)
+    {
+        return ZOS_INVALID_ARG;
+    }
+
+    do
+    {
+        n = recv(s->fd, data, max_size, MSG_DONTWAIT);
+    } while(n < 0 && errno == EINTR);
+
+    if(n > 0)
+    {
+        *bytes_read = (uint32_t)n;
+    }
+    else if(n == 0 && max_size > 0)
+    {
+        // Peer closed, mqtt_posix_poll() calls the disconnect handler
+        s->eof = ZOS_TRUE;
+    }
+    else if(n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+        s->eof = ZOS_TRUE;
+        return ZOS_NOT_CONNECTED;
+    }
+
+    return ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+zos_result_t mqtt_tcp_write(uint32_t handle, const void *data, uint32_t size, zos_bool_t auto_flush)
+{
+    posix_socket_t *s = socket_get(handle);
+
+    if(s == NULL || s->listening)
+    {
+        return ZOS_INVALID_ARG;
+    }
+
+    if(s->tx_length + size > s->tx_size)
+    {
+        uint32_t new_size = MAX(s->tx_size * 2, TX_BUFFER_MIN_SIZE);
+        uint8_t *tx;
+
+        while(new_size < s->tx_length + size)
+        {
+            new_size *= 2;
+        }
+        // Socket buffers stand in for the network stack's own memory, not counted in the stats
+        tx = realloc(s->tx, new_size);
+        if(tx == NULL)
+        {
+            return ZOS_NO_MEM;
+        }
+        s->tx = tx;
+        s->tx_size = new_size;
+    }
+
+    memcpy(&s->tx[s->tx_length], data, size);
+    s->tx_length += size;
+
+    return (auto_flush == ZOS_TRUE) ? socket_flush(s) : ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+zos_result_t mqtt_tcp_flush(uint32_t handle)
+{
+    posix_socket_t *s = socket_get(handle);
+
+    return (s == NULL) ? ZOS_INVALID_ARG : socket_flush(s);
+}
+
+/*************************************************************************************************/
+zos_result_t mqtt_malloc(uint8_t **ptr, uint32_t size)
+{
+    alloc_header_t *header = malloc(sizeof(alloc_header_t) + size);
+
+    if(header == NULL)
+    {
+        *ptr = NULL;
+        return ZOS_NO_MEM;
+    }
+
+    header->size = size;
+    ++stats.malloc_count;
+    stats.bytes_in_use += size;
+    stats.bytes_peak = MAX(stats.bytes_peak, stats.bytes_in_use);
+    *ptr = (uint8_t*)(header + 1);
+
+    return ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+zos_result_t mqtt_free(void *ptr)
+{
+    alloc_header_t *header;
+
+    if(ptr == NULL)
+    {
+        return ZOS_SUCCESS;
+    }
+
+    header = (alloc_header_t*)ptr - 1;
+    ++stats.free_count;
+    stats.bytes_in_use -= header->size;
+    free(header);
+
+    return ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+zos_result_t mqtt_event_unregister(zos_event_handler_t handler, void *arg)
+{
+    for(int i = 0; i < MQTT_POSIX_MAX_EVENTS; ++i)
+    {
+        if(events[i].handler == handler && events[i].arg == arg)
+        {
+            events[i].handler = NULL;
+        }
+    }
+
+    return ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+zos_result_t mqtt_event_register_periodic(zos_event_handler_t handler, void *arg, uint32_t period_ms, zos_event_flag_t flags)
+{
+    posix_event_t *free_entry = NULL;
+    posix_event_t *e = NULL;
+
+    if(handler == NULL || period_ms == 0)
+    {
+        return ZOS_INVALID_ARG;
+    }
+
+    // Registering again changes the period of the existing event
+    for(int i = 0; i < MQTT_POSIX_MAX_EVENTS && e == NULL; ++i)
+    {
+        if(events[i].handler == NULL)
+        {
+            free_entry = (free_entry == NULL) ? &events[i] : free_entry;
+        }
+        else if(events[i].handler == handler && events[i].arg == arg && events[i].period_ms != 0)
+        {
+            e = &events[i];
+        }
+    }
+
+    e = (e == NULL) ? free_entry : e;
+    if(e == NULL)
+    {
+        return ZOS_NO_MEM;
+    }
+
+    e->handler = handler;
+    e->arg = arg;
+    e->period_ms = period_ms;
+    e->due_us = mqtt_posix_time_us() + ((flags & RUN_NOW) ? 0 : (uint64_t)period_ms * 1000);
+    e->pass = loop_pass;
+
+    return ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+zos_result_t mqtt_event_issue(zos_event_handler_t handler, void *arg, zos_event_flag_t flags)
+{
+    UNUSED_PARAMETER(flags);
+
+    if(handler == NULL)
+    {
+        return ZOS_INVALID_ARG;
+    }
+
+    for(int i = 0; i < MQTT_POSIX_MAX_EVENTS; ++i)
+    {
+        if(events[i].handler == NULL)
+        {
+            events[i].handler = handler;
+            events[i].arg = arg;
+            events[i].period_ms = 0;
+            events[i].due_us = 0;
+            events[i].pass = loop_pass;
+            return ZOS_SUCCESS;
+        }
+    }
+
+    return ZOS_NO_MEM;
+}
+
+/*************************************************************************************************/
+zos_result_t mqtt_file_create(const char *name, uint32_t size, uint32_t *handle)
+{
+    UNUSED_PARAMETER(size);
+
+    for(int i = 0; i < MQTT_POSIX_MAX_FILES; ++i)
+    {
+        if(files[i] == NULL)
+        {
+            files[i] = fopen(name, "w+b");
+            if(files[i] == NULL)
+            {
+                return ZOS_ERROR;
+            }
+            *handle = (uint32_t)i + 1;
+            return ZOS_SUCCESS;
+        }
+    }
+
+    return ZOS_NO_MEM;
+}
+
+/*************************************************************************************************/
+zos_result_t mqtt_file_open(const char *name, uint32_t *handle)
+{
+    for(int i = 0; i < MQTT_POSIX_MAX_FILES; ++i)
+    {
+        if(files[i] == NULL)
+        {
+            files[i] = fopen(name, "rb");
+            if(files[i] == NULL)
+            {
+                return ZOS_NOT_FOUND;
+            }
+            *handle = (uint32_t)i + 1;
+            return ZOS_SUCCESS;
+        }
+    }
+
+    return ZOS_NO_MEM;
+}
+
+/*************************************************************************************************/
+zos_result_t mqtt_file_write(uint32_t handle, const void *data, uint32_t size)
+{
+    if(handle == 0 || handle > MQTT_POSIX_MAX_FILES || files[handle - 1] == NULL)
+    {
+        return ZOS_INVALID_ARG;
+    }
+
+    return (fwrite(data, 1, size, files[handle - 1]) == size) ? ZOS_SUCCESS : ZOS_ERROR;
+}
+
+/*************************************************************************************************/
+zos_result_t mqtt_file_read(uint32_t handle, void *data, uint32_t size, uint32_t *bytes_read)
+{
+    if(handle == 0 || handle > MQTT_POSIX_MAX_FILES || files[handle - 1] == NULL)
+    {
+        return ZOS_INVALID_ARG;
+    }
+
+    *bytes_read = (uint32_t)fread(data, 1, size, files[handle - 1]);
+
+    return ferror(files[handle - 1]) ? ZOS_ERROR : ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+zos_result_t mqtt_file_close(uint32_t handle)
+{
+    if(handle == 0 || handle > MQTT_POSIX_MAX_FILES || files[handle - 1] == NULL)
+    {
+        return ZOS_INVALID_ARG;
+    }
+
+    fclose(files[handle - 1]);
+    files[handle - 1] = NULL;
+
+    return ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+zos_result_t mqtt_file_delete(const char *name)
+{
+    return (remove(name) == 0) ? ZOS_SUCCESS : ZOS_NOT_FOUND;
+}
+
+/*************************************************************************************************/
+void mqtt_log(const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+
+
+/*************************************************************************************************/
+static posix_socket_t* socket_get(uint32_t handle)
+{
+    if(!sockets_init)
+    {
+        for(int i = 0; i < MQTT_POSIX_MAX_SOCKETS; ++i)
+        {
+            sockets[i].fd = -1;
+        }
+        sockets_init = ZOS_TRUE;
+    }
+
+    for(int i = 0; i < MQTT_POSIX_MAX_SOCKETS; ++i)
+    {
+        if(sockets[i].fd != -1 && (uint32_t)sockets[i].fd == handle)
+        {
+            return &sockets[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*************************************************************************************************/
+static posix_socket_t* socket_add(int fd)
+{
+    socket_get(0);
+
+    for(int i = 0; i < MQTT_POSIX_MAX_SOCKETS; ++i)
+    {
+        if(sockets[i].fd == -1)
+        {
+            memset(&sockets[i], 0, sizeof(posix_socket_t));
+            sockets[i].fd = fd;
+            return &sockets[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*************************************************************************************************/
+static void socket_remove(posix_socket_t *s)
+{
+    close(s->fd);
+    free(s->tx);
+    memset(s, 0, sizeof(posix_socket_t));
+    s->fd = -1;
+}
+
+/*************************************************************************************************/
+static zos_result_t socket_flush(posix_socket_t *s)
+{
+    uint32_t sent = 0;
+
+    while(sent < s->tx_length)
+    {
+        const ssize_t n = send(s->fd, &s->tx[sent], s->tx_length - sent, MSG_NOSIGNAL);
+
+        if(n < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            if(errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                // Kernel buffer full, the rest goes when poll() reports POLLOUT
+                break;
+            }
+            s->tx_length = 0;
+            return ZOS_NOT_CONNECTED;
+        }
+
+        ++stats.send_calls;
+        stats.bytes_sent += (uint64_t)n;
+        sent += (uint32_t)n;
+    }
+
+    s->tx_length -= sent;
+    if(s->tx_length > 0 && sent > 0)
+    {
+        memmove(s->tx, &s->tx[sent], s->tx_length);
+    }
+
+    return ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+static zos_result_t socket_configure(int fd)
+{
+    const int on = 1;
+
+    // Coalescing is up to the flush calls, as on the device
+    if(setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)) != 0 ||
+       fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) != 0)
+    {
+        return ZOS_ERROR;
+    }
+
+    return ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+static void run_events(void)
+{
+    const uint64_t now = mqtt_posix_time_us();
+    const uint32_t pass = ++loop_pass;
+
+    for(int i = 0; i < MQTT_POSIX_MAX_EVENTS; ++i)
+    {
+        posix_event_t *e = &events[i];
+        zos_event_handler_t handler = e->handler;
+        void *arg = e->arg;
+
+        // Events added by a handler during this pass wait for the next one
+        if(handler == NULL || e->pass == pass || e->due_us > now)
+        {
+            continue;
+        }
+
+        if(e->period_ms == 0)
+        {
+            e->handler = NULL;
+        }
+        else
+        {
+            e->due_us = MAX(e->due_us + (uint64_t)e->period_ms * 1000, now);
+        }
+
+        handler(arg);
+    }
+}
+
+/*************************************************************************************************/
+static int next_event_timeout(int timeout_ms)
+{
+    const uint64_t now = mqtt_posix_time_us();
+
+    for(int i = 0; i < MQTT_POSIX_MAX_EVENTS; ++i)
+    {
+        if(events[i].handler != NULL)
+        {
+            const uint64_t wait_ms = (events[i].due_us > now) ? (events[i].due_us - now + 999) / 1000 : 0;
+
+            timeout_ms = (int)MIN((uint64_t)timeout_ms, wait_ms);
+        }
+    }
+
+    return timeout_ms;
+}
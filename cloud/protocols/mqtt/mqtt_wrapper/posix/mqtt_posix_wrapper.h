@@ -0,0 +1,107 @@
+/*
+ * ZentriOS SDK LICENSE AGREEMENT | Zentri.com, 2016.
+ *
+ * Use of source code and/or libraries contained in the ZentriOS SDK is
+ * subject to the Zentri Operating System SDK license agreement and
+ * applicable open source license agreements.
+ *
+ */
+
+/*
+ * Host (Linux/POSIX) implementation of the MQTT platform hooks declared in
+ * mqtt_zentrios_wrapper.h, used to run and measure the library without a
+ * device.
+ *
+ * Everything runs on the thread calling mqtt_posix_poll(), the same way the
+ * ZentriOS event thread runs the stream and event handlers. Sockets are
+ * non-blocking, writes without auto flush are kept in a per socket buffer
+ * until mqtt_tcp_flush() or the end of the poll pass, like the device stack
+ * holding un-flushed data until it goes idle.
+ */
+
+#pragma once
+
+
+#include "zos_types.h"
+
+
+/** Maximum number of sockets, client and listening, open at once */
+#ifndef MQTT_POSIX_MAX_SOCKETS
+#define MQTT_POSIX_MAX_SOCKETS 16
+#endif
+
+/** Maximum number of registered periodic plus issued events */
+#ifndef MQTT_POSIX_MAX_EVENTS
+#define MQTT_POSIX_MAX_EVENTS  32
+#endif
+
+/** Maximum number of files open at once */
+#ifndef MQTT_POSIX_MAX_FILES
+#define MQTT_POSIX_MAX_FILES   4
+#endif
+
+
+/**
+ * Counters kept by the host wrapper
+ */
+typedef struct
+{
+    uint32_t malloc_count;      //!< Successful mqtt_malloc() calls
+    uint32_t free_count;        //!< mqtt_free() calls
+    uint32_t bytes_in_use;      //!< Bytes currently allocated with mqtt_malloc()
+    uint32_t bytes_peak;        //!< Highest value of bytes_in_use
+    uint32_t send_calls;        //!< send() system calls, i.e. TCP writes that reached the kernel
+    uint64_t bytes_sent;        //!< Bytes handed to the kernel
+} mqtt_posix_stats_t;
+
+
+/**
+ * Run one pass of the host event loop
+ *
+ * Waits up to `timeout_ms` for socket activity or the next periodic event,
+ * then runs issued events, due periodic events and the receive/disconnect
+ * handlers of ready sockets, and finally flushes all buffered writes.
+ *
+ * @param[in] timeout_ms: Maximum time to wait, 0 to only handle what is ready
+ * @return ZOS_SUCCESS, ZOS_ERROR if poll() failed
+ */
+zos_result_t mqtt_posix_poll(uint32_t timeout_ms);
+
+/**
+ * Open a listening TCP socket on 127.0.0.1
+ *
+ * `accept` is called from mqtt_posix_poll() with the listening handle when a
+ * connection is pending, it should call @ref mqtt_posix_accept().
+ *
+ * @param[in] port: TCP port, 0 to let the kernel choose
+ * @param[in] accept: Handler called when a connection is pending
+ * @param[out] handle: Handle of the listening socket
+ * @param[out] bound_port: Port actually bound, may be NULL
+ * @return ZOS_SUCCESS, ZOS_ERROR or ZOS_NO_MEM if the socket table is full
+ */
+zos_result_t mqtt_posix_listen(uint16_t port, zos_stream_event_handler_t accept, uint32_t *handle, uint16_t *bound_port);
+
+/**
+ * Accept a pending connection on a listening socket
+ *
+ * The returned handle works with all the mqtt_tcp_*() hooks.
+ *
+ * @param[in] listen_handle: Handle returned by @ref mqtt_posix_listen()
+ * @param[out] handle: Handle of the accepted socket
+ * @return ZOS_SUCCESS, ZOS_NO_DATA if nothing is pending, ZOS_ERROR or ZOS_NO_MEM
+ */
+zos_result_t mqtt_posix_accept(uint32_t listen_handle, uint32_t *handle);
+
+/**
+ * Get the wrapper counters
+ *
+ * @param[out] stats: Current counter values
+ */
+void mqtt_posix_get_stats(mqtt_posix_stats_t *stats);
+
+/**
+ * Current monotonic time
+ *
+ * @return Time in microseconds from an arbitrary origin
+ */
+uint64_t mqtt_posix_time_us(void);
@@ -0,0 +1,18 @@
+/*
+ * ZentriOS SDK LICENSE AGREEMENT | Zentri.com, 2016.
+ *
+ * Use of source code and/or libraries contained in the ZentriOS SDK is
+ * subject to the Zentri Operating System SDK license agreement and
+ * applicable open source license agreements.
+ *
+ */
+
+/*
+ * Host stand-in for the ZentriOS network header, the interface type the MQTT
+ * library needs is in zos_types.h
+ */
+
+#pragma once
+
+
+#include "zos_types.h"
@@ -0,0 +1,19 @@
+/*
+ * ZentriOS SDK LICENSE AGREEMENT | Zentri.com, 2016.
+ *
+ * Use of source code and/or libraries contained in the ZentriOS SDK is
+ * subject to the Zentri Operating System SDK license agreement and
+ * applicable open source license agreements.
+ *
+ */
+
+/*
+ * Host stand-in for zos.h, see zos_types.h in this directory
+ */
+
+#pragma once
+
+
+#include "zos_types.h"
+#include <stdio.h>
+#include <stdlib.h>
@@ -0,0 +1,73 @@
+/*
+ * ZentriOS SDK LICENSE AGREEMENT | Zentri.com, 2016.
+ *
+ * Use of source code and/or libraries contained in the ZentriOS SDK is
+ * subject to the Zentri Operating System SDK license agreement and
+ * applicable open source license agreements.
+ *
+ */
+
+/*
+ * Host stand-in for the ZentriOS types header. Only provides what the MQTT
+ * library and mqtt_posix_wrapper.c use, it is never on the include path of
+ * a device build.
+ */
+
+#pragma once
+
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <string.h>
+
+
+typedef enum
+{
+    ZOS_SUCCESS = 0,
+    ZOS_ERROR,
+    ZOS_INVALID_ARG,
+    ZOS_UNIMPLEMENTED,
+    ZOS_TIMEOUT,
+    ZOS_PENDING,
+    ZOS_NO_MEM,
+    ZOS_BUFFER_OVERFLOW,
+    ZOS_NOT_FOUND,
+    ZOS_NO_DATA,
+    ZOS_UNSUPPORTED,
+    ZOS_NOT_CONNECTED,
+} zos_result_t;
+
+typedef enum
+{
+    ZOS_FALSE = 0,
+    ZOS_TRUE  = 1
+} zos_bool_t;
+
+typedef enum
+{
+    ZOS_WLAN,
+    ZOS_SOFTAP,
+    ZOS_ETHERNET,
+} zos_interface_t;
+
+typedef uint32_t zos_event_flag_t;
+
+typedef void (*zos_event_handler_t)(void *arg);
+typedef void (*zos_stream_event_handler_t)(uint32_t handle);
+
+
+#define ZOS_INVALID_HANDLE  0xFFFFFFFF
+
+#define RUN_NOW             (1 << 0)
+#define EVENT_FLAGS1(a)     (a)
+#define EVENT_FLAGS2(a,b)   ((a)|(b))
+
+#define UNUSED_PARAMETER(x) (void)(x)
+
+#ifndef MIN
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a,b) ((a) > (b) ? (a) : (b))
+#endif
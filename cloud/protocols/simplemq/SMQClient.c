@@ -59,6 +59,9 @@
 
 #define SMQ_VERSION 1
 
+/* SMQTopic::flags: the entry's tid is confirmed on the current connection */
+#define SMQ_TOPIC_VALID 0x80
+
 #if defined(B_LITTLE_ENDIAN)
 static void
 netConvU16(U8* out, const U8* in)
@@ -93,26 +96,75 @@ SMQ_recv(SMQ* o, U8* buf, int len)
 }
 
 
+/* Sets 'data' to up to 'len' bytes received in SMQ::buf and returns
+   the number of bytes.
+*/
+static int
+SMQ_recvChunk(SMQ* o, U8** data, int len)
+{
+   *data = o->buf;
+   return SMQ_recv(o, o->buf, len < o->bufLen ? len : o->bufLen);
+}
+
+
+/* Starts reading into the buffer, or continues the partial frame kept
+   by SMQ_readError.
+*/
+static void
+SMQ_resumeb(SMQ* o)
+{
+   if(o->rxPending)
+      o->rxPending=FALSE;
+   else
+      SMQ_resetb(o);
+}
+
+
+/* Receives until the buffer holds 'size' bytes.
+   Returns zero on success and a value (error code) less than zero on
+   error. The bytes received so far stay in the buffer on timeout.
+*/
+static int
+SMQ_readBuf(SMQ* o, U16 size)
+{
+   while(o->bufIx < size)
+   {
+      int x=SMQ_recv(o, o->buf+o->bufIx, size-o->bufIx);
+      if(x <= 0)
+      {
+         o->status = x == 0 ? SMQE_TIMEOUT : x;
+         return o->status;
+      }
+      o->bufIx += (U16)x;
+   }
+   return 0;
+}
+
+
+/* Returns the error code of a failed frame read. A timeout in the
+   middle of a frame is not an error: the frame is kept in the buffer,
+   zero is returned, and the next SMQ_getMessage call continues it.
+*/
+static int
+SMQ_readError(SMQ* o)
+{
+   if(o->status != SMQE_TIMEOUT)
+      return o->status;
+   o->rxPending = o->bufIx != 0;
+   return 0;
+}
+
+
 /* Reads and stores the 3 frame header bytes (len:2 & msg:1) in the buffer.
    Returns zero on success and a value (error code) less than zero on error
  */
 static int
 SMQ_readFrameHeader(SMQ* o)
 {
-   int x;
-   SMQ_resetb(o);
-   do
-   {
-      x=SMQ_recv(o, o->buf, 3 - o->bufIx);
-      o->bufIx += (U16)x; /* assume it's OK */
-   } while(x > 0 && o->bufIx < 3);
-   if(x > 0)
-   {
-      netConvU16((U8*)&o->frameLen, o->buf);
-      return 0;
-   }
-   o->status = x == 0 ? SMQE_TIMEOUT : x;
-   return o->status;
+   SMQ_resumeb(o);
+   if(SMQ_readBuf(o, 3)) return o->status;
+   netConvU16((U8*)&o->frameLen, o->buf);
+   return 0;
 }
 
 
@@ -126,33 +178,100 @@ SMQ_readFrameHeader(SMQ* o)
 static int
 SMQ_readFrame(SMQ* o, int hasFH)
 {
-   int x;
    if(!hasFH && SMQ_readFrameHeader(o)) return o->status;
    if(o->frameLen > o->bufLen || o->frameLen < 3)
       return o->status = SMQE_BUF_OVERFLOW;
-   do
-   {
-      x=SMQ_recv(o, o->buf+o->bufIx, o->frameLen - o->bufIx);
-      o->bufIx += (U16)x; /* assume it's OK */
-   } while(x > 0 && o->bufIx < o->frameLen);
+   if(SMQ_readBuf(o, o->frameLen)) return o->status;
    SMQ_resetb(o);
-   if(x > 0) return 0;
-   o->status = x == 0 ? SMQE_TIMEOUT : x;
-   return o->status;
+   return 0;
 }
 
 
 static int
 SMQ_readData(SMQ* o, U16 size)
+{
+   return SMQ_readBuf(o, size) ? o->status : o->bufIx;
+}
+
+
+
+/* Sends the publish frames queued in batch mode */
+static int
+SMQ_sendBatch(SMQ* o)
+{
+   if(o->batchIx)
+   {
+      int x = se_send(&o->sock, o->batchBuf, o->batchIx);
+      o->batchIx = 0;
+      if(x < 0)
+      {
+         o->status = x;
+         return x;
+      }
+   }
+   return 0;
+}
+
+
+/* Sends a frame without using the buffer, which holds a partly
+   received frame while SMQ::rxPending is set.
+*/
+static int
+SMQ_sendDirect(SMQ* o, U8 msg, const void* data, U16 len)
+{
+   U8 buf[3];
+   U16 frameLen = len+3;
+   if(SMQ_sendBatch(o)) return o->status;
+   netConvU16(buf, (U8*)&frameLen); /* Frame Len */
+   buf[2] = msg;
+   o->status=se_send(&o->sock, buf, 3);
+   if(o->status == 0 && len)
+      o->status=se_send(&o->sock, data, len);
+   if(o->status < 0) return o->status;
+   return 0;
+}
+
+
+/* Returns true when the batch cannot take another frame or when its
+   oldest frame has waited for the configured delay.
+*/
+static int
+SMQ_batchDue(SMQ* o)
+{
+   return o->batchIx &&
+      ((o->batchLen - o->batchIx) <= 15 ||
+       (U32)(se_getTime() - o->batchTime) >= o->batchDelay);
+}
+
+
+
+/* Passes the rest of the current PUBLISH frame to the chunk handler.
+   Returns the message size when done (SMQ_EMPTYMSG if zero), zero on
+   timeout (the next call resumes at the same offset), or an error code.
+*/
+static int
+SMQ_streamData(SMQ* o)
 {
    int x;
-   do {
-      x=SMQ_recv(o, o->buf+o->bufIx, size-o->bufIx);
-      o->bufIx += (U16)x; /* assume it's OK */
-   } while(x > 0 && o->bufIx < size);
-   if(x > 0) return o->bufIx;
-   o->status = x == 0 ? SMQE_TIMEOUT : x;
-   return o->status;
+   U16 total = o->frameLen - 15;
+   if(!total)
+      o->chunkHandler(o, o->buf, 0, 0, 0);
+   while(o->bytesRead < o->frameLen)
+   {
+      U8* data;
+      x = SMQ_recvChunk(o, &data, o->frameLen - o->bytesRead);
+      if(x <= 0)
+      {
+         if(x == 0)
+            return 0;
+         o->bytesRead = 0;
+         return o->status = x;
+      }
+      o->chunkHandler(o, data, (U16)x, o->bytesRead - 15, total);
+      o->bytesRead += (U16)x;
+   }
+   o->bytesRead = 0;
+   return total ? total : SMQ_EMPTYMSG;
 }
 
 
@@ -160,9 +279,11 @@ SMQ_readData(SMQ* o, U16 size)
 static int
 SMQ_flushb(SMQ* o)
 {
-   if(o->bufIx)
+   if(o->bufIx && !o->rxPending)
    {
-      int x = se_send(&o->sock, o->buf, o->bufIx);
+      int x = SMQ_sendBatch(o);
+      if(x == 0)
+         x = se_send(&o->sock, o->buf, o->bufIx);
       SMQ_resetb(o);
       if(x < 0)
       {
@@ -214,6 +335,17 @@ SMQ_writeb(SMQ* o, const void* data, int len)
 }
 
 
+static void
+SMQ_putPubHeader(SMQ* o, U8* buf, U16 frameLen, U8 msg, U32 tid, U32 subtid)
+{
+   netConvU16(buf, (U8*)&frameLen); /* Frame Len */
+   buf[2] = msg;
+   netConvU32(buf+3, (U8*)&tid);
+   netConvU32(buf+7,(U8*)&o->clientTid);
+   netConvU32(buf+11,(U8*)&subtid);
+}
+
+
 void
 SMQ_constructor(SMQ* o, U8* buf, U16 bufLen)
 {
@@ -268,6 +400,10 @@ L_defPorts:
    /* Write hostname */
 
    SMQ_resetb(o);
+   o->rxPending = FALSE;
+   o->batchIx = 0;
+   for(x = 0 ; x < o->topicsLen ; x++)
+      o->topics[x].flags &= ~SMQ_TOPIC_VALID; /* Revalidated by SMQ_connect */
    o->bufIx = (U16)(eohn-url); /* save hostname len */
    if((o->bufIx+1) >= o->bufLen)
       return o->status = SMQE_BUF_OVERFLOW;
@@ -335,6 +471,10 @@ SMQ_connect(SMQ* o, const char* uid, int uidLen, const char* credentials,
    else
       o->buf[0]=0; /* No error message */
    o->status = (int)o->buf[3]; /* OK or error code */
+   o->pingTmoCounter=0;
+   o->pingTime = se_getTime();
+   if(o->status == 0 && o->topics)
+      return SMQ_resolve(o);
    return o->status;
 }
 
@@ -342,6 +482,11 @@ SMQ_connect(SMQ* o, const char* uid, int uidLen, const char* credentials,
 void
 SMQ_disconnect(SMQ* o)
 {
+   if(o->rxPending)
+   {
+      SMQ_sendDirect(o, MSG_DISCONNECT, 0, 0);
+      return;
+   }
    o->bufIx = 3;
    netConvU16(o->buf, (U8*)&o->bufIx); /* Frame Len */
    o->buf[2] = MSG_DISCONNECT;
@@ -355,18 +500,35 @@ SMQ_destructor(SMQ* o)
    se_close(&o->sock);
 }
 
-/* Send MSG_SUBSCRIBE, MSG_CREATE, or MSG_CREATESUB */
+/* Append a MSG_SUBSCRIBE, MSG_CREATE, or MSG_CREATESUB frame to the
+   buffer, sending the buffered frames first if it does not fit.
+*/
 static int
-SMQ_subOrCreate(SMQ* o,const char* topic,int msg)
+SMQ_putSubOrCreate(SMQ* o,const char* topic,int msg)
 {
-   int len = strlen(topic);
+   U16 len = (U16)strlen(topic);
    if( ! len ) return SMQE_PROTOCOL_ERROR;
    if((3+len) > o->bufLen) return SMQE_BUF_OVERFLOW;
-   o->bufIx = 2;
-   o->buf[o->bufIx++] = (U8)msg;
-   SMQ_putb(o,topic,len);
-   netConvU16(o->buf, (U8*)&o->bufIx); /* Frame Len */
-   return SMQ_flushb(o);
+   if(o->rxPending) return SMQ_sendDirect(o, (U8)msg, topic, len);
+   if((o->bufIx+3+len) > o->bufLen && SMQ_flushb(o)) return o->status;
+   len += 3;
+   netConvU16(o->buf+o->bufIx, (U8*)&len); /* Frame Len */
+   o->buf[o->bufIx+2] = (U8)msg;
+   memcpy(o->buf+o->bufIx+3, topic, len-3);
+   o->bufIx += len;
+   return 0;
+}
+
+
+/* Send MSG_SUBSCRIBE, MSG_CREATE, or MSG_CREATESUB */
+static int
+SMQ_subOrCreate(SMQ* o,const char* topic,int msg)
+{
+   int x;
+   if(!o->rxPending)
+      SMQ_resetb(o);
+   x = SMQ_putSubOrCreate(o,topic,msg);
+   return x ? x : SMQ_flushb(o);
 }
 
 
@@ -394,6 +556,12 @@ SMQ_createsub(SMQ* o, const char* topic)
 static int
 SMQ_sendMsgWithTid(SMQ* o, int msgType, U32 tid)
 {
+   if(o->rxPending)
+   {
+      U8 buf[4];
+      netConvU32(buf, (U8*)&tid);
+      return SMQ_sendDirect(o, (U8)msgType, buf, 4);
+   }
    o->bufIx=7;
    netConvU16(o->buf, (U8*)&o->bufIx); /* Frame Len */
    o->buf[2] = (U8)msgType;
@@ -413,24 +581,28 @@ int
 SMQ_publish(SMQ* o, const void* data, int len, U32 tid, U32 subtid)
 {
    U16 tlen=(U16)len+15;
-   if(tlen <= o->bufLen && ! o->inRecv)
+   if(o->batchBuf && tlen <= o->batchLen)
    {
-      netConvU16(o->buf, (U8*)&tlen); /* Frame Len */
-      o->buf[2] = MSG_PUBLISH;
-      netConvU32(o->buf+3, (U8*)&tid);
-      netConvU32(o->buf+7,(U8*)&o->clientTid);
-      netConvU32(o->buf+11,(U8*)&subtid);
+      if((o->batchIx + tlen) > o->batchLen && SMQ_sendBatch(o))
+         return o->status;
+      if(!o->batchIx)
+         o->batchTime = se_getTime();
+      SMQ_putPubHeader(o, o->batchBuf+o->batchIx, tlen, MSG_PUBLISH, tid, subtid);
+      memcpy(o->batchBuf+o->batchIx+15, data, len);
+      o->batchIx += tlen;
+      if(SMQ_batchDue(o) && SMQ_sendBatch(o)) return o->status;
+   }
+   else if(tlen <= o->bufLen && ! o->inRecv && ! o->rxPending)
+   {
+      SMQ_putPubHeader(o, o->buf, tlen, MSG_PUBLISH, tid, subtid);
       o->bufIx = 15;
       if(SMQ_writeb(o, data, len) || SMQ_flushb(o)) return o->status;
    }
    else
    {
       U8 buf[15];
-      netConvU16(buf, (U8*)&tlen); /* Frame Len */
-      buf[2] = MSG_PUBLISH;
-      netConvU32(buf+3, (U8*)&tid);
-      netConvU32(buf+7,(U8*)&o->clientTid);
-      netConvU32(buf+11,(U8*)&subtid);
+      if(SMQ_sendBatch(o)) return o->status;
+      SMQ_putPubHeader(o, buf, tlen, MSG_PUBLISH, tid, subtid);
       o->status=se_send(&o->sock, buf, 15);
       if(o->status < 0) return o->status;
       o->status=se_send(&o->sock, data, len);
@@ -452,7 +624,7 @@ int
 SMQ_write(SMQ* o,  const void* data, int len)
 {
    U8* ptr = (U8*)data;
-   if(o->inRecv)
+   if(o->inRecv || o->rxPending)
       return SMQE_PROTOCOL_ERROR;
    while(len > 0)
    {
@@ -475,14 +647,14 @@ SMQ_write(SMQ* o,  const void* data, int len)
 int
 SMQ_pubflush(SMQ* o, U32 tid, U32 subtid)
 {
+   if(o->rxPending)
+      return SMQE_PROTOCOL_ERROR;
    if(!o->bufIx)
       o->bufIx = 15;
-   netConvU16(o->buf, (U8*)&o->bufIx); /* Frame Len */
-   o->buf[2] = MSG_PUBFRAG;
-   netConvU32(o->buf+3, (U8*)&tid);
-   netConvU32(o->buf+7,(U8*)&o->clientTid);
-   netConvU32(o->buf+11,(U8*)&subtid);
-   o->status=se_send(&o->sock, o->buf, o->bufIx);
+   SMQ_putPubHeader(o, o->buf, o->bufIx, MSG_PUBFRAG, tid, subtid);
+   o->status=SMQ_sendBatch(o);
+   if(o->status == 0)
+      o->status=se_send(&o->sock, o->buf, o->bufIx);
    SMQ_resetb(o);
    if(o->status < 0) return o->status;
    o->status=0;
@@ -491,6 +663,146 @@ SMQ_pubflush(SMQ* o, U32 tid, U32 subtid)
 
 
 
+int
+SMQ_setBatch(SMQ* o, U8* buf, U16 len, U32 maxDelay)
+{
+   if(SMQ_sendBatch(o)) return o->status;
+   o->batchBuf = buf;
+   o->batchLen = buf ? len : 0;
+   o->batchDelay = maxDelay;
+   return 0;
+}
+
+
+int
+SMQ_flush(SMQ* o)
+{
+   return SMQ_sendBatch(o);
+}
+
+
+static U32
+SMQ_hash(const char* name)
+{
+   U32 h = 2166136261U; /* FNV-1a */
+   while(*name)
+      h = (h ^ (U8)*name++) * 16777619U;
+   return h;
+}
+
+
+/* Find the cache entry for 'name', or the free entry where it goes.
+   Returns NULL if the name is not cached and the cache is full.
+*/
+static SMQTopic*
+SMQ_findTopic(SMQ* o, const char* name, U8 subtopic)
+{
+   U16 i = (U16)(SMQ_hash(name) % o->topicsLen);
+   U16 n;
+   for(n = 0 ; n < o->topicsLen ; n++)
+   {
+      SMQTopic* t = o->topics + i;
+      if(!t->name ||
+         ((t->flags & SMQ_TOPIC_SUBTOPIC) == subtopic && !strcmp(t->name, name)))
+      {
+         return t;
+      }
+      if(++i == o->topicsLen)
+         i = 0;
+   }
+   return 0;
+}
+
+
+void
+SMQ_setTopicCache(SMQ* o, SMQTopic* cache, U16 len)
+{
+   memset(cache, 0, len * sizeof(SMQTopic));
+   o->topics = len ? cache : 0;
+   o->topicsLen = len;
+}
+
+
+int
+SMQ_addTopic(SMQ* o, const char* name, U8 flags)
+{
+   SMQTopic* t;
+   if(!o->topics || !*name || !(t = SMQ_findTopic(o, name, flags & SMQ_TOPIC_SUBTOPIC)))
+      return SMQE_BUF_OVERFLOW;
+   if(!t->name)
+   {
+      t->name = name;
+      t->flags = flags & SMQ_TOPIC_SUBTOPIC;
+   }
+   t->flags |= flags;
+   return 0;
+}
+
+
+U32
+SMQ_getTid(SMQ* o, const char* name, int subtopic)
+{
+   SMQTopic* t;
+   if(!o->topics)
+      return 0;
+   t = SMQ_findTopic(o, name, subtopic ? SMQ_TOPIC_SUBTOPIC : 0);
+   return t && t->name ? t->tid : 0;
+}
+
+
+int
+SMQ_resolve(SMQ* o)
+{
+   U16 i;
+   if(!o->rxPending)
+      SMQ_resetb(o);
+   for(i = 0 ; i < o->topicsLen ; i++)
+   {
+      SMQTopic* t = o->topics + i;
+      if(!t->name || (t->flags & SMQ_TOPIC_VALID))
+         continue;
+      if(t->flags & SMQ_TOPIC_SUBTOPIC)
+      {
+         if(SMQ_putSubOrCreate(o, t->name, MSG_CREATESUB)) return o->status;
+         continue;
+      }
+      if((t->flags & SMQ_TOPIC_CREATE) &&
+         SMQ_putSubOrCreate(o, t->name, MSG_CREATE))
+      {
+         return o->status;
+      }
+      if((t->flags & SMQ_TOPIC_SUBSCRIBE) &&
+         SMQ_putSubOrCreate(o, t->name, MSG_SUBSCRIBE))
+      {
+         return o->status;
+      }
+   }
+   return SMQ_flushb(o);
+}
+
+
+int
+SMQ_pendingTopics(SMQ* o)
+{
+   U16 i;
+   int pending = 0;
+   for(i = 0 ; i < o->topicsLen ; i++)
+   {
+      if(o->topics[i].name && !(o->topics[i].flags & SMQ_TOPIC_VALID))
+         pending++;
+   }
+   return pending;
+}
+
+
+void
+SMQ_setChunkHandler(SMQ* o, SMQ_ChunkHandler handler)
+{
+   o->chunkHandler = handler;
+   o->bytesRead = 0;
+}
+
+
 int
 SMQ_observe(SMQ* o, U32 tid)
 {
@@ -510,16 +822,28 @@ SMQ_getMessage(SMQ* o, U8** msg)
 {
    int x;
 
+   if(SMQ_batchDue(o) && SMQ_sendBatch(o))
+      return o->status;
+
+   if(o->bytesRead && o->chunkHandler)
+      return SMQ_streamData(o);
+
    if(o->bytesRead)
    {
       if(o->bytesRead < o->frameLen)
       {
          U16 size = o->frameLen - o->bytesRead;
          *msg = o->buf;
+         SMQ_resumeb(o);
          x=SMQ_readData(o, size <= o->bufLen ? size : o->bufLen);
+         if(x < 0)
+         {
+            if(x != SMQE_TIMEOUT)
+               o->bytesRead = 0;
+            return SMQ_readError(o);
+         }
          SMQ_resetb(o);
-         if(x > 0) o->bytesRead += (U16)x;
-         else o->bytesRead = 0;
+         o->bytesRead += (U16)x;
          return x;
       }
       o->bytesRead = 0;
@@ -529,38 +853,48 @@ SMQ_getMessage(SMQ* o, U8** msg)
    if(SMQ_readFrameHeader(o))
    {
       /* Timeout is not an error in between frames */
-      if(o->status == SMQE_TIMEOUT)
+      if(o->status == SMQE_TIMEOUT && !o->bufIx)
       {
+         U32 now = se_getTime();
+         S32 elapsed = (S32)(now - o->pingTime);
+         o->pingTime = now;
          if(o->pingTmoCounter >= 0)
          {
-            o->pingTmoCounter += o->timeout;
+            o->pingTmoCounter += elapsed;
             if(o->pingTmoCounter >= o->pingTmo)
             {
                o->pingTmoCounter = -10000; /* PONG tmo hard coded to 10 sec */
                o->bufIx=3;
                netConvU16(o->buf, (U8*)&o->bufIx); /* Frame Len */
                o->buf[2] = MSG_PING;
-               o->status=se_send(&o->sock, o->buf, o->bufIx);
+               o->status=SMQ_sendBatch(o);
+               if(o->status == 0)
+                  o->status=se_send(&o->sock, o->buf, o->bufIx);
                SMQ_resetb(o);
                if(o->status < 0) return o->status;
             }
          }
          else
          {
-            o->pingTmoCounter += o->timeout;
+            o->pingTmoCounter += elapsed;
             if(o->pingTmoCounter >= 0)
                return SMQE_PONGTIMEOUT;
          }
          return 0;
       }
-      return o->status;
+      return SMQ_readError(o);
    }
    o->pingTmoCounter=0;
+   o->pingTime = se_getTime();
    switch(o->buf[2])
    {
       case MSG_DISCONNECT:
          if(SMQ_readFrame(o, TRUE))
+         {
+            if(o->status == SMQE_TIMEOUT)
+               return SMQ_readError(o);
             o->buf[0]=0;
+         }
          else
          {
             memmove(o->buf, o->buf+3, o->frameLen-3);
@@ -571,7 +905,7 @@ SMQ_getMessage(SMQ* o, U8** msg)
       case MSG_CREATEACK:
       case MSG_CREATESUBACK:
       case MSG_SUBACK:
-         if(SMQ_readFrame(o, TRUE)) return o->status;
+         if(SMQ_readFrame(o, TRUE)) return SMQ_readError(o);
          if(o->frameLen < 9) return SMQE_PROTOCOL_ERROR;
          if(msg) *msg = o->buf; /* topic name */
          if(o->buf[3]) /* Denied */
@@ -592,23 +926,43 @@ SMQ_getMessage(SMQ* o, U8** msg)
          }
          memmove(o->buf, o->buf+8, o->frameLen-8);
          o->buf[o->frameLen-8]=0;
+         if(o->topics && !o->status)
+         {
+            SMQTopic* t = SMQ_findTopic(o, (char*)o->buf,
+                          x == SMQ_CREATESUBACK ? SMQ_TOPIC_SUBTOPIC : 0);
+            if(t && t->name)
+            {
+               t->tid = o->ptid;
+               t->flags |= SMQ_TOPIC_VALID;
+            }
+         }
          return x;
 
       case MSG_PUBLISH:
          if(o->frameLen < 15) return SMQE_PROTOCOL_ERROR;
-         o->bytesRead = o->frameLen <= o->bufLen ? o->frameLen : o->bufLen;
-         x=SMQ_readData(o, o->bytesRead);
-         SMQ_resetb(o);
+         if(o->chunkHandler)
+         {
+            x=SMQ_readData(o, 15);
+            if(x < 0) return SMQ_readError(o);
+            SMQ_resetb(o);
+            netConvU32((U8*)&o->tid, o->buf+3);
+            netConvU32((U8*)&o->ptid, o->buf+7);
+            netConvU32((U8*)&o->subtid, o->buf+11);
+            o->bytesRead = 15;
+            return SMQ_streamData(o);
+         }
+         x=SMQ_readData(o, o->frameLen <= o->bufLen ? o->frameLen : o->bufLen);
          if(x > 0)
          {
+            SMQ_resetb(o);
+            o->bytesRead = (U16)x;
             netConvU32((U8*)&o->tid, o->buf+3);
             netConvU32((U8*)&o->ptid, o->buf+7);
             netConvU32((U8*)&o->subtid, o->buf+11);
             *msg = o->buf + 15;
-            return o->bytesRead - 15;
+            return o->bytesRead > 15 ? o->bytesRead - 15 : SMQ_EMPTYMSG;
          }
-         o->bytesRead=0;
-         return x < 0 ? x : -1;
+         return SMQ_readError(o);
 
       case MSG_PING:
       case MSG_PONG:
@@ -622,7 +976,7 @@ SMQ_getMessage(SMQ* o, U8** msg)
 
       case MSG_CHANGE:
          if(o->frameLen != 11) return SMQE_PROTOCOL_ERROR;
-         if(SMQ_readFrame(o, TRUE)) return o->status;
+         if(SMQ_readFrame(o, TRUE)) return SMQ_readError(o);
             netConvU32((U8*)&o->ptid, o->buf+7);
             o->status = (int)o->ptid;
             netConvU32((U8*)&o->ptid, o->buf+3);
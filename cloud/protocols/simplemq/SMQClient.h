@@ -123,14 +123,56 @@
  */
 #define SMQ_SUBCHANGE        -20003
 
+/** A published message without payload received via #SMQ_getMessage.
+    SMQ::tid, SMQ::ptid, and SMQ::subtid are set as for other
+    published messages. Returned instead of zero, which signals
+    timeout.
+ */
+#define SMQ_EMPTYMSG         -20004
+
 /** @} */ /* end SMQClientRespCodes */
 
 
 #define SMQSTR(str) str, (sizeof(str)-1)
 
-/** SimpleMQ structure.
+/** \defgroup SMQTopicFlags Topic cache flags
+\ingroup SMQClient
+@{
+*/
+/** Create the topic with #SMQ_create */
+#define SMQ_TOPIC_CREATE     0x01
+/** Subscribe to the topic with #SMQ_subscribe */
+#define SMQ_TOPIC_SUBSCRIBE  0x02
+/** The name is a sub-topic, created with #SMQ_createsub */
+#define SMQ_TOPIC_SUBTOPIC   0x04
+/** @} */ /* end SMQTopicFlags */
+
+/** Topic name to topic ID cache entry. See #SMQ_setTopicCache.
  */
 typedef struct
+{
+   const char* name; /**< Topic name, NULL if the entry is free */
+   U32 tid; /**< Topic ID, zero until resolved */
+   U8 flags; /**< [Topic cache flags](\ref SMQTopicFlags) */
+} SMQTopic;
+
+struct SMQ;
+
+/** Message chunk callback. See #SMQ_setChunkHandler.
+    \param o the SMQ instance. SMQ::tid, SMQ::ptid, and SMQ::subtid are
+    set for the message being delivered.
+    \param data the chunk, valid until the callback returns.
+    \param len chunk length.
+    \param offset position of the chunk in the message payload.
+    \param total payload length. The message is complete when
+    offset + len == total.
+ */
+typedef void (*SMQ_ChunkHandler)(struct SMQ* o, const U8* data, U16 len,
+                                 U16 offset, U16 total);
+
+/** SimpleMQ structure.
+ */
+typedef struct SMQ
 {
    SOCKET sock;
 
@@ -140,6 +182,7 @@ typedef struct
        data */
    U32 timeout;
    S32 pingTmoCounter,pingTmo;
+   U32 pingTime; /* se_getTime when pingTmoCounter was last updated */
    U32 clientTid; /**< Client's unique topic ID */
    U32 tid;  /**< Topic: set when receiving MSG_PUBLISH from broker */
    U32 ptid; /**< Publisher's tid: Set when receiving MSG_PUBLISH from broker */
@@ -151,6 +194,15 @@ typedef struct
    /** Read frame data using SMQ_getMessage until: frameLen - bytesRead = 0 */
    U16 bytesRead;
    U8 inRecv; /* boolean set to true when thread blocked in SMQ_recv */
+   U8 rxPending; /* boolean: buf holds part of a frame not yet received */
+   U8* batchBuf; /* Publish batch buffer set via SMQ_setBatch */
+   U32 batchTime; /* se_getTime when the oldest batched frame was queued */
+   U32 batchDelay;
+   U16 batchLen;
+   U16 batchIx;
+   SMQTopic* topics; /* Topic cache set via SMQ_setTopicCache */
+   SMQ_ChunkHandler chunkHandler; /* Set via SMQ_setChunkHandler */
+   U16 topicsLen;
 } SMQ;
 
 
@@ -337,6 +389,90 @@ int SMQ_write(SMQ* o,  const void* data, int len);
 int SMQ_pubflush(SMQ* o, U32 tid, U32 subtid);
 
 
+/** Enable or disable batched publishing. In batch mode, #SMQ_publish
+    queues the message frame in 'buf' instead of sending it, and the
+    queued frames are sent together, as one TCP write, when:
+    \li the next frame does not fit in 'buf', or 'buf' is full.
+    \li the oldest queued frame has waited 'maxDelay' milliseconds. This
+    is checked by #SMQ_publish and #SMQ_getMessage, thus an application
+    calling neither for a while must call #SMQ_flush from a timer.
+    \li #SMQ_flush is called.
+    \li any other message is sent to the broker, so the order in which
+    messages are sent is kept.
+
+    Messages larger than 'buf' are sent directly.
+    \param o the SMQ instance.
+    \param buf the batch buffer, or NULL to send the queued frames and
+    disable batching.
+    \param len buffer length.
+    \param maxDelay maximum time in milliseconds a message is held back.
+ */
+int SMQ_setBatch(SMQ* o, U8* buf, U16 len, U32 maxDelay);
+
+/** Send the message frames queued in batch mode. See #SMQ_setBatch.
+    \param o the SMQ instance.
+ */
+int SMQ_flush(SMQ* o);
+
+/** Set the storage for the topic name to topic ID cache. Topics added
+    with #SMQ_addTopic are resolved together by #SMQ_resolve: all the
+    create and subscribe requests are sent in one write and the topic
+    IDs are filled in as #SMQ_getMessage receives the responses. The
+    cache is revalidated the same way each time #SMQ_connect succeeds,
+    so a reconnect costs about one round trip regardless of the number
+    of topics. Topic IDs from the previous connection remain available
+    via #SMQ_getTid until the broker responds.
+    \param o the SMQ instance.
+    \param cache a hash table of 'len' entries, preferably larger than
+    the number of topics.
+    \param len number of entries.
+ */
+void SMQ_setTopicCache(SMQ* o, SMQTopic* cache, U16 len);
+
+/** Add a topic or sub-topic to the cache without sending any
+    request. Adding a name already in the cache adds the flags.
+    \param o the SMQ instance.
+    \param name the topic name. The cache keeps the pointer, not a copy.
+    \param flags [topic cache flags](\ref SMQTopicFlags).
+    \returns 0 on success or #SMQE_BUF_OVERFLOW if the cache is full.
+ */
+int SMQ_addTopic(SMQ* o, const char* name, U8 flags);
+
+/** Send the requests for all cached topics not yet confirmed on the
+    current connection. Called by #SMQ_connect.
+    \param o the SMQ instance.
+ */
+int SMQ_resolve(SMQ* o);
+
+/** Returns the cached topic ID, or zero if not known.
+    \param o the SMQ instance.
+    \param name the topic name.
+    \param subtopic TRUE to look up a sub-topic.
+ */
+U32 SMQ_getTid(SMQ* o, const char* name, int subtopic);
+
+/** Returns the number of cached topics waiting for a broker response
+    on the current connection. A denied request stays pending since
+    the broker response does not carry the topic name.
+    \param o the SMQ instance.
+ */
+int SMQ_pendingTopics(SMQ* o);
+
+/** Receive published messages as a stream of chunks. When a handler is
+    set, #SMQ_getMessage passes the payload of each received message to
+    it in chunks, as the data arrives, read into SMQ::buf. Messages
+    of any size can then be processed without a buffer for the whole
+    message. #SMQ_getMessage returns the payload size once the whole
+    message has been delivered, #SMQ_EMPTYMSG for a message without
+    payload, and zero if it timed out in the middle of the message,
+    in which case the next call continues where it stopped.
+    The 'msg' out parameter is not set for published messages.
+    \param o the SMQ instance.
+    \param handler the chunk handler, or NULL to return to the default
+    behavior.
+ */
+void SMQ_setChunkHandler(SMQ* o, SMQ_ChunkHandler handler);
+
 /** Request the broker to provide change notification events when the
     number of subscribers to a specific topic changes. Ephemeral topic
     IDs can also be observed. The number of connected subscribers for
@@ -380,6 +516,14 @@ int SMQ_unobserve(SMQ* o, U32 tid);
     thus far is returned in SMQ::bytesRead. The complete frame is
     consumed when frameLen == bytesRead.
 
+    The function also returns zero when se_recv runs out of data in
+    the middle of a frame. The bytes received so far are kept and the
+    next call continues the frame, thus a port where se_recv does not
+    wait can call SMQ_getMessage each time data arrives. Functions
+    sending frames through the buffer send them directly while a
+    frame is pending, except SMQ_write and SMQ_pubflush, which return
+    #SMQE_PROTOCOL_ERROR.
+
     <b>Note:</b> the default timeout value is set to one minute. You
     can set the timeout value by setting SharkMQ::timeout to the
     number of milliseconds you want to wait for incoming messages
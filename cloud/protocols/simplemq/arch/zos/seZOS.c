@@ -16,6 +16,9 @@
 #define SMQ_ZOS_DEBUG(x, ...)
 #endif
 
+// Sleep between two reads while the SMQ_init() and SMQ_connect() handshakes wait for the server
+#define SE_RECV_POLL_MS 10
+
 
 
 
@@ -35,6 +38,7 @@ int se_connect(SOCKET* sock, const char* address, U16 port)
 void se_close(SOCKET* sock)
 {
     sockets[sock->handle] = NULL;
+    sock->rx_head = sock->rx_tail = 0;
     SMQ_ZOS_DEBUG("diconnect: %d", sock->handle);
     zn_tcp_disconnect(sock->handle);
 }
@@ -53,10 +57,14 @@ S32 se_send(SOCKET* sock, const void* buf, U32 len)
 /*************************************************************************************************/
 S32 se_recv(SOCKET* sock, void* buf, U32 len, U32 timeout)
 {
-    S32 retval = 0;
+    S32 retval = rx_buffer_read(sock, buf, len);
     const uint32_t start_time = zn_rtos_get_time();
 
-    do
+    // Nothing buffered, typically the rest of a frame that did not fit in the buffer, so read the
+    // stack directly. Once the receive event is registered, return 0 rather than block the event
+    // thread: the client keeps the partial frame and continues it on the next receive event.
+    // Only the handshake before that waits for up to 'timeout'.
+    while(retval == 0)
     {
         uint32_t bytes_read = 0;
         zos_result_t result = zn_tcp_read(sock->handle, buf, len, &bytes_read);
@@ -64,16 +72,30 @@ S32 se_recv(SOCKET* sock, void* buf, U32 len, U32 timeout)
         {
             retval = -1;
         }
-        else
+        else if(bytes_read > 0)
         {
             retval = bytes_read;
         }
-    } while((zn_rtos_get_time() - start_time) < timeout && retval == 0);
+        else if(sockets[sock->handle] != sock && (zn_rtos_get_time() - start_time) < timeout)
+        {
+            zn_rtos_delay_milliseconds(SE_RECV_POLL_MS);
+        }
+        else
+        {
+            break;
+        }
+    }
 
     SMQ_ZOS_DEBUG("recv: %d, %d", retval, sock->handle);
     return retval;
 }
 
+/*************************************************************************************************/
+U32 se_getTime(void)
+{
+    return zn_rtos_get_time();
+}
+
 /*************************************************************************************************/
 void SMQ_register_message_handler(SOCKET* sock, zos_event_handler_t message_handler)
 {
@@ -98,11 +120,70 @@ static void disconnect_event_handler(uint32_t handle)
 static void receive_event_handler(uint32_t handle)
 {
     SOCKET* sock = sockets[handle];
+    zos_result_t result;
 
     SMQ_ZOS_DEBUG("rx event");
 
-    if(sock != NULL && sock->message_handler != NULL)
+    if(sock == NULL)
+    {
+        return;
+    }
+
+    result = rx_buffer_fill(sock);
+
+    // Resume the client only when it has something to consume, and keep resuming it
+    // while it makes progress so frames arriving together are handled in one event
+    while(sockets[handle] == sock && sock->message_handler != NULL &&
+          (sock->rx_head != sock->rx_tail || result != ZOS_SUCCESS))
     {
+        const uint16_t pending = sock->rx_tail - sock->rx_head;
+
         sock->message_handler(sock);
+
+        if(sockets[handle] != sock || result != ZOS_SUCCESS || (sock->rx_tail - sock->rx_head) == pending)
+        {
+            break;
+        }
+        else if(sock->rx_head == sock->rx_tail)
+        {
+            result = rx_buffer_fill(sock);
+        }
     }
 }
+
+/*************************************************************************************************/
+static zos_result_t rx_buffer_fill(SOCKET* sock)
+{
+    zos_result_t result = ZOS_SUCCESS;
+    uint32_t bytes_read = 0;
+
+    if(sock->rx_head > 0)
+    {
+        memmove(sock->rx_buffer, &sock->rx_buffer[sock->rx_head], sock->rx_tail - sock->rx_head);
+        sock->rx_tail -= sock->rx_head;
+        sock->rx_head = 0;
+    }
+
+    if(sock->rx_tail < sizeof(sock->rx_buffer))
+    {
+        result = zn_tcp_read(sock->handle, &sock->rx_buffer[sock->rx_tail], sizeof(sock->rx_buffer) - sock->rx_tail, &bytes_read);
+        sock->rx_tail += (result == ZOS_SUCCESS) ? bytes_read : 0;
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+static S32 rx_buffer_read(SOCKET* sock, void* buf, U32 len)
+{
+    const U32 pending = sock->rx_tail - sock->rx_head;
+
+    if(len > pending)
+    {
+        len = pending;
+    }
+    memcpy(buf, &sock->rx_buffer[sock->rx_head], len);
+    sock->rx_head += len;
+
+    return len;
+}
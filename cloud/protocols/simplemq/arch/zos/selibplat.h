@@ -51,10 +51,21 @@ extern "C" {
 }
 #endif
 
+/* Bytes buffered per socket by the TCP receive event */
+#ifndef SE_RX_BUFFER_SIZE
+#define SE_RX_BUFFER_SIZE 512
+#endif
+
 typedef struct {
    uint32_t handle;
    zos_event_handler_t message_handler;
+   uint16_t rx_head; /* Next buffered byte handed to se_recv */
+   uint16_t rx_tail; /* End of the buffered bytes */
+   uint8_t rx_buffer[SE_RX_BUFFER_SIZE];
 } SOCKET;
 
 
+/* Call after SMQ_connect: from then on se_recv never waits, and the
+   handler calls SMQ_getMessage on each receive event to continue.
+*/
 void SMQ_register_message_handler(SOCKET* sock, zos_event_handler_t message_handler);
@@ -170,6 +170,11 @@ S32 se_send(SOCKET* sock, const void* buf, U32 len);
  */
 S32 se_recv(SOCKET* sock, void* buf, U32 len, U32 timeout);
 
+/** Returns a free running millisecond counter. SimpleMQ uses it for
+    the publish batch delay.
+ */
+U32 se_getTime(void);
+
 #if XPRINTF == 1
 /** The macro xprintf expands to function _xprintf if the code is
     compiled with XPRINTF set to 1.
@@ -72,6 +72,21 @@ static const zos_i2c_device_t const i2c_bmi160 =
 
 /* user defined code to be added here ... */
 static struct bmi160_t *p_bmi160;
+/* accel configuration register reset values */
+#define BMI160_ACCEL_CONFIG_RESET {\
+BMI160_ACCEL_OUTPUT_DATA_RATE_100HZ, BMI160_ACCEL_NORMAL_AVG4,\
+BMI160_ACCEL_RANGE_2G, ACCEL_SUSPEND, C_BMI160_ZERO_U8X}
+/* accel configuration written through this driver, starts at the register reset values */
+static struct bmi160_accel_config_t accel_config_shadow =
+BMI160_ACCEL_CONFIG_RESET;
+/* accel full scale in mG indexed by BMI160_ACCEL_RANGE_xG,
+reserved codes fall back to 2G */
+static const s32 accel_range_mg[16] = {
+2000, 2000, 2000, 2000,/* 0x03: BMI160_ACCEL_RANGE_2G */
+2000, 4000, 2000, 2000,/* 0x05: BMI160_ACCEL_RANGE_4G */
+8000, 2000, 2000, 2000,/* 0x08: BMI160_ACCEL_RANGE_8G */
+16000, 2000, 2000, 2000/* 0x0C: BMI160_ACCEL_RANGE_16G */
+};
 /* used for reading the mag trim values for compensation*/
 static struct trim_data_t mag_trim;
 /* the following variable used for avoiding the selecting of auto mode
@@ -3115,6 +3130,34 @@ u8 *v_fifo_data_u8)
 		}
 	return com_rslt;
 }
+/*!
+ *	@brief This API reads a given number of bytes of fifo data
+ *	from the register 0x24 in a single burst
+ *	@brief Reading past the fill level returns the
+ *	sensortime frame (when enabled) followed by over-read frames
+ *
+ *
+ *
+ *  @param v_fifo_data_u8 : Pointer holding the fifo data
+ *  @param v_fifo_length_u16 : Number of bytes to read
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error
+ *
+ *
+*/
+BMI160_RETURN_FUNCTION_TYPE bmi160_fifo_data_length(
+u8 *v_fifo_data_u8, u16 v_fifo_length_u16)
+{
+	/* variable used for return the status of communication result*/
+	BMI160_RETURN_FUNCTION_TYPE com_rslt = E_BMI160_COMM_RES;
+	/* read fifo data*/
+	com_rslt =
+			zn_i2c_master_read_reg(&i2c_bmi160,
+	BMI160_USER_FIFO_DATA__REG, v_fifo_data_u8, v_fifo_length_u16);
+	return com_rslt;
+}
 /*!
  *	@brief This API is used to get the
  *	accel output date rate form the register 0x40 bit 0 to 3
@@ -3219,6 +3262,10 @@ u8 v_output_data_rate_u8)
 						zn_i2c_master_write_reg(&i2c_bmi160,
 				BMI160_USER_ACCEL_CONFIG_OUTPUT_DATA_RATE__REG,
 				&v_data_u8, C_BMI160_ONE_U8X);
+				if (com_rslt == SUCCESS) {
+					accel_config_shadow.output_data_rate = v_output_data_rate_u8;
+					accel_config_shadow.valid |= BMI160_ACCEL_SHADOW_OUTPUT_DATA_RATE;
+				}
 			}
 		} else {
 		com_rslt = E_BMI160_OUT_OF_RANGE;
@@ -3359,6 +3406,10 @@ BMI160_RETURN_FUNCTION_TYPE bmi160_set_accel_bw(u8 v_bw_u8)
 						zn_i2c_master_write_reg(&i2c_bmi160,
 				BMI160_USER_ACCEL_CONFIG_ACCEL_BW__REG,
 				&v_data_u8, C_BMI160_ONE_U8X);
+				if (com_rslt == SUCCESS) {
+					accel_config_shadow.bw = v_bw_u8;
+					accel_config_shadow.valid |= BMI160_ACCEL_SHADOW_BW;
+				}
 			}
 		} else {
 		com_rslt = E_BMI160_OUT_OF_RANGE;
@@ -3552,6 +3603,10 @@ BMI160_RETURN_FUNCTION_TYPE bmi160_set_accel_range(u8 v_range_u8)
 						zn_i2c_master_write_reg(&i2c_bmi160,
 				BMI160_USER_ACCEL_RANGE__REG,
 				&v_data_u8, C_BMI160_ONE_U8X);
+				if (com_rslt == SUCCESS) {
+					accel_config_shadow.range = v_range_u8;
+					accel_config_shadow.valid |= BMI160_ACCEL_SHADOW_RANGE;
+				}
 			}
 		} else {
 		com_rslt = E_BMI160_OUT_OF_RANGE;
@@ -14993,6 +15048,23 @@ BMI160_RETURN_FUNCTION_TYPE bmi160_set_command_register(u8 v_command_reg_u8)
 			com_rslt = zn_i2c_master_write_reg(&i2c_bmi160,
 			BMI160_CMD_COMMANDS__REG,
 			&v_command_reg_u8, C_BMI160_ONE_U8X);
+			/* a soft reset returns the accel configuration
+			to its reset values */
+			if ((com_rslt == SUCCESS) &&
+			(v_command_reg_u8 == BMI160_SOFT_RESET)) {
+				const struct bmi160_accel_config_t
+				accel_config_reset = BMI160_ACCEL_CONFIG_RESET;
+				accel_config_shadow = accel_config_reset;
+			}
+			/* track accel power mode commands */
+			if ((com_rslt == SUCCESS) &&
+			((v_command_reg_u8 == ACCEL_SUSPEND) ||
+			(v_command_reg_u8 == ACCEL_MODE_NORMAL) ||
+			(v_command_reg_u8 == ACCEL_LOWPOWER))) {
+				accel_config_shadow.power_mode = v_command_reg_u8;
+				accel_config_shadow.valid |=
+				BMI160_ACCEL_SHADOW_POWER_MODE;
+			}
 		}
 	return com_rslt;
 }
@@ -18490,3 +18562,35 @@ const s8 *p_offset_s8)
 	return com_rslt;
 }
 
+/*!
+ *	@brief This function returns the accel configuration
+ *	shadow, holding the output data rate, bandwidth, range and
+ *	power mode last written through this driver
+ *
+ *	@note Only fields flagged in the valid member have been written
+ *	since start up, the others hold the register reset values
+ *
+ *  @return the reference of the accel configuration shadow
+ *
+ *
+*/
+const struct bmi160_accel_config_t *bmi160_get_accel_config_shadow(void)
+{
+	return &accel_config_shadow;
+}
+/*!
+ *	@brief This function returns the full scale of an accel
+ *	range setting
+ *
+ *  @param v_range_u8 : The value of accel range
+ *	BMI160_ACCEL_RANGE_2G .. BMI160_ACCEL_RANGE_16G, reserved
+ *	codes give the 2G full scale
+ *
+ *  @return the full scale in mG
+ *
+ *
+*/
+s32 bmi160_accel_range_mg(u8 v_range_u8)
+{
+	return accel_range_mg[v_range_u8 & BMI160_USER_ACCEL_RANGE__MSK];
+}
@@ -910,6 +910,16 @@ s16 x;/**<accel X  data*/
 s16 y;/**<accel Y  data*/
 s16 z;/**<accel Z  data*/
 };
+/*!
+ * @brief Structure containing the accel configuration shadow
+ */
+struct bmi160_accel_config_t {
+u8 output_data_rate;/**<accel output data rate*/
+u8 bw;/**<accel bandwidth*/
+u8 range;/**<accel g range*/
+u8 power_mode;/**<accel power mode command*/
+u8 valid;/**<BMI160_ACCEL_SHADOW_xxx bits of the fields written*/
+};
 /*!
  * @brief Structure bmm150 mag compensated data with s32 output
  */
@@ -3188,6 +3198,13 @@ BMI160_USER_STEP_CONFIG_1_ADDR
 #define	ACCEL_LOWPOWER		0X12
 #define	ACCEL_SUSPEND		0X10
 /**************************************************/
+/**\name	ACCEL CONFIGURATION SHADOW VALID BITS    */
+/*************************************************/
+#define BMI160_ACCEL_SHADOW_OUTPUT_DATA_RATE	0x01
+#define BMI160_ACCEL_SHADOW_BW				0x02
+#define BMI160_ACCEL_SHADOW_RANGE			0x04
+#define BMI160_ACCEL_SHADOW_POWER_MODE		0x08
+/**************************************************/
 /**\name	GYRO POWER MODE    */
 /*************************************************/
 #define GYRO_MODE_SUSPEND		0x14
@@ -3293,6 +3310,7 @@ BMI160_USER_STEP_CONFIG_1_ADDR
 #define BMI160_COMMAND_REG_TWO		0x9A
 #define BMI160_COMMAND_REG_THREE	0xC0
 #define	RESET_STEP_COUNTER			0xB2
+#define	BMI160_SOFT_RESET			0xB6
 /**************************************************/
 /**\name	BIT SLICE GET AND SET FUNCTIONS  */
 /*************************************************/
@@ -4982,6 +5000,25 @@ u32 *v_fifo_length_u32);
 */
 BMI160_RETURN_FUNCTION_TYPE bmi160_fifo_data(
 u8 *v_fifo_data_u8);
+/*!
+ *	@brief This API reads a given number of bytes of fifo data
+ *	from the register 0x24 in a single burst
+ *	@brief Reading past the fill level returns the
+ *	sensortime frame (when enabled) followed by over-read frames
+ *
+ *
+ *
+ *  @param v_fifo_data_u8 : Pointer holding the fifo data
+ *  @param v_fifo_length_u16 : Number of bytes to read
+ *
+ *	@return results of bus communication function
+ *	@retval 0 -> Success
+ *	@retval -1 -> Error
+ *
+ *
+*/
+BMI160_RETURN_FUNCTION_TYPE bmi160_fifo_data_length(
+u8 *v_fifo_data_u8, u16 v_fifo_length_u16);
 /**************************************************/
 /**\name	 FUNCTION FOR ACCEL CONFIGURATIONS */
 /*************************************************/
@@ -11282,6 +11319,32 @@ BMI160_RETURN_FUNCTION_TYPE bmi160_read_fifo_header_data(u32 v_fifo_length_u32);
  *
 */
 struct bmi160_t *bmi160_get_ptr(void);
+/*!
+ *	@brief This function returns the accel configuration
+ *	shadow, holding the output data rate, bandwidth, range and
+ *	power mode last written through this driver
+ *
+ *	@note Only fields flagged in the valid member have been written
+ *	since start up, the others hold the register reset values
+ *
+ *  @return the reference of the accel configuration shadow
+ *
+ *
+*/
+const struct bmi160_accel_config_t *bmi160_get_accel_config_shadow(void);
+/*!
+ *	@brief This function returns the full scale of an accel
+ *	range setting
+ *
+ *  @param v_range_u8 : The value of accel range
+ *	BMI160_ACCEL_RANGE_2G .. BMI160_ACCEL_RANGE_16G, reserved
+ *	codes give the 2G full scale
+ *
+ *  @return the full scale in mG
+ *
+ *
+*/
+s32 bmi160_accel_range_mg(u8 v_range_u8);
 
 #endif
 
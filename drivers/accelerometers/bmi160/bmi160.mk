@@ -1,4 +1,5 @@
 NAME := drivers_accelerometers_bmi160
 
-$(NAME)_SOURCES := bmi160.c sensor_api.c
+$(NAME)_SOURCES := bmi160.c bmi160_fifo.c sensor_api.c
 $(NAME)_INCLUDES := .
+GLOBAL_INCLUDES := .
@@ -0,0 +1,396 @@
+/*
+ * ZentriOS SDK LICENSE AGREEMENT | Zentri.com, 2015.
+ *
+ * Use of source code and/or libraries contained in the ZentriOS SDK is
+ * subject to the Zentri Operating System SDK license agreement and
+ * applicable open source license agreements.
+ *
+ */
+
+#include "zos.h"
+#include "bmi160_fifo.h"
+#include "bmi160.h"
+
+
+/* Header-mode frame headers, bits [1:0] carry interrupt tags and are masked off */
+#define FIFO_HEADER_MASK                0xFC
+#define FIFO_HEADER_MODE_MASK           0xC0
+#define FIFO_HEADER_MODE_REGULAR        0x80
+#define FIFO_HEADER_PARM_MAG            0x10
+#define FIFO_HEADER_PARM_GYRO           0x08
+#define FIFO_HEADER_PARM_ACCEL          0x04
+#define FIFO_HEAD_INPUT_CONFIG          0x48
+#define FIFO_HEAD_OVER_READ             0x80
+
+#define FIFO_MAG_FRAME_LENGTH           8
+#define FIFO_AXES_FRAME_LENGTH          6
+#define FIFO_SENSORTIME_LENGTH          3
+#define FIFO_WATERMARK_UNIT             4
+
+#define BMI160_CMD_FIFO_FLUSH           0xB0
+
+
+typedef zos_bool_t (*sample_handler_t)(const bmi160_fifo_sample_t *sample, void *arg);
+
+static zos_result_t fifo_drain(sample_handler_t handler, void *arg, bmi160_fifo_stats_t *stats);
+static uint16_t fifo_read_length(u32 fifo_length);
+static void fifo_parse(uint16_t read_length, sample_handler_t handler, void *arg, bmi160_fifo_stats_t *stats);
+static zos_bool_t next_frame(uint16_t *index, uint16_t length, uint8_t *header, const uint8_t **payload);
+static zos_bool_t store_sample(const bmi160_fifo_sample_t *sample, void *arg);
+static zos_bool_t store_accel_sample(const bmi160_fifo_sample_t *sample, void *arg);
+static void parse_axes(const uint8_t *data, int32_t *x, int32_t *y, int32_t *z);
+static void convert_sample(bmi160_fifo_sample_t *sample);
+static uint32_t odr_to_ticks(uint8_t odr);
+
+
+typedef struct
+{
+    void *buffer;
+    uint32_t *sensortimes;
+    uint16_t max_samples;
+    uint16_t count;
+} sample_sink_t;
+
+static struct
+{
+    uint8_t accel_range;
+    uint8_t gyro_range;
+    uint8_t frame_length;
+    uint16_t watermark_bytes;
+    uint32_t ticks_per_sample;
+} fifo_context;
+
+/* FIFO contents plus the sensortime frame appended after the last data frame */
+static uint8_t fifo_buffer[BMI160_FIFO_SIZE + 1 + FIFO_SENSORTIME_LENGTH];
+
+
+
+/*************************************************************************************************/
+zos_result_t bmi160_fifo_init(const bmi160_fifo_config_t *config)
+{
+    zos_result_t result;
+    uint32_t wm_units;
+
+    fifo_context.accel_range = config->accel_range;
+    fifo_context.gyro_range = config->gyro_range;
+    fifo_context.ticks_per_sample = odr_to_ticks(config->odr);
+    fifo_context.frame_length = 1 + ((config->accel_enable) ? FIFO_AXES_FRAME_LENGTH : 0) +
+                                    ((config->gyro_enable) ? FIFO_AXES_FRAME_LENGTH : 0);
+
+    wm_units = ((uint32_t)config->watermark * fifo_context.frame_length + FIFO_WATERMARK_UNIT - 1) / FIFO_WATERMARK_UNIT;
+    if(wm_units > 0xFF)
+    {
+        wm_units = 0xFF;
+    }
+    fifo_context.watermark_bytes = (uint16_t)(wm_units * FIFO_WATERMARK_UNIT);
+
+    if(!config->accel_enable && !config->gyro_enable)
+    {
+        result = ZOS_INVALID_ARG;
+    }
+    else if(config->accel_enable &&
+            (ZOS_FAILED(result, bmi160_set_command_register(ACCEL_MODE_NORMAL)) ||
+             ZOS_FAILED(result, bmi160_set_accel_output_data_rate(config->odr)) ||
+             ZOS_FAILED(result, bmi160_set_accel_range(config->accel_range))))
+    {
+    }
+    else if(config->gyro_enable &&
+            (ZOS_FAILED(result, bmi160_set_command_register(GYRO_MODE_NORMAL)) ||
+             ZOS_FAILED(result, bmi160_set_gyro_output_data_rate(config->odr)) ||
+             ZOS_FAILED(result, bmi160_set_gyro_range(config->gyro_range))))
+    {
+    }
+    else if(ZOS_FAILED(result, bmi160_set_fifo_header_enable(FIFO_HEADER_ENABLE)))
+    {
+    }
+    else if(ZOS_FAILED(result, bmi160_set_fifo_time_enable(FIFO_TIME_ENABLE)))
+    {
+    }
+    else if(ZOS_FAILED(result, bmi160_set_fifo_accel_enable(config->accel_enable ? FIFO_ACCEL_ENABLE : 0)))
+    {
+    }
+    else if(ZOS_FAILED(result, bmi160_set_fifo_gyro_enable(config->gyro_enable ? FIFO_GYRO_ENABLE : 0)))
+    {
+    }
+    else if(ZOS_FAILED(result, bmi160_set_fifo_mag_enable(0)))
+    {
+    }
+    else if(ZOS_FAILED(result, bmi160_set_fifo_wm((u8)wm_units)))
+    {
+    }
+    else if(ZOS_FAILED(result, bmi160_set_command_register(BMI160_CMD_FIFO_FLUSH)))
+    {
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+zos_result_t bmi160_fifo_has_data(zos_bool_t *has_data)
+{
+    zos_result_t result;
+    u32 fifo_length;
+
+    *has_data = ZOS_FALSE;
+
+    if(!ZOS_FAILED(result, bmi160_fifo_length(&fifo_length)))
+    {
+        *has_data = (fifo_length > 0 && fifo_length >= fifo_context.watermark_bytes) ? ZOS_TRUE : ZOS_FALSE;
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+zos_result_t bmi160_fifo_read(bmi160_fifo_sample_t *samples, uint16_t max_samples, uint16_t *sample_count, bmi160_fifo_stats_t *stats)
+{
+    zos_result_t result;
+    sample_sink_t sink = { .buffer = samples, .sensortimes = NULL, .max_samples = max_samples, .count = 0 };
+
+    result = fifo_drain(store_sample, &sink, stats);
+    *sample_count = sink.count;
+
+    return result;
+}
+
+/*************************************************************************************************/
+zos_result_t bmi160_fifo_read_accel(accelerometer_data_t *data, uint32_t *sensortimes, uint16_t max_samples, uint16_t *sample_count, bmi160_fifo_stats_t *stats)
+{
+    zos_result_t result;
+    sample_sink_t sink = { .buffer = data, .sensortimes = sensortimes, .max_samples = max_samples, .count = 0 };
+
+    result = fifo_drain(store_accel_sample, &sink, stats);
+    *sample_count = sink.count;
+
+    return result;
+}
+
+/*************************************************************************************************/
+static zos_result_t fifo_drain(sample_handler_t handler, void *arg, bmi160_fifo_stats_t *stats)
+{
+    zos_result_t result;
+    u32 fifo_length;
+    bmi160_fifo_stats_t local_stats = { 0, 0 };
+
+    if(ZOS_FAILED(result, bmi160_fifo_length(&fifo_length)) || (fifo_length == 0))
+    {
+    }
+    // Read past the fill level so the sensortime frame comes back in the same burst
+    else if(ZOS_FAILED(result, bmi160_fifo_data_length(fifo_buffer, fifo_read_length(fifo_length))))
+    {
+    }
+    else
+    {
+        fifo_parse(fifo_read_length(fifo_length), handler, arg, &local_stats);
+    }
+
+    if(stats != NULL)
+    {
+        *stats = local_stats;
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+static uint16_t fifo_read_length(u32 fifo_length)
+{
+    if(fifo_length > BMI160_FIFO_SIZE)
+    {
+        fifo_length = BMI160_FIFO_SIZE;
+    }
+    return (uint16_t)fifo_length + 1 + FIFO_SENSORTIME_LENGTH;
+}
+
+/*************************************************************************************************/
+static void fifo_parse(uint16_t read_length, sample_handler_t handler, void *arg, bmi160_fifo_stats_t *stats)
+{
+    uint16_t index;
+    uint16_t frames = 0;
+    uint16_t frame = 0;
+    uint32_t sensortime = 0;
+    zos_bool_t have_sensortime = ZOS_FALSE;
+    uint8_t header;
+    const uint8_t *payload;
+
+    // First pass: count data frames and find the sensortime of the last one
+    for(index = 0; next_frame(&index, read_length, &header, &payload);)
+    {
+        if((header & FIFO_HEADER_MODE_MASK) == FIFO_HEADER_MODE_REGULAR)
+        {
+            ++frames;
+        }
+        else if(header == FIFO_HEAD_SKIP_FRAME)
+        {
+            stats->skipped += payload[0];
+        }
+        else if(header == FIFO_HEAD_SENSOR_TIME)
+        {
+            sensortime = (uint32_t)payload[0] | ((uint32_t)payload[1] << 8) | ((uint32_t)payload[2] << 16);
+            have_sensortime = ZOS_TRUE;
+        }
+    }
+
+    // Second pass: emit samples, walking time back one period per frame from the last one
+    for(index = 0; next_frame(&index, read_length, &header, &payload);)
+    {
+        bmi160_fifo_sample_t sample = { 0 };
+
+        if((header & FIFO_HEADER_MODE_MASK) != FIFO_HEADER_MODE_REGULAR)
+        {
+            continue;
+        }
+
+        ++frame;
+        sample.sensortime = (have_sensortime) ?
+                ((sensortime - (uint32_t)(frames - frame) * fifo_context.ticks_per_sample) & BMI160_SENSORTIME_MASK) : 0;
+
+        // Frame payload order is mag, gyro, accel. Mag is not supported and skipped
+        payload += (header & FIFO_HEADER_PARM_MAG) ? FIFO_MAG_FRAME_LENGTH : 0;
+        if(header & FIFO_HEADER_PARM_GYRO)
+        {
+            parse_axes(payload, &sample.gyro.x, &sample.gyro.y, &sample.gyro.z);
+            sample.flags |= BMI160_FIFO_SAMPLE_GYRO;
+            payload += FIFO_AXES_FRAME_LENGTH;
+        }
+        if(header & FIFO_HEADER_PARM_ACCEL)
+        {
+            parse_axes(payload, &sample.accel.x, &sample.accel.y, &sample.accel.z);
+            sample.flags |= BMI160_FIFO_SAMPLE_ACCEL;
+        }
+
+        if(sample.flags != 0)
+        {
+            convert_sample(&sample);
+            if(!handler(&sample, arg))
+            {
+                ++stats->truncated;
+            }
+        }
+    }
+}
+
+/*************************************************************************************************/
+/* Step over one header-mode frame, returns false at the end of valid data */
+static zos_bool_t next_frame(uint16_t *index, uint16_t length, uint8_t *header, const uint8_t **payload)
+{
+    uint16_t frame_length;
+
+    if(*index >= length)
+    {
+        return ZOS_FALSE;
+    }
+
+    *header = fifo_buffer[*index] & FIFO_HEADER_MASK;
+
+    if(*header == FIFO_HEAD_OVER_READ)
+    {
+        return ZOS_FALSE;
+    }
+    else if((*header & FIFO_HEADER_MODE_MASK) == FIFO_HEADER_MODE_REGULAR)
+    {
+        frame_length  = (*header & FIFO_HEADER_PARM_MAG)   ? FIFO_MAG_FRAME_LENGTH : 0;
+        frame_length += (*header & FIFO_HEADER_PARM_GYRO)  ? FIFO_AXES_FRAME_LENGTH : 0;
+        frame_length += (*header & FIFO_HEADER_PARM_ACCEL) ? FIFO_AXES_FRAME_LENGTH : 0;
+    }
+    else if(*header == FIFO_HEAD_SENSOR_TIME)
+    {
+        frame_length = FIFO_SENSORTIME_LENGTH;
+    }
+    else if((*header == FIFO_HEAD_SKIP_FRAME) || (*header == FIFO_HEAD_INPUT_CONFIG))
+    {
+        frame_length = 1;
+    }
+    else
+    {
+        // unknown header, the rest of the buffer can't be framed
+        return ZOS_FALSE;
+    }
+
+    // the sensor only hands out complete frames, a partial one marks the end
+    if(*index + 1 + frame_length > length)
+    {
+        return ZOS_FALSE;
+    }
+
+    *payload = &fifo_buffer[*index + 1];
+    *index += 1 + frame_length;
+
+    return ZOS_TRUE;
+}
+
+/*************************************************************************************************/
+static zos_bool_t store_sample(const bmi160_fifo_sample_t *sample, void *arg)
+{
+    sample_sink_t *sink = arg;
+
+    if(sink->count >= sink->max_samples)
+    {
+        return ZOS_FALSE;
+    }
+    ((bmi160_fifo_sample_t*)sink->buffer)[sink->count++] = *sample;
+
+    return ZOS_TRUE;
+}
+
+/*************************************************************************************************/
+static zos_bool_t store_accel_sample(const bmi160_fifo_sample_t *sample, void *arg)
+{
+    sample_sink_t *sink = arg;
+
+    if(!(sample->flags & BMI160_FIFO_SAMPLE_ACCEL))
+    {
+        return ZOS_TRUE;
+    }
+    else if(sink->count >= sink->max_samples)
+    {
+        return ZOS_FALSE;
+    }
+    if(sink->sensortimes != NULL)
+    {
+        sink->sensortimes[sink->count] = sample->sensortime;
+    }
+    ((accelerometer_data_t*)sink->buffer)[sink->count++] = sample->accel;
+
+    return ZOS_TRUE;
+}
+
+/*************************************************************************************************/
+static void parse_axes(const uint8_t *data, int32_t *x, int32_t *y, int32_t *z)
+{
+    *x = (int16_t)((data[1] << 8) | data[0]);
+    *y = (int16_t)((data[3] << 8) | data[2]);
+    *z = (int16_t)((data[5] << 8) | data[4]);
+}
+
+/*************************************************************************************************/
+static void convert_sample(bmi160_fifo_sample_t *sample)
+{
+    if(sample->flags & BMI160_FIFO_SAMPLE_ACCEL)
+    {
+        // phy_val = full_scale_range * reg_val / 32768, full scale in mG
+        const int32_t range_mg = bmi160_accel_range_mg(fifo_context.accel_range);
+        sample->accel.x = (range_mg * sample->accel.x) / 32768;
+        sample->accel.y = (range_mg * sample->accel.y) / 32768;
+        sample->accel.z = (range_mg * sample->accel.z) / 32768;
+    }
+    if(sample->flags & BMI160_FIFO_SAMPLE_GYRO)
+    {
+        // range codes halve the full scale starting from 2000 dps, full scale in milli-dps
+        const int64_t range_mdps = (int64_t)(2000 * 1000) >> fifo_context.gyro_range;
+        sample->gyro.x = (int32_t)((range_mdps * sample->gyro.x) / 32768);
+        sample->gyro.y = (int32_t)((range_mdps * sample->gyro.y) / 32768);
+        sample->gyro.z = (int32_t)((range_mdps * sample->gyro.z) / 32768);
+    }
+}
+
+/*************************************************************************************************/
+static uint32_t odr_to_ticks(uint8_t odr)
+{
+    // ODR code n samples at 100 * 2^(n-8) Hz and sensortime ticks at 25.6kHz, so a period is 2^(16-n) ticks
+    if(odr < BMI160_ACCEL_OUTPUT_DATA_RATE_0_78HZ || odr > BMI160_GYRO_OUTPUT_DATA_RATE_3200HZ)
+    {
+        odr = BMI160_ACCEL_OUTPUT_DATA_RATE_100HZ;
+    }
+    return 1UL << (16 - odr);
+}
@@ -0,0 +1,128 @@
+/*
+ * ZentriOS SDK LICENSE AGREEMENT | Zentri.com, 2015.
+ *
+ * Use of source code and/or libraries contained in the ZentriOS SDK is
+ * subject to the Zentri Operating System SDK license agreement and
+ * applicable open source license agreements.
+ *
+ */
+#pragma once
+
+#include "zos.h"
+#include "sensor/types/accelerometer/accelerometer.h"
+
+/**
+ * @addtogroup  lib_sensor_accelerometer
+ * @{
+ */
+
+/** BMI160 FIFO size in bytes */
+#define BMI160_FIFO_SIZE                1024
+
+/** Maximum number of samples the FIFO can hold (accelerometer only, 7 byte header-mode frames) */
+#define BMI160_FIFO_MAX_SAMPLES         (BMI160_FIFO_SIZE / 7)
+
+/** Sensortime resolution, 1 LSB = 39.0625us */
+#define BMI160_SENSORTIME_NS_PER_TICK   39062
+
+/** 24-bit sensortime counter mask */
+#define BMI160_SENSORTIME_MASK          0x00FFFFFFUL
+
+#define BMI160_FIFO_SAMPLE_ACCEL        0x01 //!< Sample holds accelerometer data
+#define BMI160_FIFO_SAMPLE_GYRO         0x02 //!< Sample holds gyroscope data
+
+/**
+ * @brief BMI160 FIFO streaming configuration
+ *
+ * Accelerometer and gyroscope share one output data rate so every FIFO frame
+ * is exactly one sample period apart.
+ */
+typedef struct
+{
+    uint8_t odr;            //!< BMI160_ACCEL_OUTPUT_DATA_RATE_25HZ .. BMI160_ACCEL_OUTPUT_DATA_RATE_1600HZ
+    uint8_t accel_range;    //!< BMI160_ACCEL_RANGE_2G .. BMI160_ACCEL_RANGE_16G
+    uint8_t gyro_range;     //!< BMI160_GYRO_RANGE_2000_DEG_SEC .. BMI160_GYRO_RANGE_125_DEG_SEC
+    zos_bool_t accel_enable;//!< Store accelerometer frames in the FIFO
+    zos_bool_t gyro_enable; //!< Store gyroscope frames in the FIFO
+    uint16_t watermark;     //!< Watermark in samples, @ref bmi160_fifo_has_data() reports data once reached
+} bmi160_fifo_config_t;
+
+/**
+ * @brief Time-stamped FIFO sample
+ */
+typedef struct
+{
+    uint32_t sensortime;            //!< 24-bit sensortime of the sample, see @ref BMI160_SENSORTIME_NS_PER_TICK
+    uint8_t flags;                  //!< BMI160_FIFO_SAMPLE_ACCEL / BMI160_FIFO_SAMPLE_GYRO
+    accelerometer_data_t accel;     //!< Acceleration in mG
+    struct
+    {
+        int32_t x;
+        int32_t y;
+        int32_t z;
+    } gyro;                         //!< Angular rate in milli-degrees per second
+} bmi160_fifo_sample_t;
+
+/**
+ * @brief FIFO read statistics
+ */
+typedef struct
+{
+    uint16_t skipped;   //!< Frames the sensor dropped because the FIFO overflowed
+    uint16_t truncated; //!< Samples read from the FIFO that did not fit in the caller's buffer
+} bmi160_fifo_stats_t;
+
+/**
+ * @}
+ */
+
+/**
+ * Configure the BMI160 FIFO for header-mode streaming.
+ *
+ * Powers up the enabled sensors, sets the shared output data rate and ranges,
+ * enables sensortime frames and flushes the FIFO.
+ *
+ * @param[in] config: FIFO streaming configuration
+ * @return @ref zos_result_t
+ */
+zos_result_t bmi160_fifo_init(const bmi160_fifo_config_t *config);
+
+/**
+ * Check whether the FIFO fill level has reached the configured watermark
+ *
+ * @param[out] has_data: True if the watermark has been reached
+ * @return @ref zos_result_t
+ */
+zos_result_t bmi160_fifo_has_data(zos_bool_t *has_data);
+
+/**
+ * Drain the FIFO in one burst and parse it into time-stamped samples.
+ *
+ * The whole FIFO plus the trailing sensortime frame is read in a single
+ * transaction. Timestamps are derived backwards from the sensortime frame
+ * using the configured output data rate. Samples beyond `max_samples` are
+ * discarded and counted in `stats`, so the buffer should hold
+ * @ref BMI160_FIFO_MAX_SAMPLES entries to never lose data.
+ *
+ * @param[out] samples: Buffer of samples, oldest first
+ * @param[in] max_samples: Number of entries available in `samples`
+ * @param[out] sample_count: Number of samples written to `samples`
+ * @param[out] stats: Optional skip/truncation statistics, may be NULL
+ * @return @ref zos_result_t
+ */
+zos_result_t bmi160_fifo_read(bmi160_fifo_sample_t *samples, uint16_t max_samples, uint16_t *sample_count, bmi160_fifo_stats_t *stats);
+
+/**
+ * Drain the FIFO and return only the accelerometer part of each sample.
+ *
+ * Same as @ref bmi160_fifo_read() with the sample data split out, used by the accelerometer sensor type.
+ *
+ * @param[out] data: Buffer of samples in mG, oldest first
+ * @param[out] sensortimes: Optional buffer of sample sensortimes, may be NULL
+ * @param[in] max_samples: Number of entries available in `data` and `sensortimes`
+ * @param[out] sample_count: Number of samples written to `data`
+ * @param[out] stats: Optional skip/truncation statistics, may be NULL
+ * @return @ref zos_result_t
+ */
+zos_result_t bmi160_fifo_read_accel(accelerometer_data_t *data, uint32_t *sensortimes, uint16_t max_samples, uint16_t *sample_count, bmi160_fifo_stats_t *stats);
+
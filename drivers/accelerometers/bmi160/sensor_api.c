@@ -8,13 +8,17 @@
  */
 
 #include "zos.h"
-#include "sensor/types/accelerometer/accelerometer.h"
+#include "sensor/sensor.h"
 #include "bmi160.h"
+#include "bmi160_fifo.h"
 
 
 static void bmi160_calculate_g_values(struct bmi160_accel_t *raw, accelerometer_data_t *output);
 
 
+static zos_bool_t fifo_enabled = ZOS_FALSE;
+
+
 
 /*************************************************************************************************/
 zos_result_t sensor_accelerometer_init(const accelerometer_config_t *config)
@@ -45,6 +49,20 @@ zos_result_t sensor_accelerometer_init(const accelerometer_config_t *config)
     else if(ZOS_FAILED(result, bmi160_set_accel_range(range)))
     {
     }
+    else if(config->fifo_watermark > 0)
+    {
+        const bmi160_fifo_config_t fifo_config =
+        {
+            .odr = rate,
+            .accel_range = range,
+            .accel_enable = ZOS_TRUE,
+            .gyro_enable = ZOS_FALSE,
+            .watermark = config->fifo_watermark
+        };
+        result = bmi160_fifo_init(&fifo_config);
+    }
+
+    fifo_enabled = (result == ZOS_SUCCESS && config->fifo_watermark > 0) ? ZOS_TRUE : ZOS_FALSE;
 
     return result;
 }
@@ -54,7 +72,11 @@ zos_result_t sensor_accelerometer_has_new_data(zos_bool_t *has_data)
 {
     zos_result_t result;
 
-    if(!ZOS_FAILED(result, bmi160_get_accel_data_rdy((uint8_t*)has_data)))
+    if(fifo_enabled)
+    {
+        result = bmi160_fifo_has_data(has_data);
+    }
+    else if(!ZOS_FAILED(result, bmi160_get_accel_data_rdy((uint8_t*)has_data)))
     {
     }
 
@@ -75,57 +97,98 @@ zos_result_t sensor_accelerometer_get_data(accelerometer_data_t *data)
     return result;
 }
 
+/*************************************************************************************************/
+/* Drain up to max_samples from the hardware FIFO in one burst */
+zos_result_t sensor_accelerometer_get_fifo_data(accelerometer_data_t *data, uint16_t max_samples, uint16_t *sample_count)
+{
+    *sample_count = 0;
+
+    if(!fifo_enabled)
+    {
+        return ZOS_INVALID_ARG;
+    }
+
+    return bmi160_fifo_read_accel(data, NULL, max_samples, sample_count, NULL);
+}
+
+/*************************************************************************************************/
+/* Drain the FIFO when enabled, timestamps come from the sensortime of each frame */
+zos_result_t sensor_accelerometer_get_data_batch(accelerometer_data_t *data, uint16_t max_samples, uint16_t *sample_count, uint32_t *timestamps)
+{
+    zos_result_t result;
+
+    *sample_count = 0;
+
+    if(!fifo_enabled)
+    {
+        result = sensor_get_data_batch_generic(sensor_accelerometer_has_new_data, (sensor_get_data_prototype_t)sensor_accelerometer_get_data,
+                                               data, max_samples, sample_count, timestamps);
+    }
+    // Sensortimes are staged in the timestamp buffer and converted in place
+    else if(!ZOS_FAILED(result, bmi160_fifo_read_accel(data, timestamps, max_samples, sample_count, NULL)) &&
+            (timestamps != NULL) && (*sample_count > 0))
+    {
+        // The newest frame was captured at the time of the read, walk back by sensortime distance
+        const uint32_t now = zn_rtos_get_time();
+        const uint32_t newest = timestamps[*sample_count - 1];
+
+        for(uint16_t i = 0; i < *sample_count; ++i)
+        {
+            const uint32_t age_ticks = (newest - timestamps[i]) & BMI160_SENSORTIME_MASK;
+            timestamps[i] = now - (uint32_t)(((uint64_t)age_ticks * BMI160_SENSORTIME_NS_PER_TICK) / 1000000);
+        }
+    }
+
+    return result;
+}
+
+
+/*************************************************************************************************/
+/* Map data ready, or the FIFO watermark when the FIFO is enabled, to INT1 as an active high edge */
+zos_result_t sensor_accelerometer_set_data_ready_irq(zos_bool_t enabled)
+{
+    zos_result_t result;
+    const u8 irq = (fifo_enabled) ? BMI160_FIFO_WM_ENABLE : BMI160_DATA_RDY_ENABLE;
+    const u8 enable = (enabled) ? BMI160_ENABLE : BMI160_DISABLE;
+
+    if(ZOS_FAILED(result, bmi160_set_intr_edge_ctrl(BMI160_INTR1_EDGE_CTRL, BMI160_EDGE)))
+    {
+    }
+    else if(ZOS_FAILED(result, bmi160_set_intr_level(BMI160_INTR1_LEVEL, BMI160_LEVEL_HIGH)))
+    {
+    }
+    else if(ZOS_FAILED(result, bmi160_set_intr_output_type(BMI160_INTR1_OUTPUT_TYPE, BMI160_PUSH_PULL)))
+    {
+    }
+    else if(ZOS_FAILED(result, bmi160_set_output_enable(BMI160_INTR1_OUTPUT_ENABLE, enable)))
+    {
+    }
+    else if(fifo_enabled && ZOS_FAILED(result, bmi160_set_intr_fifo_wm(BMI160_INTR1_MAP_FIFO_WM, enable)))
+    {
+    }
+    else if(!fifo_enabled && ZOS_FAILED(result, bmi160_set_intr_data_rdy(BMI160_INTR1_MAP_DATA_RDY, enable)))
+    {
+    }
+    else if(ZOS_FAILED(result, bmi160_set_intr_enable_1(irq, enable)))
+    {
+    }
+
+    return result;
+}
+
 
 
 /*************************************************************************************************/
 static void bmi160_calculate_g_values(struct bmi160_accel_t *raw, accelerometer_data_t *output)
 {
     // readings are in 1mg sensitivity shifted based on the full-scale:
-    uint8_t range;
-    if( bmi160_get_accel_range(&range) != ZOS_SUCCESS)
-        range = BMI160_ACCEL_RANGE_2G;
-
-    switch(range)
-    {
-        default:
-        // phy_val = full_scale_range * reg_val / max_reg_val
-        //         = 2 * _ACC_AXIS / (2^bit_size / 2)
-        //         = 2 * _ACC_AXIS / 32768
-        // (i.e., 32768/2 = 16,384 LSB/G)
-        case BMI160_ACCEL_RANGE_2G:
-            output->x = (int32_t)(2 * 1000 * raw->x) / 32768;
-            output->y = (int32_t)(2 * 1000 * raw->y) / 32768;
-            output->z = (int32_t)(2 * 1000 * raw->z) / 32768;
-            break;
-
-        // phy_val = full_scale_range * reg_val / max_reg_val
-        //         = 4 * _ACC_AXIS / (2^bit_size / 2)
-        //         = 4 * _ACC_AXIS / 32768
-        // (i.e., 32768/4 = 8,192 LSB/G)
-        case BMI160_ACCEL_RANGE_4G:
-            output->x = (int32_t)(4 * 1000 * raw->x) / 32768;
-            output->y = (int32_t)(4 * 1000 * raw->y) / 32768;
-            output->z = (int32_t)(4 * 1000 * raw->z) / 32768;
-            break;
-
-        // phy_val = full_scale_range * reg_val / max_reg_val
-        //         = 8 * _ACC_AXIS / (2^bit_size / 2)
-        //         = 8 * _ACC_AXIS / 32768
-        // (i.e., 32768/8 = 4,096 LSB/G)
-        case BMI160_ACCEL_RANGE_8G:
-            output->x = (int32_t)(8 * 1000 * raw->x) / 32768;
-            output->y = (int32_t)(8 * 1000 * raw->y) / 32768;
-            output->z = (int32_t)(8 * 1000 * raw->z) / 32768;
-            break;
-
-        // phy_val = full_scale_range * reg_val / max_reg_val
-        //         = 16 * _ACC_AXIS / (2^bit_size / 2)
-        //         = 16 * _ACC_AXIS / 32768
-        // (i.e., 32768/16 = 2,048 LSB/G)
-        case BMI160_ACCEL_RANGE_16G:
-            output->x = (int32_t)(16 * 1000 * raw->x) / 32768;
-            output->y = (int32_t)(16 * 1000 * raw->y) / 32768;
-            output->z = (int32_t)(16 * 1000 * raw->z) / 32768;
-            break;
-    }
+    // phy_val = full_scale_range * reg_val / max_reg_val
+    //         = full_scale_range * _ACC_AXIS / (2^bit_size / 2)
+    //         = full_scale_range * _ACC_AXIS / 32768
+    // The range comes from the driver's configuration shadow so no register read is needed
+    const int32_t range_mg = bmi160_accel_range_mg(bmi160_get_accel_config_shadow()->range);
+
+    output->x = (range_mg * raw->x) / 32768;
+    output->y = (range_mg * raw->y) / 32768;
+    output->z = (range_mg * raw->z) / 32768;
 }
@@ -27,6 +27,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "lis3dh.h"
 #include "zos.h"
+#include "reg_shadow.h"
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
@@ -40,6 +41,11 @@ static const zos_i2c_device_t const ZOS_I2C_LIS3DH =
     .flags = I2C_FLAG_HEXIFY
 };
 
+// Configuration registers TEMP_CFG_REG .. TIME_WINDOW, see LIS3DH_GetShadow()
+static reg_shadow_t lis3dh_shadow;
+
+static reg_shadow_t* LIS3DH_GetShadow(void);
+
 /*******************************************************************************
 * Function Name     : LIS3DH_ReadReg
 * Description       : Generic Reading function. It must be fullfilled with either
@@ -49,12 +55,19 @@ static const zos_i2c_device_t const ZOS_I2C_LIS3DH =
 * Return            : None
 *******************************************************************************/
 u8_t LIS3DH_ReadReg(u8_t Reg, u8_t* Data) {
-  
+
+    if (reg_shadow_get(LIS3DH_GetShadow(), Reg, Data))
+    {
+        return MEMS_SUCCESS;
+    }
+
     if (zn_i2c_master_read_reg8(&ZOS_I2C_LIS3DH, Reg, Data) != ZOS_SUCCESS)
     {
         return MEMS_ERROR;
     }
 
+    reg_shadow_set(&lis3dh_shadow, Reg, *Data);
+
     return MEMS_SUCCESS;
 }
 
@@ -69,7 +82,36 @@ u8_t LIS3DH_ReadReg(u8_t Reg, u8_t* Data) {
 *******************************************************************************/
 u8_t LIS3DH_WriteReg(u8_t WriteAddr, u8_t Data) {
 
+    if (reg_shadow_is_current(LIS3DH_GetShadow(), WriteAddr, Data))
+    {
+        return MEMS_SUCCESS;
+    }
+
     if (zn_i2c_master_write_reg8(&ZOS_I2C_LIS3DH, WriteAddr, Data) != ZOS_SUCCESS)
+    {
+        // The device may or may not have taken the value
+        reg_shadow_invalidate(&lis3dh_shadow);
+        return MEMS_ERROR;
+    }
+
+    // BOOT clears itself once the trimming values are reloaded
+    reg_shadow_set(&lis3dh_shadow, WriteAddr, (WriteAddr == LIS3DH_CTRL_REG5) ? (Data & ~LIS3DH_BOOT) : Data);
+
+    return MEMS_SUCCESS;
+}
+
+
+/*******************************************************************************
+* Function Name     : LIS3DH_ReadRegs
+* Description       : Burst reading function. Sets the sub-address auto-increment
+*                   : bit so consecutive registers are read in one transaction
+* Input             : First Register Address, Number of registers to read
+* Output            : Data Read
+* Return            : Status [MEMS_ERROR, MEMS_SUCCESS]
+*******************************************************************************/
+u8_t LIS3DH_ReadRegs(u8_t Reg, u8_t* Data, u8_t Len) {
+
+    if (zn_i2c_master_read_reg(&ZOS_I2C_LIS3DH, Reg | LIS3DH_AUTO_INCREMENT, Data, Len) != ZOS_SUCCESS)
     {
         return MEMS_ERROR;
     }
@@ -78,6 +120,37 @@ u8_t LIS3DH_WriteReg(u8_t WriteAddr, u8_t Data) {
 }
 
 
+/*******************************************************************************
+* Function Name     : LIS3DH_GetShadow
+* Description       : Get the configuration register shadow, setting it up on
+*                   : first use. Status, output, source and REFERENCE (read
+*                   : resets the high-pass filter) registers are never cached.
+* Input             : None
+* Output            : None
+* Return            : Register shadow
+*******************************************************************************/
+static reg_shadow_t* LIS3DH_GetShadow(void) {
+
+    static const u8_t volatile_regs[] =
+    {
+        LIS3DH_REFERENCE_REG, LIS3DH_STATUS_REG,
+        LIS3DH_OUT_X_L, LIS3DH_OUT_X_H, LIS3DH_OUT_Y_L, LIS3DH_OUT_Y_H, LIS3DH_OUT_Z_L, LIS3DH_OUT_Z_H,
+        LIS3DH_FIFO_SRC_REG, LIS3DH_INT1_SRC, LIS3DH_INT2_SRC, LIS3DH_CLICK_SRC
+    };
+
+    if (lis3dh_shadow.count == 0)
+    {
+        reg_shadow_init(&lis3dh_shadow, LIS3DH_TEMP_CFG_REG, LIS3DH_TIME_WINDOW - LIS3DH_TEMP_CFG_REG + 1);
+        for (u8_t i = 0; i < sizeof(volatile_regs); ++i)
+        {
+            reg_shadow_set_volatile(&lis3dh_shadow, volatile_regs[i]);
+        }
+    }
+
+    return &lis3dh_shadow;
+}
+
+
 /* Private functions ---------------------------------------------------------*/
 
 /*******************************************************************************
@@ -297,32 +370,14 @@ status_t LIS3DH_SetADCAux(State_t state){
 * Return         : Status [MEMS_ERROR, MEMS_SUCCESS]
 *******************************************************************************/
 status_t LIS3DH_GetAuxRaw(LIS3DH_Aux123Raw_t* buff) {
-  u8_t valueL;
-  u8_t valueH;
-  
-  if( !LIS3DH_ReadReg(LIS3DH_OUT_1_L, &valueL) )
-    return MEMS_ERROR;
-  
-  if( !LIS3DH_ReadReg(LIS3DH_OUT_1_H, &valueH) )
-    return MEMS_ERROR;
-  
-  buff->AUX_1 = (u16_t)( (valueH << 8) | valueL )/16;
+  u8_t value[6];
   
-  if( !LIS3DH_ReadReg(LIS3DH_OUT_2_L, &valueL) )
+  if( !LIS3DH_ReadRegs(LIS3DH_OUT_1_L, value, sizeof(value)) )
     return MEMS_ERROR;
   
-  if( !LIS3DH_ReadReg(LIS3DH_OUT_2_H, &valueH) )
-    return MEMS_ERROR;
-  
-  buff->AUX_2 = (u16_t)( (valueH << 8) | valueL )/16;
-  
-  if( !LIS3DH_ReadReg(LIS3DH_OUT_3_L, &valueL) )
-    return MEMS_ERROR;
-  
-  if( !LIS3DH_ReadReg(LIS3DH_OUT_3_H, &valueH) )
-    return MEMS_ERROR;
-  
-  buff->AUX_3 = (u16_t)( (valueH << 8) | valueL )/16;
+  buff->AUX_1 = (u16_t)( (value[1] << 8) | value[0] )/16;
+  buff->AUX_2 = (u16_t)( (value[3] << 8) | value[2] )/16;
+  buff->AUX_3 = (u16_t)( (value[5] << 8) | value[4] )/16;
   
   return MEMS_SUCCESS;  
 }
@@ -336,16 +391,12 @@ status_t LIS3DH_GetAuxRaw(LIS3DH_Aux123Raw_t* buff) {
 * Return         : Status [MEMS_ERROR, MEMS_SUCCESS]
 *******************************************************************************/
 status_t LIS3DH_GetTempRaw(i8_t* buff) {
-  u8_t valueL;
-  u8_t valueH;
+  u8_t value[2];
   
-  if( !LIS3DH_ReadReg(LIS3DH_OUT_3_L, &valueL) )
+  if( !LIS3DH_ReadRegs(LIS3DH_OUT_3_L, value, sizeof(value)) )
     return MEMS_ERROR;
   
-  if( !LIS3DH_ReadReg(LIS3DH_OUT_3_H, &valueH) )
-    return MEMS_ERROR;
-  
-  *buff = (i8_t)( valueH );
+  *buff = (i8_t)( value[1] );
   
   return MEMS_SUCCESS;  
 }
@@ -1394,33 +1445,37 @@ status_t LIS3DH_GetStatusBit(u8_t statusBIT, u8_t* val) {
 * Return         : Status [MEMS_ERROR, MEMS_SUCCESS]
 *******************************************************************************/
 status_t LIS3DH_GetAccAxesRaw(AxesRaw_t* buff) {
-  i16_t value;
-  u8_t *valueL = (u8_t *)(&value);
-  u8_t *valueH = ((u8_t *)(&value)+1);
-  
-  if( !LIS3DH_ReadReg(LIS3DH_OUT_X_L, valueL) )
-    return MEMS_ERROR;
-  
-  if( !LIS3DH_ReadReg(LIS3DH_OUT_X_H, valueH) )
-    return MEMS_ERROR;
-  
-  buff->AXIS_X = value;
-  
-  if( !LIS3DH_ReadReg(LIS3DH_OUT_Y_L, valueL) )
-    return MEMS_ERROR;
+  u8_t value[6];
   
-  if( !LIS3DH_ReadReg(LIS3DH_OUT_Y_H, valueH) )
+  if( !LIS3DH_ReadRegs(LIS3DH_OUT_X_L, value, sizeof(value)) )
     return MEMS_ERROR;
   
-  buff->AXIS_Y = value;
+  buff->AXIS_X = (i16_t)( (value[1] << 8) | value[0] );
+  buff->AXIS_Y = (i16_t)( (value[3] << 8) | value[2] );
+  buff->AXIS_Z = (i16_t)( (value[5] << 8) | value[4] );
   
-  if( !LIS3DH_ReadReg(LIS3DH_OUT_Z_L, valueL) )
-    return MEMS_ERROR;
+  return MEMS_SUCCESS; 
+}
+
+
+/*******************************************************************************
+* Function Name  : LIS3DH_GetStatusAccAxesRaw
+* Description    : Read the status register and the Acceleration Values Output
+*                  Registers in a single burst (STATUS_REG..OUT_Z_H)
+* Input          : char to empty by Status Reg Value, buffer to empty by AxesRaw_t Typedef
+* Output         : None
+* Return         : Status [MEMS_ERROR, MEMS_SUCCESS]
+*******************************************************************************/
+status_t LIS3DH_GetStatusAccAxesRaw(u8_t* status, AxesRaw_t* buff) {
+  u8_t value[7];
   
-  if( !LIS3DH_ReadReg(LIS3DH_OUT_Z_H, valueH) )
+  if( !LIS3DH_ReadRegs(LIS3DH_STATUS_REG, value, sizeof(value)) )
     return MEMS_ERROR;
   
-  buff->AXIS_Z = value;
+  *status = value[0];
+  buff->AXIS_X = (i16_t)( (value[2] << 8) | value[1] );
+  buff->AXIS_Y = (i16_t)( (value[4] << 8) | value[3] );
+  buff->AXIS_Z = (i16_t)( (value[6] << 8) | value[5] );
   
   return MEMS_SUCCESS; 
 }
@@ -1621,6 +1676,36 @@ status_t LIS3DH_GetFifoSourceFSS(u8_t* val){
   return MEMS_SUCCESS;
 }
 
+
+/*******************************************************************************
+* Function Name  : LIS3DH_GetFifoAccAxesRaw
+* Description    : Drain samples from the FIFO in a single burst. With the FIFO
+*                  enabled the sub-address rolls over from OUT_Z_H back to
+*                  OUT_X_L, so consecutive samples are read back to back
+* Input          : buffer to empty by AxesRaw_t Typedef, number of samples [1,32]
+* Output         : None
+* Return         : Status [MEMS_ERROR, MEMS_SUCCESS]
+*******************************************************************************/
+status_t LIS3DH_GetFifoAccAxesRaw(AxesRaw_t* buff, u8_t count) {
+  u8_t value[LIS3DH_FIFO_DEPTH*6];
+  u8_t i;
+  
+  if( (count == 0) || (count > LIS3DH_FIFO_DEPTH) )
+    return MEMS_ERROR;
+  
+  if( !LIS3DH_ReadRegs(LIS3DH_OUT_X_L, value, count*6) )
+    return MEMS_ERROR;
+  
+  for(i = 0; i < count; i++) {
+    const u8_t *sample = &value[i*6];
+    buff[i].AXIS_X = (i16_t)( (sample[1] << 8) | sample[0] );
+    buff[i].AXIS_Y = (i16_t)( (sample[3] << 8) | sample[2] );
+    buff[i].AXIS_Z = (i16_t)( (sample[5] << 8) | sample[4] );
+  }
+  
+  return MEMS_SUCCESS;
+}
+
       
 /*******************************************************************************
 * Function Name  : LIS3DH_SetSPIInterface
@@ -365,10 +365,17 @@ LIS3DH_NO_CLICK                         =               0x00
 //INTERRUPT 1 SOURCE REGISTER
 #define LIS3DH_INT1_SRC                                 0x31
 
+//INTERRUPT 2 SOURCE REGISTER
+#define LIS3DH_INT2_SRC                                 0x35
+
 //FIFO Source Register bit Mask
 #define LIS3DH_FIFO_SRC_WTM                             0x80
 #define LIS3DH_FIFO_SRC_OVRUN                           0x40
 #define LIS3DH_FIFO_SRC_EMPTY                           0x20
+#define LIS3DH_FIFO_SRC_FSS                             0x1F
+
+//FIFO depth in samples
+#define LIS3DH_FIFO_DEPTH                               32
   
 //INTERRUPT CLICK REGISTER
 #define LIS3DH_CLICK_CFG                                0x38
@@ -449,6 +456,9 @@ LIS3DH_NO_CLICK                         =               0x00
 #define LIS3DH_STATUS_AUX_2DA                           0x02
 #define LIS3DH_STATUS_AUX_1DA                           0x01
 
+//I2C sub-address MSB: auto-increment register address on multi-byte access
+#define LIS3DH_AUTO_INCREMENT                           0x80
+
 #define LIS3DH_MEMS_I2C_ADDRESS                         0x33
 #define LIS3DH_SA0                                      1
 #define LIS3DH_I2C_ADDRESS                              (0x18 + LIS3DH_SA0)
@@ -510,6 +520,7 @@ status_t LIS3DH_SetTriggerInt(LIS3DH_TrigInt_t tr);
 status_t LIS3DH_GetFifoSourceReg(u8_t* val);
 status_t LIS3DH_GetFifoSourceBit(u8_t statusBIT, u8_t* val);
 status_t LIS3DH_GetFifoSourceFSS(u8_t* val);
+status_t LIS3DH_GetFifoAccAxesRaw(AxesRaw_t* buff, u8_t count);
 
 //Other Reading Functions
 status_t LIS3DH_GetStatusReg(u8_t* val);
@@ -517,6 +528,7 @@ status_t LIS3DH_GetStatusBit(u8_t statusBIT, u8_t* val);
 status_t LIS3DH_GetStatusAUXBit(u8_t statusBIT, u8_t* val);
 status_t LIS3DH_GetStatusAUX(u8_t* val);
 status_t LIS3DH_GetAccAxesRaw(AxesRaw_t* buff);
+status_t LIS3DH_GetStatusAccAxesRaw(u8_t* status, AxesRaw_t* buff);
 status_t LIS3DH_GetAuxRaw(LIS3DH_Aux123Raw_t* buff);
 status_t LIS3DH_GetClickResponse(u8_t* val);
 status_t LIS3DH_GetTempRaw(i8_t* val);
@@ -526,6 +538,7 @@ status_t LIS3DH_Get6DPosition(u8_t* val);
 //Generic
 // i.e. u8_t LIS3DH_ReadReg(u8_t Reg, u8_t* Data);
 // i.e. u8_t LIS3DH_WriteReg(u8_t Reg, u8_t Data);
+u8_t LIS3DH_ReadRegs(u8_t Reg, u8_t* Data, u8_t Len);
 
 
 #endif /* __LIS3DH_H */
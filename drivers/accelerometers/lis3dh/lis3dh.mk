@@ -1,4 +1,5 @@
 NAME := drivers_accelerometers_lis3dh
 
 $(NAME)_SOURCES := lis3dh.c sensor_api.c
-$(NAME)_INCLUDES := .
\ No newline at end of file
+$(NAME)_INCLUDES := .
+$(NAME)_COMPONENTS := libraries/utilities
\ No newline at end of file
@@ -8,7 +8,7 @@
  */
 
 #include "zos.h"
-#include "sensor/types/accelerometer/accelerometer.h"
+#include "sensor/sensor.h"
 #include "lis3dh.h"
 
 
@@ -17,6 +17,23 @@ static LIS3DH_Fullscale_t get_fullscale(accel_fullscale_t scale);
 static LIS3DH_AXISenable_t get_axis_en(accel_axis_en_t axis_en);
 static LIS3DH_Mode_t get_mode(accel_mode_t accel_mode);
 static void calculate_g_values(AxesRaw_t *raw, accelerometer_data_t *output);
+static zos_result_t set_fifo(accel_fifo_wtm_t watermark);
+
+
+static zos_bool_t fifo_enabled = ZOS_FALSE;
+static uint32_t sample_period_us;
+
+/* Sample period in us indexed by accel_sample_freq_t */
+static const uint32_t sample_periods_us[] =
+{
+    [ACCEL_SAMP_FREQ_1HZ]   = 1000000,
+    [ACCEL_SAMP_FREQ_10HZ]  = 100000,
+    [ACCEL_SAMP_FREQ_25HZ]  = 40000,
+    [ACCEL_SAMP_FREQ_50HZ]  = 20000,
+    [ACCEL_SAMP_FREQ_100HZ] = 10000,
+    [ACCEL_SAMP_FREQ_200HZ] = 5000,
+    [ACCEL_SAMP_FREQ_400HZ] = 2500
+};
 
 
 
@@ -31,8 +48,10 @@ zos_result_t sensor_accelerometer_init(const accelerometer_config_t *config)
         (LIS3DH_SetBLE(LIS3DH_BLE_LSB) == MEMS_SUCCESS) &&
         (LIS3DH_SetAxis(get_axis_en(config->axis_en)) == MEMS_SUCCESS) &&
         (LIS3DH_SetInt6D4DConfiguration(LIS3DH_INT1_6D_4D_DISABLE) == MEMS_SUCCESS) &&
-        (LIS3DH_SetIntMode(LIS3DH_INT_MODE_OR) == MEMS_SUCCESS))
+        (LIS3DH_SetIntMode(LIS3DH_INT_MODE_OR) == MEMS_SUCCESS) &&
+        (set_fifo(config->fifo_watermark) == ZOS_SUCCESS))
     {
+        sample_period_us = (config->samp_freq <= ACCEL_SAMP_FREQ_400HZ) ? sample_periods_us[config->samp_freq] : sample_periods_us[ACCEL_SAMP_FREQ_50HZ];
         result = ZOS_SUCCESS;
     }
 
@@ -45,7 +64,15 @@ zos_result_t sensor_accelerometer_has_new_data(zos_bool_t *has_data)
     zos_result_t result = ZOS_ERROR;
 
     u8_t status_reg;
-    if (LIS3DH_GetStatusReg(&status_reg) == MEMS_SUCCESS)
+    if (fifo_enabled)
+    {
+        if (LIS3DH_GetFifoSourceReg(&status_reg) == MEMS_SUCCESS)
+        {
+            *has_data = ((status_reg & (LIS3DH_FIFO_SRC_WTM|LIS3DH_FIFO_SRC_OVRUN)) > 0) ? ZOS_TRUE : ZOS_FALSE;
+            result = ZOS_SUCCESS;
+        }
+    }
+    else if (LIS3DH_GetStatusReg(&status_reg) == MEMS_SUCCESS)
     {
         if ((status_reg & LIS3DH_DATAREADY_BIT) > 0)
         {
@@ -77,8 +104,118 @@ zos_result_t sensor_accelerometer_get_data(accelerometer_data_t *data)
     return result;
 }
 
+/*************************************************************************************************/
+/* Drain up to max_samples from the hardware FIFO in one burst */
+zos_result_t sensor_accelerometer_get_fifo_data(accelerometer_data_t *data, uint16_t max_samples, uint16_t *sample_count)
+{
+    zos_result_t result = ZOS_ERROR;
+    AxesRaw_t raw_data[LIS3DH_FIFO_DEPTH];
+    u8_t fifo_src;
+    u8_t count;
+
+    *sample_count = 0;
+
+    if (!fifo_enabled)
+    {
+        result = ZOS_INVALID_ARG;
+    }
+    else if (LIS3DH_GetFifoSourceReg(&fifo_src) == MEMS_SUCCESS)
+    {
+        // FSS saturates at 31, an overrun means all 32 slots hold unread samples
+        count = ((fifo_src & LIS3DH_FIFO_SRC_OVRUN) > 0) ? LIS3DH_FIFO_DEPTH : (fifo_src & LIS3DH_FIFO_SRC_FSS);
+        if (count > max_samples)
+        {
+            count = (u8_t)max_samples;
+        }
+
+        if (count == 0)
+        {
+            result = ZOS_SUCCESS;
+        }
+        else if (LIS3DH_GetFifoAccAxesRaw(raw_data, count) == MEMS_SUCCESS)
+        {
+            for (u8_t i = 0; i < count; ++i)
+            {
+                calculate_g_values(&raw_data[i], &data[i]);
+            }
+            *sample_count = count;
+            result = ZOS_SUCCESS;
+        }
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+/* Drain the FIFO when enabled, samples are one period apart ending at the time of the read */
+zos_result_t sensor_accelerometer_get_data_batch(accelerometer_data_t *data, uint16_t max_samples, uint16_t *sample_count, uint32_t *timestamps)
+{
+    zos_result_t result;
 
+    if (!fifo_enabled)
+    {
+        result = sensor_get_data_batch_generic(sensor_accelerometer_has_new_data, (sensor_get_data_prototype_t)sensor_accelerometer_get_data,
+                                               data, max_samples, sample_count, timestamps);
+    }
+    else if (!ZOS_FAILED(result, sensor_accelerometer_get_fifo_data(data, max_samples, sample_count)) && (timestamps != NULL))
+    {
+        const uint32_t now = zn_rtos_get_time();
 
+        for (uint16_t i = 0; i < *sample_count; ++i)
+        {
+            timestamps[i] = now - (((uint32_t)(*sample_count - 1 - i) * sample_period_us) / 1000);
+        }
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+/* Route data ready, or the FIFO watermark when the FIFO is enabled, to INT1 */
+zos_result_t sensor_accelerometer_set_data_ready_irq(zos_bool_t enabled)
+{
+    LIS3DH_IntPinConf_t pin_conf = LIS3DH_I1_DRDY1_ON_INT1_DISABLE;
+
+    if (enabled)
+    {
+        pin_conf = (fifo_enabled) ? LIS3DH_WTM_ON_INT1_ENABLE : LIS3DH_I1_DRDY1_ON_INT1_ENABLE;
+    }
+
+    return (LIS3DH_SetInt1Pin(pin_conf) == MEMS_SUCCESS) ? ZOS_SUCCESS : ZOS_ERROR;
+}
+
+/*************************************************************************************************/
+static zos_result_t set_fifo(accel_fifo_wtm_t watermark)
+{
+    zos_result_t result = ZOS_ERROR;
+
+    fifo_enabled = ZOS_FALSE;
+
+    if (watermark == 0)
+    {
+        if (LIS3DH_FIFOModeEnable(LIS3DH_FIFO_DISABLE) == MEMS_SUCCESS)
+        {
+            result = ZOS_SUCCESS;
+        }
+    }
+    else
+    {
+        // watermark register holds [0,31]
+        if (watermark >= LIS3DH_FIFO_DEPTH)
+        {
+            watermark = LIS3DH_FIFO_DEPTH - 1;
+        }
+
+        if ((LIS3DH_SetWaterMark(watermark) == MEMS_SUCCESS) &&
+            (LIS3DH_FIFOModeEnable(LIS3DH_FIFO_STREAM_MODE) == MEMS_SUCCESS))
+        {
+            fifo_enabled = ZOS_TRUE;
+            result = ZOS_SUCCESS;
+        }
+    }
+
+    return result;
+}
 
 /*************************************************************************************************/
 static LIS3DH_ODR_t get_odr(accel_sample_freq_t samp_freq)
@@ -7,9 +7,11 @@
  *
  */
 #include "l3g4200d.h"
+#include "reg_shadow.h"
 
 static zos_result_t L3G4200D_ReadReg(uint8_t Reg, uint8_t* Data);
 static zos_result_t L3G4200D_WriteReg(uint8_t WriteAddr, uint8_t Data);
+static reg_shadow_t* L3G4200D_GetShadow(void);
 
 static const zos_i2c_device_t ZOS_I2C_L3G4200D =
 {
@@ -20,6 +22,9 @@ static const zos_i2c_device_t ZOS_I2C_L3G4200D =
     .read_timeout = 40
 };
 
+// CTRL_REG1 .. CTRL_REG4, CTRL_REG5 holds the self-clearing BOOT bit
+static reg_shadow_t l3g4200d_shadow;
+
 /*******************************************************************************
 * Function Name  : L3G4200D_Init
 * Description    : Initialize L3G4200D in a ready state
@@ -148,6 +153,21 @@ zos_result_t L3G4200D_GetStatusReg(uint8_t* val)
 /******************************************************
 *          Internal Function Definitions
 ******************************************************/
+/*******************************************************************************
+* Function Name     : L3G4200D_GetShadow
+* Description       : Lazily set up the control register shadow
+* Input             : None
+* Output            : None
+* Return            : Register shadow
+*******************************************************************************/
+static reg_shadow_t* L3G4200D_GetShadow(void)
+{
+    if (l3g4200d_shadow.count == 0)
+        reg_shadow_init(&l3g4200d_shadow, PMOD_GYRO_CTRL_REG1, PMOD_GYRO_CTRL_REG4 - PMOD_GYRO_CTRL_REG1 + 1);
+
+    return &l3g4200d_shadow;
+}
+
 /*******************************************************************************
 * Function Name     : L3G4200D_ReadReg
 * Description       : Generic I2C reading function
@@ -157,9 +177,16 @@ zos_result_t L3G4200D_GetStatusReg(uint8_t* val)
 *******************************************************************************/
 static zos_result_t L3G4200D_ReadReg(uint8_t Reg, uint8_t* Data)
 {
+    reg_shadow_t *shadow = L3G4200D_GetShadow();
+
+    if (reg_shadow_get(shadow, Reg, Data))
+        return ZOS_SUCCESS;
+
     if (zn_i2c_master_read_reg8(&ZOS_I2C_L3G4200D, Reg, Data) != ZOS_SUCCESS)
         return ZOS_ERROR;
 
+    reg_shadow_set(shadow, Reg, *Data);
+
     return ZOS_SUCCESS;
 }
 
@@ -172,8 +199,18 @@ static zos_result_t L3G4200D_ReadReg(uint8_t Reg, uint8_t* Data)
 *******************************************************************************/
 static zos_result_t L3G4200D_WriteReg(uint8_t WriteAddr, uint8_t Data)
 {
+    reg_shadow_t *shadow = L3G4200D_GetShadow();
+
+    if (reg_shadow_is_current(shadow, WriteAddr, Data))
+        return ZOS_SUCCESS;
+
     if (zn_i2c_master_write_reg8(&ZOS_I2C_L3G4200D, WriteAddr, Data) != ZOS_SUCCESS)
+    {
+        reg_shadow_invalidate(shadow);
         return ZOS_ERROR;
+    }
+
+    reg_shadow_set(shadow, WriteAddr, Data);
 
     return ZOS_SUCCESS;
 }
@@ -2,3 +2,4 @@ NAME := drivers_gyroscope_l3g4200d
 
 $(NAME)_SOURCES := l3g4200d.c sensor_api.c
 $(NAME)_INCLUDES := .
+$(NAME)_COMPONENTS := libraries/utilities
@@ -0,0 +1,4 @@
+NAME := drivers_imu_mpu9250
+
+$(NAME)_SOURCES := mpu9250_device.c sensor_api.c
+$(NAME)_INCLUDES := .
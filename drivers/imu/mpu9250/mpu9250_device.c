@@ -0,0 +1,390 @@
+/*
+ * ZentriOS SDK LICENSE AGREEMENT | Zentri.com, 2015.
+ *
+ * Use of source code and/or libraries contained in the ZentriOS SDK is
+ * subject to the Zentri Operating System SDK license agreement and
+ * applicable open source license agreements.
+ *
+ */
+
+#include "mpu9250_device.h"
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+static const zos_i2c_device_t ZOS_I2C_MPU9250 =
+{
+    .address = (uint16_t)MPU9250_DEVICE_ADDRESS,
+    .speed = I2C_CLOCK_HIGH_SPEED,
+    .retries = (uint16_t)3U,
+    .flags = I2C_FLAG_HEXIFY,
+    .read_timeout = 40
+};
+
+/* Only used while bypass is enabled during initialisation */
+static const zos_i2c_device_t ZOS_I2C_AK8963 =
+{
+    .address = (uint16_t)MPU9250_DEVICE_AK8963_ADDRESS,
+    .speed = I2C_CLOCK_HIGH_SPEED,
+    .retries = (uint16_t)3U,
+    .flags = I2C_FLAG_HEXIFY,
+    .read_timeout = 40
+};
+
+/******************************************************
+ *                      Macros
+ ******************************************************/
+// MPU9250 registers
+#define MPU9250_SMPLRT_DIV              0x19
+#define MPU9250_CONFIG                  0x1A
+#define MPU9250_GYRO_CONFIG             0x1B
+#define MPU9250_ACCEL_CONFIG            0x1C
+#define MPU9250_ACCEL_CONFIG_2          0x1D
+#define MPU9250_I2C_MST_CTRL            0x24
+#define MPU9250_I2C_SLV0_ADDR           0x25
+#define MPU9250_I2C_SLV0_REG            0x26
+#define MPU9250_I2C_SLV0_CTRL           0x27
+#define MPU9250_INT_PIN_CFG             0x37
+#define MPU9250_INT_ENABLE              0x38
+#define MPU9250_INT_STATUS              0x3A
+#define MPU9250_ACCEL_XOUT_H            0x3B
+#define MPU9250_I2C_MST_DELAY_CTRL      0x67
+#define MPU9250_USER_CTRL               0x6A
+#define MPU9250_PWR_MGMT_1              0x6B
+#define MPU9250_PWR_MGMT_2              0x6C
+
+#define MPU9250_FULLSCALE_SHIFT         3
+#define MPU9250_DLPF_41HZ               0x03
+#define MPU9250_INT_PIN_BYPASS_EN       0x02
+#define MPU9250_INT_PIN_LATCH_INT_EN    0x20
+#define MPU9250_INT_PIN_ANYRD_2CLEAR    0x10
+#define MPU9250_RAW_RDY_EN              0x01
+#define MPU9250_RAW_DATA_RDY_INT        0x01
+#define MPU9250_I2C_MST_WAIT_FOR_ES     0x40
+#define MPU9250_I2C_MST_CLK_400KHZ      0x0D
+#define MPU9250_I2C_SLV_READ            0x80
+#define MPU9250_I2C_SLV_EN              0x80
+#define MPU9250_DELAY_ES_SHADOW         0x80
+#define MPU9250_USER_I2C_MST_EN         0x20
+#define MPU9250_PWR_RESET               0x80
+#define MPU9250_PWR_CLKSEL_AUTO         0x01
+#define MPU9250_PWR_DISABLE_ACCEL_SHIFT 3
+#define MPU9250_PWR_DISABLE_GYRO_SHIFT  0
+
+// AK8963 registers
+#define AK8963_ST1                      0x02
+#define AK8963_CNTL1                    0x0A
+#define AK8963_ASAX                     0x10
+
+#define AK8963_ST1_DRDY                 0x01
+#define AK8963_ST2_HOFL                 0x08
+#define AK8963_MODE_POWER_DOWN          0x00
+#define AK8963_MODE_FUSE_ROM            0x0F
+#define AK8963_MODE_CONTINUOUS_100HZ    0x06
+#define AK8963_OUTPUT_16BIT             0x10
+
+#define MPU9250_SAMPLE_RATE_MAX         1000
+#define MPU9250_SAMPLE_RATE_MIN         4
+
+#define BE16(p) ((int16_t)(((uint16_t)(p)[0] << 8) | (p)[1]))
+#define LE16(p) ((int16_t)(((uint16_t)(p)[1] << 8) | (p)[0]))
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+/******************************************************
+ *                    Structures
+ ******************************************************/
+typedef struct
+{
+    zos_bool_t initialised;
+    uint8_t pwr_mgmt_2;
+    uint8_t unread;     // mpu9250_device_part_t mask of parts that have not consumed the sample yet
+    uint8_t irq_parts;  // mpu9250_device_part_t mask of parts using the data ready interrupt
+    mpu9250_device_sample_t sample;
+} mpu9250_device_context_t;
+
+/******************************************************
+ *               Function Declarations
+ ******************************************************/
+static zos_result_t write_reg(uint8_t reg, uint8_t value);
+static zos_result_t reset(void);
+static zos_result_t ak8963_set_mode(uint8_t mode);
+static zos_result_t ak8963_init(uint8_t *asa);
+static zos_result_t set_axis_disable(uint8_t axis_en, uint8_t shift);
+
+/******************************************************
+ *               Variables Definitions
+ ******************************************************/
+static mpu9250_device_context_t device_context;
+
+/******************************************************
+ *          External Function Definitions
+ ******************************************************/
+
+/*************************************************************************************************/
+zos_result_t mpu9250_device_init(void)
+{
+    zos_result_t result = ZOS_SUCCESS;
+
+    if (device_context.initialised == ZOS_TRUE)
+    {
+        return ZOS_SUCCESS;
+    }
+
+    memset(&device_context, 0, sizeof(device_context));
+
+    if (ZOS_FAILED(result, reset()))
+    {
+    }
+    else if (ZOS_FAILED(result, write_reg(MPU9250_PWR_MGMT_1, MPU9250_PWR_CLKSEL_AUTO)))
+    {
+    }
+    // Talk to the AK8963 directly to read its fuse ROM and start continuous measurement
+    else if (ZOS_FAILED(result, write_reg(MPU9250_USER_CTRL, 0)) ||
+             ZOS_FAILED(result, write_reg(MPU9250_INT_PIN_CFG, MPU9250_INT_PIN_BYPASS_EN)))
+    {
+    }
+    else if (ZOS_FAILED(result, ak8963_init(device_context.sample.magn_asa)))
+    {
+    }
+    // Hand the auxiliary bus to the internal master, SLV0 copies ST1..ST2 into EXT_SENS_DATA_00
+    // every sample, the shadow delay keeps the copy coherent with the motion registers
+    else if (ZOS_FAILED(result, write_reg(MPU9250_INT_PIN_CFG, 0)) ||
+             ZOS_FAILED(result, write_reg(MPU9250_I2C_MST_CTRL, MPU9250_I2C_MST_WAIT_FOR_ES | MPU9250_I2C_MST_CLK_400KHZ)) ||
+             ZOS_FAILED(result, write_reg(MPU9250_USER_CTRL, MPU9250_USER_I2C_MST_EN)) ||
+             ZOS_FAILED(result, write_reg(MPU9250_I2C_SLV0_ADDR, MPU9250_I2C_SLV_READ | MPU9250_DEVICE_AK8963_ADDRESS)) ||
+             ZOS_FAILED(result, write_reg(MPU9250_I2C_SLV0_REG, AK8963_ST1)) ||
+             ZOS_FAILED(result, write_reg(MPU9250_I2C_SLV0_CTRL, MPU9250_I2C_SLV_EN | MPU9250_DEVICE_MAGN_LENGTH)) ||
+             ZOS_FAILED(result, write_reg(MPU9250_I2C_MST_DELAY_CTRL, MPU9250_DELAY_ES_SHADOW)))
+    {
+    }
+    else if (ZOS_FAILED(result, write_reg(MPU9250_CONFIG, MPU9250_DLPF_41HZ)) ||
+             ZOS_FAILED(result, write_reg(MPU9250_ACCEL_CONFIG_2, MPU9250_DLPF_41HZ)) ||
+             ZOS_FAILED(result, write_reg(MPU9250_PWR_MGMT_2, 0)) ||
+             ZOS_FAILED(result, write_reg(MPU9250_INT_ENABLE, MPU9250_RAW_RDY_EN)))
+    {
+    }
+    else
+    {
+        device_context.initialised = ZOS_TRUE;
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+zos_result_t mpu9250_device_set_accel_config(mpu9250_device_accel_fullscale_t fullscale, uint16_t rate_hz, uint8_t axis_en)
+{
+    zos_result_t result;
+
+    rate_hz = MAX(MPU9250_SAMPLE_RATE_MIN, MIN(rate_hz, MPU9250_SAMPLE_RATE_MAX));
+
+    // Sample rate = internal rate / (1 + SMPLRT_DIV), internal rate is 1kHz with the DLPF enabled
+    if (ZOS_FAILED(result, write_reg(MPU9250_SMPLRT_DIV, (uint8_t)((MPU9250_SAMPLE_RATE_MAX / rate_hz) - 1))))
+    {
+    }
+    else if (ZOS_FAILED(result, write_reg(MPU9250_ACCEL_CONFIG, (uint8_t)fullscale << MPU9250_FULLSCALE_SHIFT)))
+    {
+    }
+    else if (ZOS_FAILED(result, set_axis_disable(axis_en, MPU9250_PWR_DISABLE_ACCEL_SHIFT)))
+    {
+    }
+    else
+    {
+        device_context.sample.accel_fullscale = fullscale;
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+zos_result_t mpu9250_device_set_gyro_config(mpu9250_device_gyro_fullscale_t fullscale, uint8_t axis_en)
+{
+    zos_result_t result;
+
+    if (ZOS_FAILED(result, write_reg(MPU9250_GYRO_CONFIG, (uint8_t)fullscale << MPU9250_FULLSCALE_SHIFT)))
+    {
+    }
+    else if (ZOS_FAILED(result, set_axis_disable(axis_en, MPU9250_PWR_DISABLE_GYRO_SHIFT)))
+    {
+    }
+    else
+    {
+        device_context.sample.gyro_fullscale = fullscale;
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+zos_result_t mpu9250_device_set_data_ready_irq(mpu9250_device_part_t part, zos_bool_t enabled)
+{
+    zos_result_t result;
+    const uint8_t irq_parts = (enabled) ? (device_context.irq_parts | part) : (device_context.irq_parts & ~part);
+
+    // RAW_RDY_EN is always on since has_new_data polls it, latching keeps INT high until
+    // the next burst so an edge is never lost while the event is queued
+    if (!ZOS_FAILED(result, write_reg(MPU9250_INT_PIN_CFG, (irq_parts != 0) ? (MPU9250_INT_PIN_LATCH_INT_EN | MPU9250_INT_PIN_ANYRD_2CLEAR) : 0)))
+    {
+        device_context.irq_parts = irq_parts;
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+zos_result_t mpu9250_device_read(void)
+{
+    zos_result_t result;
+    uint8_t buffer[MPU9250_DEVICE_SAMPLE_LENGTH];
+
+    // ACCEL_XOUT_H .. GYRO_ZOUT_L is directly followed by EXT_SENS_DATA_00, so one burst covers all nine axes
+    if (!ZOS_FAILED(result, zn_i2c_master_read_reg(&ZOS_I2C_MPU9250, MPU9250_ACCEL_XOUT_H, buffer, sizeof(buffer))))
+    {
+        mpu9250_device_sample_t *sample = &device_context.sample;
+        const uint8_t *magn = &buffer[MPU9250_DEVICE_MOTION_LENGTH];
+
+        sample->accel[0] = BE16(&buffer[0]);
+        sample->accel[1] = BE16(&buffer[2]);
+        sample->accel[2] = BE16(&buffer[4]);
+        sample->temperature = BE16(&buffer[6]);
+        sample->gyro[0] = BE16(&buffer[8]);
+        sample->gyro[1] = BE16(&buffer[10]);
+        sample->gyro[2] = BE16(&buffer[12]);
+
+        // Keep an unconsumed magnetometer sample, the AK8963 updates less often than accel/gyro
+        device_context.unread = (device_context.unread & MPU9250_DEVICE_MAGN) | MPU9250_DEVICE_ACCEL | MPU9250_DEVICE_GYRO;
+
+        // magn[0] = ST1, magn[1..6] = HXL..HZH, magn[7] = ST2
+        // The AK8963 runs at its own rate, only take values it flagged as new and not overflowed
+        if ((magn[0] & AK8963_ST1_DRDY) && !(magn[7] & AK8963_ST2_HOFL))
+        {
+            sample->magn[0] = LE16(&magn[1]);
+            sample->magn[1] = LE16(&magn[3]);
+            sample->magn[2] = LE16(&magn[5]);
+            device_context.unread |= MPU9250_DEVICE_MAGN;
+        }
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+zos_result_t mpu9250_device_has_new_data(mpu9250_device_part_t part, zos_bool_t *has_data)
+{
+    zos_result_t result = ZOS_SUCCESS;
+    uint8_t status;
+
+    if ((device_context.unread & part) == 0)
+    {
+        // INT_STATUS clears on read, so fetch the sample now on behalf of every part
+        if (ZOS_FAILED(result, zn_i2c_master_read_reg8(&ZOS_I2C_MPU9250, MPU9250_INT_STATUS, &status)))
+        {
+        }
+        else if ((status & MPU9250_RAW_DATA_RDY_INT) && ZOS_FAILED(result, mpu9250_device_read()))
+        {
+        }
+    }
+
+    *has_data = ((device_context.unread & part) != 0) ? ZOS_TRUE : ZOS_FALSE;
+
+    return result;
+}
+
+/*************************************************************************************************/
+zos_result_t mpu9250_device_get_sample(mpu9250_device_part_t part, const mpu9250_device_sample_t **sample)
+{
+    zos_result_t result = ZOS_SUCCESS;
+
+    if ((device_context.unread & part) == 0)
+    {
+        result = mpu9250_device_read();
+    }
+
+    device_context.unread &= ~part;
+    *sample = &device_context.sample;
+
+    return result;
+}
+
+/******************************************************
+ *          Internal Function Definitions
+ ******************************************************/
+
+/*************************************************************************************************/
+static zos_result_t write_reg(uint8_t reg, uint8_t value)
+{
+    return zn_i2c_master_write_reg8(&ZOS_I2C_MPU9250, reg, value);
+}
+
+/*************************************************************************************************/
+static zos_result_t reset(void)
+{
+    zos_result_t result;
+
+    if (!ZOS_FAILED(result, write_reg(MPU9250_PWR_MGMT_1, MPU9250_PWR_RESET)))
+    {
+        zn_rtos_delay_milliseconds(100);
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+static zos_result_t ak8963_set_mode(uint8_t mode)
+{
+    zos_result_t result;
+
+    // The AK8963 needs time to settle between mode changes
+    if (!ZOS_FAILED(result, zn_i2c_master_write_reg8(&ZOS_I2C_AK8963, AK8963_CNTL1, mode)))
+    {
+        zn_rtos_delay_milliseconds(10);
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+static zos_result_t ak8963_init(uint8_t *asa)
+{
+    zos_result_t result;
+
+    if (ZOS_FAILED(result, ak8963_set_mode(AK8963_MODE_POWER_DOWN)))
+    {
+    }
+    else if (ZOS_FAILED(result, ak8963_set_mode(AK8963_MODE_FUSE_ROM)))
+    {
+    }
+    else if (ZOS_FAILED(result, zn_i2c_master_read_reg(&ZOS_I2C_AK8963, AK8963_ASAX, asa, 3)))
+    {
+    }
+    else if (ZOS_FAILED(result, ak8963_set_mode(AK8963_MODE_POWER_DOWN)))
+    {
+    }
+    else if (ZOS_FAILED(result, ak8963_set_mode(AK8963_OUTPUT_16BIT | AK8963_MODE_CONTINUOUS_100HZ)))
+    {
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+static zos_result_t set_axis_disable(uint8_t axis_en, uint8_t shift)
+{
+    zos_result_t result;
+    uint8_t pwr_mgmt_2 = device_context.pwr_mgmt_2 & ~(0x07 << shift);
+
+    // PWR_MGMT_2 holds disable bits, X is the most significant of each group
+    if (!(axis_en & MPU9250_DEVICE_AXIS_EN_X)) pwr_mgmt_2 |= (0x04 << shift);
+    if (!(axis_en & MPU9250_DEVICE_AXIS_EN_Y)) pwr_mgmt_2 |= (0x02 << shift);
+    if (!(axis_en & MPU9250_DEVICE_AXIS_EN_Z)) pwr_mgmt_2 |= (0x01 << shift);
+
+    if (!ZOS_FAILED(result, write_reg(MPU9250_PWR_MGMT_2, pwr_mgmt_2)))
+    {
+        device_context.pwr_mgmt_2 = pwr_mgmt_2;
+    }
+
+    return result;
+}
@@ -0,0 +1,164 @@
+/*
+ * ZentriOS SDK LICENSE AGREEMENT | Zentri.com, 2015.
+ *
+ * Use of source code and/or libraries contained in the ZentriOS SDK is
+ * subject to the Zentri Operating System SDK license agreement and
+ * applicable open source license agreements.
+ *
+ */
+#pragma once
+
+#include "zos.h"
+
+/**
+ * @addtogroup  lib_sensor_mpu9250
+ * @{
+ */
+
+/** Sensor I2C slave address */
+#define MPU9250_DEVICE_ADDRESS          0x68
+
+/** AK8963 magnetometer I2C slave address (behind the MPU9250 auxiliary bus) */
+#define MPU9250_DEVICE_AK8963_ADDRESS   0x0C
+
+/** Bytes of ACCEL_XOUT_H .. GYRO_ZOUT_L */
+#define MPU9250_DEVICE_MOTION_LENGTH    14
+
+/** Bytes of AK8963 ST1 .. ST2 mirrored into EXT_SENS_DATA */
+#define MPU9250_DEVICE_MAGN_LENGTH      8
+
+/** Bytes read by one @ref mpu9250_device_read() transaction */
+#define MPU9250_DEVICE_SAMPLE_LENGTH    (MPU9250_DEVICE_MOTION_LENGTH + MPU9250_DEVICE_MAGN_LENGTH)
+
+#define MPU9250_DEVICE_AXIS_EN_X        0x01 //!< Enable X axis
+#define MPU9250_DEVICE_AXIS_EN_Y        0x02 //!< Enable Y axis
+#define MPU9250_DEVICE_AXIS_EN_Z        0x04 //!< Enable Z axis
+
+/**
+ * Sensor parts of the device, each consumes the shared sample independently
+ */
+typedef enum
+{
+    MPU9250_DEVICE_ACCEL    = 0x01, //!< Accelerometer
+    MPU9250_DEVICE_GYRO     = 0x02, //!< Gyroscope
+    MPU9250_DEVICE_MAGN     = 0x04, //!< AK8963 magnetometer
+    MPU9250_DEVICE_ALL      = 0x07
+} mpu9250_device_part_t;
+
+/**
+ * Accelerometer fullscale, ACCEL_CONFIG register encoding
+ */
+typedef enum
+{
+    MPU9250_DEVICE_ACCEL_FULLSCALE_2G,
+    MPU9250_DEVICE_ACCEL_FULLSCALE_4G,
+    MPU9250_DEVICE_ACCEL_FULLSCALE_8G,
+    MPU9250_DEVICE_ACCEL_FULLSCALE_16G
+} mpu9250_device_accel_fullscale_t;
+
+/**
+ * Gyroscope fullscale, GYRO_CONFIG register encoding
+ */
+typedef enum
+{
+    MPU9250_DEVICE_GYRO_FULLSCALE_250DPS,
+    MPU9250_DEVICE_GYRO_FULLSCALE_500DPS,
+    MPU9250_DEVICE_GYRO_FULLSCALE_1000DPS,
+    MPU9250_DEVICE_GYRO_FULLSCALE_2000DPS
+} mpu9250_device_gyro_fullscale_t;
+
+/**
+ * Raw 9-axis sample, all parts captured by the same transaction
+ */
+typedef struct
+{
+    int16_t accel[3];           //!< Accelerometer X/Y/Z, LSB depends on fullscale
+    int16_t temperature;        //!< Die temperature
+    int16_t gyro[3];            //!< Gyroscope X/Y/Z, LSB depends on fullscale
+    int16_t magn[3];            //!< AK8963 X/Y/Z, 0.15uT/LSB before sensitivity adjustment
+    uint8_t magn_asa[3];        //!< AK8963 sensitivity adjustment values from fuse ROM
+    uint8_t accel_fullscale;    //!< @ref mpu9250_device_accel_fullscale_t
+    uint8_t gyro_fullscale;     //!< @ref mpu9250_device_gyro_fullscale_t
+} mpu9250_device_sample_t;
+
+/**
+ * @}
+ */
+
+/**
+ * Initialise the MPU9250 in combined device mode.
+ *
+ * Resets the device, reads the AK8963 sensitivity adjustment values, puts the
+ * AK8963 in 16-bit continuous measurement mode and configures the internal
+ * I2C master so SLV0 mirrors the magnetometer output into EXT_SENS_DATA.
+ * Calling it again once initialised does nothing, so every sensor type
+ * backed by the device may call it.
+ *
+ * @return @ref zos_result_t
+ */
+zos_result_t mpu9250_device_init(void);
+
+/**
+ * Configure the accelerometer part
+ *
+ * @param[in] fullscale: @ref mpu9250_device_accel_fullscale_t
+ * @param[in] rate_hz: Sample rate of accelerometer and gyroscope, 4Hz .. 1000Hz
+ * @param[in] axis_en: MPU9250_DEVICE_AXIS_EN_X/Y/Z
+ * @return @ref zos_result_t
+ */
+zos_result_t mpu9250_device_set_accel_config(mpu9250_device_accel_fullscale_t fullscale, uint16_t rate_hz, uint8_t axis_en);
+
+/**
+ * Configure the gyroscope part
+ *
+ * @param[in] fullscale: @ref mpu9250_device_gyro_fullscale_t
+ * @param[in] axis_en: MPU9250_DEVICE_AXIS_EN_X/Y/Z
+ * @return @ref zos_result_t
+ */
+zos_result_t mpu9250_device_set_gyro_config(mpu9250_device_gyro_fullscale_t fullscale, uint8_t axis_en);
+
+/**
+ * Enable or disable the data ready signal on the INT pin for a part
+ *
+ * The device has one data ready interrupt shared by all parts. While any part
+ * has it enabled, INT is latched high on data ready until the next register read.
+ *
+ * @param[in] part: Part requesting the interrupt
+ * @param[in] enabled: True to enable the interrupt for `part`
+ * @return @ref zos_result_t
+ */
+zos_result_t mpu9250_device_set_data_ready_irq(mpu9250_device_part_t part, zos_bool_t enabled);
+
+/**
+ * Read accelerometer, temperature, gyroscope and magnetometer in one burst
+ *
+ * Marks the sample as new for every part, see @ref mpu9250_device_get_sample().
+ *
+ * @return @ref zos_result_t
+ */
+zos_result_t mpu9250_device_read(void);
+
+/**
+ * Check whether a part has a sample it has not consumed yet.
+ *
+ * If the part already consumed the shared sample, the data ready status is
+ * polled and, when set, the next sample is read for all parts at once.
+ *
+ * @param[in] part: Part polling for data
+ * @param[out] has_data: True if there is new data available
+ * @return @ref zos_result_t
+ */
+zos_result_t mpu9250_device_has_new_data(mpu9250_device_part_t part, zos_bool_t *has_data);
+
+/**
+ * Get the shared sample for a part.
+ *
+ * A new burst is only read if `part` already consumed the current sample,
+ * so polling the accelerometer, gyroscope and magnetometer in turn costs a
+ * single I2C transaction.
+ *
+ * @param[in] part: Part consuming the sample
+ * @param[out] sample: Pointer to the shared sample
+ * @return @ref zos_result_t
+ */
+zos_result_t mpu9250_device_get_sample(mpu9250_device_part_t part, const mpu9250_device_sample_t **sample);
@@ -0,0 +1,182 @@
+/*
+ * ZentriOS SDK LICENSE AGREEMENT | Zentri.com, 2015.
+ *
+ * Use of source code and/or libraries contained in the ZentriOS SDK is
+ * subject to the Zentri Operating System SDK license agreement and
+ * applicable open source license agreements.
+ *
+ */
+
+#include "zos.h"
+#include "mpu9250_device.h"
+
+/*
+ * The accelerometer, gyroscope and magnetometer sensor types are all backed by
+ * the same MPU9250 device context, one I2C burst feeds all three.
+ */
+
+
+
+#ifdef SENSOR_LIB_ACCELEROMETER
+
+#include "sensor/types/accelerometer/accelerometer.h"
+
+static const uint16_t accel_rate_hz[] =
+{
+    [ACCEL_SAMP_FREQ_1HZ]   = 4, // slowest rate the sample rate divider supports
+    [ACCEL_SAMP_FREQ_10HZ]  = 10,
+    [ACCEL_SAMP_FREQ_25HZ]  = 25,
+    [ACCEL_SAMP_FREQ_50HZ]  = 50,
+    [ACCEL_SAMP_FREQ_100HZ] = 100,
+    [ACCEL_SAMP_FREQ_200HZ] = 200,
+    [ACCEL_SAMP_FREQ_400HZ] = 400
+};
+
+/*************************************************************************************************/
+zos_result_t sensor_accelerometer_init(const accelerometer_config_t *config)
+{
+    zos_result_t result;
+    const uint16_t rate_hz = (config->samp_freq <= ACCEL_SAMP_FREQ_400HZ) ? accel_rate_hz[config->samp_freq] : 50;
+
+    if (ZOS_FAILED(result, mpu9250_device_init()))
+    {
+    }
+    else if (ZOS_FAILED(result, mpu9250_device_set_accel_config((mpu9250_device_accel_fullscale_t)config->fullscale, rate_hz, config->axis_en)))
+    {
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+zos_result_t sensor_accelerometer_has_new_data(zos_bool_t *has_data)
+{
+    return mpu9250_device_has_new_data(MPU9250_DEVICE_ACCEL, has_data);
+}
+
+/*************************************************************************************************/
+zos_result_t sensor_accelerometer_set_data_ready_irq(zos_bool_t enabled)
+{
+    return mpu9250_device_set_data_ready_irq(MPU9250_DEVICE_ACCEL, enabled);
+}
+
+/*************************************************************************************************/
+zos_result_t sensor_accelerometer_get_data(accelerometer_data_t *data)
+{
+    zos_result_t result;
+    const mpu9250_device_sample_t *sample;
+
+    if (!ZOS_FAILED(result, mpu9250_device_get_sample(MPU9250_DEVICE_ACCEL, &sample)))
+    {
+        // phy_val = full_scale_range * reg_val / 32768, 2G << fullscale
+        const int32_t range_mg = 2000 << sample->accel_fullscale;
+
+        data->x = (range_mg * sample->accel[0]) / 32768;
+        data->y = (range_mg * sample->accel[1]) / 32768;
+        data->z = (range_mg * sample->accel[2]) / 32768;
+    }
+
+    return result;
+}
+
+#endif
+
+
+
+#ifdef SENSOR_LIB_GYROSCOPE
+
+#include "sensor/types/gyroscope/gyroscope.h"
+
+/*************************************************************************************************/
+zos_result_t sensor_gyroscope_init(const gyroscope_config_t *config)
+{
+    zos_result_t result;
+
+    if (ZOS_FAILED(result, mpu9250_device_init()))
+    {
+    }
+    else if (ZOS_FAILED(result, mpu9250_device_set_gyro_config((mpu9250_device_gyro_fullscale_t)config->fullscale, config->axis_en)))
+    {
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+zos_result_t sensor_gyroscope_has_new_data(zos_bool_t *has_data)
+{
+    return mpu9250_device_has_new_data(MPU9250_DEVICE_GYRO, has_data);
+}
+
+/*************************************************************************************************/
+zos_result_t sensor_gyroscope_set_data_ready_irq(zos_bool_t enabled)
+{
+    return mpu9250_device_set_data_ready_irq(MPU9250_DEVICE_GYRO, enabled);
+}
+
+/*************************************************************************************************/
+zos_result_t sensor_gyroscope_get_data(gyroscope_data_t *data)
+{
+    zos_result_t result;
+    const mpu9250_device_sample_t *sample;
+
+    if (!ZOS_FAILED(result, mpu9250_device_get_sample(MPU9250_DEVICE_GYRO, &sample)))
+    {
+        // phy_val = full_scale_range * reg_val / 32768, 250dps << fullscale
+        const int32_t range_dps = 250 << sample->gyro_fullscale;
+
+        data->x = (range_dps * sample->gyro[0]) / 32768;
+        data->y = (range_dps * sample->gyro[1]) / 32768;
+        data->z = (range_dps * sample->gyro[2]) / 32768;
+    }
+
+    return result;
+}
+
+#endif
+
+
+
+#ifdef SENSOR_LIB_MAGNETOMETER
+
+#include "sensor/types/magnetometer/magnetometer.h"
+
+/*************************************************************************************************/
+zos_result_t sensor_magnetometer_init(const magnetometer_config_t *config)
+{
+    UNUSED_PARAMETER(config);
+
+    return mpu9250_device_init();
+}
+
+/*************************************************************************************************/
+zos_result_t sensor_magnetometer_has_new_data(zos_bool_t *has_data)
+{
+    return mpu9250_device_has_new_data(MPU9250_DEVICE_MAGN, has_data);
+}
+
+/*************************************************************************************************/
+zos_result_t sensor_magnetometer_set_data_ready_irq(zos_bool_t enabled)
+{
+    return mpu9250_device_set_data_ready_irq(MPU9250_DEVICE_MAGN, enabled);
+}
+
+/*************************************************************************************************/
+zos_result_t sensor_magnetometer_get_data(magnetometer_data_t *data)
+{
+    zos_result_t result;
+    const mpu9250_device_sample_t *sample;
+
+    if (!ZOS_FAILED(result, mpu9250_device_get_sample(MPU9250_DEVICE_MAGN, &sample)))
+    {
+        // Hadj = (H * (ASA + 128)) >> 8
+        // phy_val = 4912 * Hadj / 32768 ~ 15 * Hadj / 100 (16-bit output, 0.15 uT/LSB)
+        data->x = (15 * ((sample->magn[0] * (sample->magn_asa[0] + 128)) >> 8)) / 100;
+        data->y = (15 * ((sample->magn[1] * (sample->magn_asa[1] + 128)) >> 8)) / 100;
+        data->z = (15 * ((sample->magn[2] * (sample->magn_asa[2] + 128)) >> 8)) / 100;
+    }
+
+    return result;
+}
+
+#endif
@@ -10,9 +10,6 @@
 #include "lm75a.h"
 
 
-#define LM75A_SLAVE_ADDRESS 0x4C
-
-
 #define LM75A_REG_TEMP 0x00
 
 
@@ -31,9 +28,15 @@ static const zos_i2c_device_t ic2_lm7a =
 
 /*************************************************************************************************/
 zos_result_t lm75a_temperature_read(uint16_t *raw_temp)
+{
+	return lm75a_temperature_read_device(&ic2_lm7a, raw_temp);
+}
+
+/*************************************************************************************************/
+zos_result_t lm75a_temperature_read_device(const zos_i2c_device_t *device, uint16_t *raw_temp)
 {
 	uint16_t buffer;
-	zos_result_t result = zn_i2c_master_read_reg(&ic2_lm7a, LM75A_REG_TEMP, (uint8_t*)&buffer, 2);
+	zos_result_t result = zn_i2c_master_read_reg(device, LM75A_REG_TEMP, (uint8_t*)&buffer, 2);
 	buffer = htons(buffer);
 	*raw_temp = (buffer >> 5);
 	return result;
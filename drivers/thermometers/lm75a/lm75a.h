@@ -14,9 +14,13 @@
 
 
 
+#define LM75A_SLAVE_ADDRESS 0x4C   // A2..A0 select 0x48 .. 0x4F
+
 #define LM75A_TEMP_MASK 0x3FF
 #define LM75A_TEMP_SIGN_BIT 0x200
 
 
 
 zos_result_t lm75a_temperature_read(uint16_t *raw_temp);
+zos_result_t lm75a_temperature_read_device(const zos_i2c_device_t *device, uint16_t *raw_temp);
+
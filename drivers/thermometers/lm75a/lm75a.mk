@@ -3,3 +3,4 @@ NAME := drivers_thermometer_lm75a
 $(NAME)_SOURCES := lm75a.c sensor_api.c
 
 $(NAME)_INCLUDES := .
+GLOBAL_INCLUDES := .
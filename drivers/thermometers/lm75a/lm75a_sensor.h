@@ -0,0 +1,18 @@
+/*
+ * ZentriOS SDK LICENSE AGREEMENT | Zentri.com, 2015.
+ *
+ * Use of source code and/or libraries contained in the ZentriOS SDK is
+ * subject to the Zentri Operating System SDK license agreement and
+ * applicable open source license agreements.
+ *
+ */
+#pragma once
+
+
+
+#include "sensor/sensor.h"
+
+
+
+/* Multi-instance driver, register one instance per device address with sensor_register() */
+extern const sensor_driver_t sensor_driver_lm75a;
@@ -8,13 +8,29 @@
  */
 
 #include "zos.h"
-#include "sensor/types/thermometer/thermometer.h"
+#include "sensor/sensor.h"
 #include "lm75a.h"
+#include "lm75a_sensor.h"
 
 
 #define LM75A_SCALE_FACTOR            (uint32_t)12 // .125 * 100
 
 
+static zos_result_t lm75a_instance_init(sensor_instance_t *instance, const thermometer_config_t *config);
+static zos_result_t lm75a_instance_has_new_data(sensor_instance_t *instance, zos_bool_t *has_data);
+static zos_result_t lm75a_instance_get_data(sensor_instance_t *instance, thermometer_data_t *data);
+
+
+const sensor_driver_t sensor_driver_lm75a =
+{
+    .type         = SENSOR_THERMOMETER,
+    .context_size = 0,
+    .init         = (sensor_instance_init_prototype_t)lm75a_instance_init,
+    .has_data     = (sensor_instance_has_data_prototype_t)lm75a_instance_has_new_data,
+    .get_data     = (sensor_instance_get_data_prototype_t)lm75a_instance_get_data
+};
+
+
 /*************************************************************************************************/
 zos_result_t sensor_thermometer_init(const thermometer_config_t *config)
 {
@@ -46,3 +62,35 @@ int32_t sensor_thermometer_convert(uint16_t raw_value)
         return raw_value * LM75A_SCALE_FACTOR;
     }
 }
+
+
+
+/*************************************************************************************************/
+static zos_result_t lm75a_instance_init(sensor_instance_t *instance, const thermometer_config_t *config)
+{
+    UNUSED_PARAMETER(instance);
+    UNUSED_PARAMETER(config);
+    return ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+static zos_result_t lm75a_instance_has_new_data(sensor_instance_t *instance, zos_bool_t *has_data)
+{
+    UNUSED_PARAMETER(instance);
+    *has_data = ZOS_TRUE;
+    return ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+static zos_result_t lm75a_instance_get_data(sensor_instance_t *instance, thermometer_data_t *data)
+{
+    zos_result_t result;
+    uint16_t raw_data;
+
+    if (!ZOS_FAILED(result, lm75a_temperature_read_device(&instance->i2c, &raw_data)))
+    {
+        sensor_thermometer_set_data(sensor_thermometer_convert(raw_data), data);
+    }
+
+    return result;
+}
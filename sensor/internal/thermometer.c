@@ -32,14 +32,7 @@ WEAK zos_result_t sensor_thermometer_get_data(thermometer_data_t *data)
     if (!ZOS_FAILED(result, sensor_thermometer_read(&raw_data)))
     {
 
-        const int32_t temp = sensor_thermometer_convert(raw_data);
-        data->raw = temp;
-        data->value.whole = temp / SENSOR_THERMOMETER_OUTPUT_SCALE;
-        data->value.fraction = temp % SENSOR_THERMOMETER_OUTPUT_SCALE;
-        if(temp < 0)
-        {
-            data->value.fraction *= -1;
-        }
+        sensor_thermometer_set_data(sensor_thermometer_convert(raw_data), data);
     }
     else
     {
@@ -50,4 +43,17 @@ WEAK zos_result_t sensor_thermometer_get_data(thermometer_data_t *data)
 }
 
 
+/*************************************************************************************************/
+void sensor_thermometer_set_data(int32_t temp, thermometer_data_t *data)
+{
+    data->raw = temp;
+    data->value.whole = temp / SENSOR_THERMOMETER_OUTPUT_SCALE;
+    data->value.fraction = temp % SENSOR_THERMOMETER_OUTPUT_SCALE;
+    if(temp < 0)
+    {
+        data->value.fraction *= -1;
+    }
+}
+
+
 #endif
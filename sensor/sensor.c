@@ -10,43 +10,95 @@
 
 
 
+/* Weak defaults of the optional driver functions */
+#ifdef SENSOR_LIB_ACCELEROMETER
+SENSOR_LIB_DEFINE_DEFAULT_FUNCTIONS(accelerometer)
+
+/* Overridden by the drivers with a hardware FIFO */
+WEAK zos_result_t sensor_accelerometer_get_fifo_data(accelerometer_data_t *data, uint16_t max_samples, uint16_t *sample_count)
+{
+    UNUSED_PARAMETER(data);
+    UNUSED_PARAMETER(max_samples);
+    *sample_count = 0;
+    return ZOS_UNSUPPORTED;
+}
+#endif
+#ifdef SENSOR_LIB_HYGROMETER
+SENSOR_LIB_DEFINE_DEFAULT_FUNCTIONS(hygrometer)
+#endif
+#ifdef SENSOR_LIB_THERMOMETER
+SENSOR_LIB_DEFINE_DEFAULT_FUNCTIONS(thermometer)
+#endif
+#ifdef SENSOR_LIB_GYROSCOPE
+SENSOR_LIB_DEFINE_DEFAULT_FUNCTIONS(gyroscope)
+#endif
+#ifdef SENSOR_LIB_MAGNETOMETER
+SENSOR_LIB_DEFINE_DEFAULT_FUNCTIONS(magnetometer)
+#endif
+#ifdef SENSOR_LIB_LIGHT
+SENSOR_LIB_DEFINE_DEFAULT_FUNCTIONS(light)
+#endif
+#ifdef SENSOR_LIB_AIRQUALITY
+SENSOR_LIB_DEFINE_DEFAULT_FUNCTIONS(airquality)
+#endif
+#ifdef SENSOR_LIB_CAPACITIVE_INPUT
+SENSOR_LIB_DEFINE_DEFAULT_FUNCTIONS(capacitive_input)
+#endif
+
+
 static const struct
 {
     const sensor_init_prototype_t init;
     const sensor_has_data_prototype_t has_data;
     const sensor_get_data_prototype_t get_data;
+    const sensor_get_data_batch_prototype_t get_data_batch;
+    const sensor_set_data_ready_irq_prototype_t set_data_ready_irq;
 }
 sensor_functions[] =
 {
 #ifdef SENSOR_LIB_ACCELEROMETER
-        SENSOR_LIB_REGISTER_SENSOR_TYPE(accelerometer, ACCELEROMETER),
+        SENSOR_LIB_REGISTER_FULL_SENSOR_TYPE(accelerometer, ACCELEROMETER),
 #endif
 #ifdef SENSOR_LIB_HYGROMETER
-        SENSOR_LIB_REGISTER_SENSOR_TYPE(hygrometer, HYGROMETER),
+        SENSOR_LIB_REGISTER_FULL_SENSOR_TYPE(hygrometer, HYGROMETER),
 #endif
 #ifdef SENSOR_LIB_THERMOMETER
-        SENSOR_LIB_REGISTER_SENSOR_TYPE(thermometer, THERMOMETER),
+        SENSOR_LIB_REGISTER_FULL_SENSOR_TYPE(thermometer, THERMOMETER),
 #endif
 #ifdef SENSOR_LIB_GYROSCOPE
-        SENSOR_LIB_REGISTER_SENSOR_TYPE(gyroscope, GYROSCOPE),
+        SENSOR_LIB_REGISTER_FULL_SENSOR_TYPE(gyroscope, GYROSCOPE),
 #endif
 #ifdef SENSOR_LIB_MAGNETOMETER
-        SENSOR_LIB_REGISTER_SENSOR_TYPE(magnetometer, MAGNETOMETER),
+        SENSOR_LIB_REGISTER_FULL_SENSOR_TYPE(magnetometer, MAGNETOMETER),
 #endif
 #ifdef SENSOR_LIB_LIGHT
-        SENSOR_LIB_REGISTER_SENSOR_TYPE(light, LIGHT),
+        SENSOR_LIB_REGISTER_FULL_SENSOR_TYPE(light, LIGHT),
 #endif
 #ifdef SENSOR_LIB_AIRQUALITY
-        SENSOR_LIB_REGISTER_SENSOR_TYPE(airquality, AIRQUALITY),
+        SENSOR_LIB_REGISTER_FULL_SENSOR_TYPE(airquality, AIRQUALITY),
 #endif
 #ifdef SENSOR_LIB_CAPACITIVE_INPUT
-        SENSOR_LIB_REGISTER_SENSOR_TYPE(capacitive_input, CAPACITIVE_INPUT)
+        SENSOR_LIB_REGISTER_FULL_SENSOR_TYPE(capacitive_input, CAPACITIVE_INPUT)
 #endif
 #ifdef SENSOR_LIB_REGISTER_USER_SENSORS
         SENSOR_LIB_REGISTER_USER_SENSORS
 #endif
 };
 
+typedef struct
+{
+    zos_gpio_t gpio;
+    zos_event_handler_t handler;
+    void *arg;
+} data_ready_event_t;
+
+static data_ready_event_t data_ready_events[SENSOR_COUNT];
+
+static sensor_instance_t *sensor_instance_list;
+
+
+static void data_ready_irq_callback(void *arg);
+
 
 /* Input sensor and config */
 zos_result_t sensor_init(sensor_id_t sensor_id, const void *config)
@@ -83,3 +135,199 @@ zos_result_t sensor_get_data(sensor_id_t sensor_id, void *data)
 }
 
 
+
+/*************************************************************************************************/
+/* Input sensor, output up to max_samples data entries */
+zos_result_t sensor_get_data_batch(sensor_id_t sensor_id, void *data, uint16_t max_samples, uint16_t *sample_count, uint32_t *timestamps)
+{
+    *sample_count = 0;
+
+    if(sensor_id >= SENSOR_COUNT)
+    {
+        return ZOS_INVALID_ARG;
+    }
+    else if(sensor_functions[sensor_id].get_data_batch == NULL)
+    {
+        // Types registered with SENSOR_LIB_REGISTER_SENSOR_TYPE(), e.g. user sensors, leave the slot empty
+        return sensor_get_data_batch_generic(sensor_functions[sensor_id].has_data, sensor_functions[sensor_id].get_data,
+                                             data, max_samples, sample_count, timestamps);
+    }
+    return sensor_functions[sensor_id].get_data_batch(data, max_samples, sample_count, timestamps);
+}
+
+/*************************************************************************************************/
+zos_result_t sensor_set_data_ready_event(sensor_id_t sensor_id, zos_gpio_t gpio, zos_event_handler_t handler, void *arg)
+{
+    zos_result_t result;
+
+    if(sensor_id >= SENSOR_COUNT)
+    {
+        return ZOS_INVALID_ARG;
+    }
+
+    if(data_ready_events[sensor_id].handler != NULL)
+    {
+        zn_gpio_irq_disable(data_ready_events[sensor_id].gpio);
+        data_ready_events[sensor_id].handler = NULL;
+    }
+
+    if(sensor_functions[sensor_id].set_data_ready_irq == NULL)
+    {
+        result = ZOS_UNSUPPORTED;
+    }
+    else if(handler == NULL)
+    {
+        result = sensor_functions[sensor_id].set_data_ready_irq(ZOS_FALSE);
+    }
+    else if(ZOS_FAILED(result, sensor_functions[sensor_id].set_data_ready_irq(ZOS_TRUE)))
+    {
+    }
+    else
+    {
+        data_ready_events[sensor_id].gpio = gpio;
+        data_ready_events[sensor_id].handler = handler;
+        data_ready_events[sensor_id].arg = arg;
+
+        zn_gpio_init(gpio, GPIO_INPUT_HIGHZ, ZOS_FALSE);
+        if(ZOS_FAILED(result, zn_gpio_irq_enable(gpio, GPIO_IRQ_TRIGGER_RISING_EDGE, data_ready_irq_callback, (void*)&data_ready_events[sensor_id])))
+        {
+            data_ready_events[sensor_id].handler = NULL;
+            sensor_functions[sensor_id].set_data_ready_irq(ZOS_FALSE);
+        }
+        else if(!zn_event_irq_events_enabled())
+        {
+            zn_event_enable_irq_events(8);
+        }
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+zos_result_t sensor_get_data_batch_generic(sensor_has_data_prototype_t has_data, sensor_get_data_prototype_t get_data,
+                                           void *data, uint16_t max_samples, uint16_t *sample_count, uint32_t *timestamps)
+{
+    zos_result_t result = ZOS_SUCCESS;
+    zos_bool_t new_data;
+
+    *sample_count = 0;
+
+    // Without a FIFO there is only ever the latest sample to read
+    if(max_samples > 0 && !ZOS_FAILED(result, has_data(&new_data)) && new_data && !ZOS_FAILED(result, get_data(data)))
+    {
+        if(timestamps != NULL)
+        {
+            timestamps[0] = zn_rtos_get_time();
+        }
+        *sample_count = 1;
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+zos_result_t sensor_register(const sensor_driver_t *driver, const zos_i2c_device_t *i2c, sensor_handle_t *handle)
+{
+    zos_result_t result;
+    sensor_instance_t *instance;
+    sensor_instance_t **tail;
+
+    if((driver == NULL) || (i2c == NULL) || (driver->type >= SENSOR_COUNT))
+    {
+        return ZOS_INVALID_ARG;
+    }
+
+    // The driver context is allocated with the instance
+    if(!ZOS_FAILED(result, zn_malloc((uint8_t**)&instance, sizeof(sensor_instance_t) + driver->context_size)))
+    {
+        memset(instance, 0, sizeof(sensor_instance_t) + driver->context_size);
+        instance->driver = driver;
+        instance->i2c = *i2c;
+        instance->context = (driver->context_size > 0) ? (void*)&instance[1] : NULL;
+
+        // Append so sensor_find() indexes follow registration order
+        for(tail = &sensor_instance_list; *tail != NULL; tail = &(*tail)->next)
+        {
+        }
+        *tail = instance;
+
+        *handle = instance;
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+zos_result_t sensor_unregister(sensor_handle_t handle)
+{
+    for(sensor_instance_t **link = &sensor_instance_list; *link != NULL; link = &(*link)->next)
+    {
+        if(*link == handle)
+        {
+            *link = handle->next;
+            zn_free(handle);
+
+            return ZOS_SUCCESS;
+        }
+    }
+
+    return ZOS_INVALID_HANDLE;
+}
+
+/*************************************************************************************************/
+zos_result_t sensor_find(sensor_id_t sensor_id, uint8_t index, sensor_handle_t *handle)
+{
+    for(sensor_instance_t *instance = sensor_instance_list; instance != NULL; instance = instance->next)
+    {
+        if((instance->driver->type == sensor_id) && (index-- == 0))
+        {
+            *handle = instance;
+
+            return ZOS_SUCCESS;
+        }
+    }
+
+    return ZOS_NOT_FOUND;
+}
+
+/*************************************************************************************************/
+zos_result_t sensor_instance_init(sensor_handle_t handle, const void *config)
+{
+    if(handle == NULL)
+    {
+        return ZOS_INVALID_HANDLE;
+    }
+    return handle->driver->init(handle, config);
+}
+
+/*************************************************************************************************/
+zos_result_t sensor_instance_has_new_data(sensor_handle_t handle, zos_bool_t *has_data)
+{
+    *has_data = ZOS_FALSE;
+
+    if(handle == NULL)
+    {
+        return ZOS_INVALID_HANDLE;
+    }
+    return handle->driver->has_data(handle, has_data);
+}
+
+/*************************************************************************************************/
+zos_result_t sensor_instance_get_data(sensor_handle_t handle, void *data)
+{
+    if(handle == NULL)
+    {
+        return ZOS_INVALID_HANDLE;
+    }
+    return handle->driver->get_data(handle, data);
+}
+
+
+
+/*************************************************************************************************/
+static void data_ready_irq_callback(void *arg)
+{
+    const data_ready_event_t *event = arg;
+
+    zn_event_issue(event->handler, event->arg, EVENT_FLAGS1(FROM_IRQ));
+}
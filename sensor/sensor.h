@@ -47,6 +47,10 @@
 /**
  * @brief Register a sensor type with the sensor library
  * @def SENSOR_LIB_REGISTER_SENSOR_TYPE(name, id)
+ *
+ * The type only provides init, has_new_data and get_data: @ref sensor_get_data_batch()
+ * falls back to @ref sensor_get_data_batch_generic() and @ref sensor_set_data_ready_event()
+ * returns ZOS_UNSUPPORTED.
  */
 #define SENSOR_LIB_REGISTER_SENSOR_TYPE(name, id)                               \
     [SENSOR_ ## id] =                                                           \
@@ -56,6 +60,47 @@
     .get_data = (sensor_get_data_prototype_t)sensor_ ## name ## _get_data       \
 }
 
+/**
+ * @brief Register a sensor type that also provides the optional functions
+ * @def SENSOR_LIB_REGISTER_FULL_SENSOR_TYPE(name, id)
+ *
+ * Also registers sensor_<name>_get_data_batch() and sensor_<name>_set_data_ready_irq(),
+ * see @ref SENSOR_LIB_DEFINE_DEFAULT_FUNCTIONS for weak versions of both.
+ */
+#define SENSOR_LIB_REGISTER_FULL_SENSOR_TYPE(name, id)                                              \
+    [SENSOR_ ## id] =                                                                               \
+{                                                                                                   \
+    .init               = (sensor_init_prototype_t)              sensor_ ## name ## _init,          \
+    .has_data           = (sensor_has_data_prototype_t)          sensor_ ## name ## _has_new_data,  \
+    .get_data           = (sensor_get_data_prototype_t)          sensor_ ## name ## _get_data,      \
+    .get_data_batch     = (sensor_get_data_batch_prototype_t)    sensor_ ## name ## _get_data_batch,\
+    .set_data_ready_irq = (sensor_set_data_ready_irq_prototype_t)sensor_ ## name ## _set_data_ready_irq \
+}
+
+/**
+ * @brief Define the default optional functions of a sensor type
+ * @def SENSOR_LIB_DEFINE_DEFAULT_FUNCTIONS(name)
+ *
+ * Defines weak versions of the functions a driver may leave out:
+ * - sensor_<name>_get_data_batch() built on @ref sensor_get_data_batch_generic(),
+ *   drivers with a hardware FIFO override it with a native implementation
+ * - sensor_<name>_set_data_ready_irq() returning ZOS_UNSUPPORTED,
+ *   drivers that can signal data ready on an interrupt pin override it
+ */
+#define SENSOR_LIB_DEFINE_DEFAULT_FUNCTIONS(name)                                                                       \
+WEAK zos_result_t sensor_ ## name ## _get_data_batch(name ## _data_t *data, uint16_t max_samples,                      \
+                                                     uint16_t *sample_count, uint32_t *timestamps)                      \
+{                                                                                                                       \
+    return sensor_get_data_batch_generic(sensor_ ## name ## _has_new_data,                                              \
+                                         (sensor_get_data_prototype_t)sensor_ ## name ## _get_data,                     \
+                                         data, max_samples, sample_count, timestamps);                                  \
+}                                                                                                                       \
+WEAK zos_result_t sensor_ ## name ## _set_data_ready_irq(zos_bool_t enabled)                                            \
+{                                                                                                                       \
+    UNUSED_PARAMETER(enabled);                                                                                          \
+    return ZOS_UNSUPPORTED;                                                                                             \
+}
+
 
 /** 
  *  Sensor id enumeration
@@ -96,6 +141,44 @@ typedef enum
 typedef zos_result_t (*sensor_init_prototype_t)(const void *config);
 typedef zos_result_t (*sensor_has_data_prototype_t)(zos_bool_t *has_data);
 typedef zos_result_t (*sensor_get_data_prototype_t)(void *data);
+typedef zos_result_t (*sensor_get_data_batch_prototype_t)(void *data, uint16_t max_samples, uint16_t *sample_count, uint32_t *timestamps);
+typedef zos_result_t (*sensor_set_data_ready_irq_prototype_t)(zos_bool_t enabled);
+
+typedef struct sensor_instance sensor_instance_t;
+
+/** Handle of a registered sensor instance, see @ref sensor_register() */
+typedef sensor_instance_t *sensor_handle_t;
+
+/* Drivers supporting multiple instances implement these, `instance` carries the bus and driver context */
+typedef zos_result_t (*sensor_instance_init_prototype_t)(sensor_instance_t *instance, const void *config);
+typedef zos_result_t (*sensor_instance_has_data_prototype_t)(sensor_instance_t *instance, zos_bool_t *has_data);
+typedef zos_result_t (*sensor_instance_get_data_prototype_t)(sensor_instance_t *instance, void *data);
+
+/**
+ * @brief Multi-instance sensor driver
+ *
+ * Exported by drivers that can run several devices side by side, e.g. two
+ * identical thermometers at different I2C addresses.
+ */
+typedef struct
+{
+    sensor_id_t type;                               //!< Sensor type, determines the config and data structures
+    uint16_t context_size;                          //!< Bytes of per-instance driver context
+    sensor_instance_init_prototype_t init;
+    sensor_instance_has_data_prototype_t has_data;
+    sensor_instance_get_data_prototype_t get_data;
+} sensor_driver_t;
+
+/**
+ * @brief Registered sensor instance
+ */
+struct sensor_instance
+{
+    const sensor_driver_t *driver;  //!< Driver of the instance
+    zos_i2c_device_t i2c;           //!< Bus, address and speed of the device
+    void *context;                  //!< Per-instance driver context, `driver->context_size` bytes, zeroed at registration
+    sensor_instance_t *next;
+};
 
 
 
@@ -126,6 +209,115 @@ zos_result_t sensor_has_new_data(sensor_id_t sensor_id, zos_bool_t *has_data);
  */
 zos_result_t sensor_get_data(sensor_id_t sensor_id, void *data);
 
+/**
+ * Get up to `max_samples` samples from sensor in one call
+ *
+ * Drivers with a hardware FIFO drain it in one transaction, other drivers
+ * return at most one sample, read when @ref sensor_has_new_data() reports new data.
+ *
+ * @param[in] sensor_id: ID of sensor
+ * @param[out] data: Buffer of `max_samples` sensor data entries (specific to sensor type), oldest first
+ * @param[in] max_samples: Number of entries available in `data` and `timestamps`
+ * @param[out] sample_count: Number of samples written
+ * @param[out] timestamps: Optional capture time of each sample in ms, see zn_rtos_get_time(), may be NULL
+ * @return @ref zos_result_t
+ */
+zos_result_t sensor_get_data_batch(sensor_id_t sensor_id, void *data, uint16_t max_samples, uint16_t *sample_count, uint32_t *timestamps);
+
+/**
+ * Deliver an event whenever the sensor has new data
+ *
+ * Configures the sensor to signal data ready on its interrupt pin and
+ * issues `handler` from the event thread on each rising edge of `gpio`,
+ * so the application no longer needs to poll @ref sensor_has_new_data().
+ * Drivers with a hardware FIFO enabled signal the FIFO watermark instead.
+ * The handler should read the data (e.g. with @ref sensor_get_data()),
+ * this clears the interrupt on the sensor so the next sample raises a new edge.
+ *
+ * @param[in] sensor_id: ID of sensor
+ * @param[in] gpio: GPIO the sensor interrupt pin is connected to
+ * @param[in] handler: Event handler, NULL disables the notification
+ * @param[in] arg: Argument passed to `handler`
+ * @return @ref zos_result_t, ZOS_UNSUPPORTED if the driver has no data ready interrupt
+ */
+zos_result_t sensor_set_data_ready_event(sensor_id_t sensor_id, zos_gpio_t gpio, zos_event_handler_t handler, void *arg);
+
+/**
+ * Generic batch read for drivers without a hardware FIFO
+ *
+ * Reads at most one sample, time stamped when it is read, if `has_data` reports new data.
+ * Many drivers report new data on every call, so reading more would only return copies
+ * of the same measurement.
+ *
+ * @param[in] has_data: Driver has_new_data function
+ * @param[in] get_data: Driver get_data function
+ * @param[out] data: Buffer of `max_samples` entries
+ * @param[in] max_samples: Number of entries available in `data` and `timestamps`
+ * @param[out] sample_count: Number of samples written
+ * @param[out] timestamps: Optional capture time of each sample in ms, may be NULL
+ * @return @ref zos_result_t
+ */
+zos_result_t sensor_get_data_batch_generic(sensor_has_data_prototype_t has_data, sensor_get_data_prototype_t get_data,
+                                           void *data, uint16_t max_samples, uint16_t *sample_count, uint32_t *timestamps);
+
+/**
+ * Register a sensor instance.
+ *
+ * Instances live alongside the type-indexed sensors above; any number of
+ * instances of the same driver may be registered at different addresses.
+ *
+ * @param[in] driver: Multi-instance driver of the device
+ * @param[in] i2c: Bus and address of the device
+ * @param[out] handle: Handle of the new instance
+ * @return @ref zos_result_t
+ */
+zos_result_t sensor_register(const sensor_driver_t *driver, const zos_i2c_device_t *i2c, sensor_handle_t *handle);
+
+/**
+ * Unregister a sensor instance and release its driver context
+ *
+ * @param[in] handle: Handle returned by @ref sensor_register()
+ * @return @ref zos_result_t
+ */
+zos_result_t sensor_unregister(sensor_handle_t handle);
+
+/**
+ * Find a registered instance of a sensor type
+ *
+ * @param[in] sensor_id: Sensor type to look for
+ * @param[in] index: Zero based index among the instances of `sensor_id`, in registration order
+ * @param[out] handle: Handle of the instance
+ * @return @ref zos_result_t, ZOS_NOT_FOUND if there are fewer than `index + 1` instances
+ */
+zos_result_t sensor_find(sensor_id_t sensor_id, uint8_t index, sensor_handle_t *handle);
+
+/**
+ * Initialise a sensor instance.
+ *
+ * @param[in] handle: Handle returned by @ref sensor_register()
+ * @param[in] config: config used by initialisation function (specific to sensor type)
+ * @return @ref zos_result_t
+ */
+zos_result_t sensor_instance_init(sensor_handle_t handle, const void *config);
+
+/**
+ * Poll a sensor instance to see if new data is available
+ *
+ * @param[in] handle: Handle returned by @ref sensor_register()
+ * @param[out] has_data: True if there is new data available
+ * @return @ref zos_result_t
+ */
+zos_result_t sensor_instance_has_new_data(sensor_handle_t handle, zos_bool_t *has_data);
+
+/**
+ * Get latest data from a sensor instance
+ *
+ * @param[in] handle: Handle returned by @ref sensor_register()
+ * @param[out] data: Data from sensor (specific to sensor type)
+ * @return @ref zos_result_t
+ */
+zos_result_t sensor_instance_get_data(sensor_handle_t handle, void *data);
+
 /**
  * @}
  */
@@ -59,6 +59,7 @@ typedef enum
 
 typedef uint8_t accel_axis_en_t; //<! axis enable
 typedef uint8_t accel_wom_thr; //!< Wake on Motion threshold
+typedef uint8_t accel_fifo_wtm_t; //!< FIFO watermark level in samples
 
 /**
  * @brief Accelerometer configuration
@@ -70,6 +71,7 @@ typedef struct
     accel_axis_en_t axis_en; //!< axis enable
     accel_wom_thr wake_accel_threshold; //!< Threshold value for the Wake on Motion Interrupt for x/y/z axes. LSB = 4mg (range is 0mg to 1020mg)
     accel_mode_t mode; //!< mode
+    accel_fifo_wtm_t fifo_watermark; //!< Hardware FIFO watermark in samples, 0 disables the FIFO (single sample mode)
 } accelerometer_config_t;
 
 /** 
@@ -111,3 +113,36 @@ zos_result_t sensor_accelerometer_has_new_data(zos_bool_t *has_data);
  */
 zos_result_t sensor_accelerometer_get_data(accelerometer_data_t *data);
 
+/**
+ * Get up to `max_samples` samples from accelerometer sensor
+ *
+ * @param[out] data: Buffer of samples from sensor in mG, oldest first
+ * @param[in] max_samples: Number of entries available in `data` and `timestamps`
+ * @param[out] sample_count: Number of samples written
+ * @param[out] timestamps: Optional capture time of each sample in ms, may be NULL
+ * @return @ref zos_result_t
+ */
+zos_result_t sensor_accelerometer_get_data_batch(accelerometer_data_t *data, uint16_t max_samples, uint16_t *sample_count, uint32_t *timestamps);
+
+/**
+ * Enable or disable the accelerometer data ready signal on its interrupt pin
+ *
+ * @param[in] enabled: True to signal data ready on the interrupt pin
+ * @return @ref zos_result_t, ZOS_UNSUPPORTED if the driver has no data ready interrupt
+ */
+zos_result_t sensor_accelerometer_set_data_ready_irq(zos_bool_t enabled);
+
+/**
+ * Drain buffered samples from the accelerometer hardware FIFO
+ *
+ * Only available on drivers with a hardware FIFO, and only when the sensor
+ * was initialised with a non-zero `fifo_watermark`. When the FIFO is enabled,
+ * @ref sensor_accelerometer_has_new_data() reports data once the watermark is reached.
+ *
+ * @param[out] data: Buffer of samples from sensor in mG, oldest first
+ * @param[in] max_samples: Number of entries available in `data`
+ * @param[out] sample_count: Number of samples written to `data`
+ * @return @ref zos_result_t, ZOS_UNSUPPORTED if the driver has no hardware FIFO
+ */
+zos_result_t sensor_accelerometer_get_fifo_data(accelerometer_data_t *data, uint16_t max_samples, uint16_t *sample_count);
+
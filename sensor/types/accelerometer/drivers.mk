@@ -25,6 +25,12 @@ GLOBAL_DEFINES += SENSOR_LIB_ACCELEROMETER
 $(NAME)_COMPONENTS += libraries/drivers/accelerometers/lsm6ds0
 endif
 
+# Combined MPU9250 device, one I2C burst feeds the accelerometer, gyroscope and magnetometer
+ifneq ($(filter DRIVER_IMU_MPU9250,$(PROCESSED_SDK_DEFINES)),)
+GLOBAL_DEFINES += SENSOR_LIB_ACCELEROMETER
+$(NAME)_COMPONENTS += libraries/drivers/imu/mpu9250
+endif
+
 ifneq ($(filter SENSOR_LIB_ACCELEROMETER,$(GLOBAL_DEFINES) $(PROCESSED_SDK_DEFINES)),)
 GLOBAL_INCLUDES += types/accelerometer
 endif
\ No newline at end of file
@@ -15,6 +15,11 @@ GLOBAL_DEFINES += SENSOR_LIB_GYROSCOPE
 $(NAME)_COMPONENTS += libraries/drivers/gyroscopes/l3g4200d
 endif
 
+ifneq ($(filter DRIVER_IMU_MPU9250,$(PROCESSED_SDK_DEFINES)),)
+GLOBAL_DEFINES += SENSOR_LIB_GYROSCOPE
+$(NAME)_COMPONENTS += libraries/drivers/imu/mpu9250
+endif
+
 ifneq ($(filter SENSOR_LIB_GYROSCOPE,$(GLOBAL_DEFINES) $(PROCESSED_SDK_DEFINES)),)
 GLOBAL_INCLUDES += types/gyroscope
 endif
\ No newline at end of file
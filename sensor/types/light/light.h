@@ -56,3 +56,22 @@ zos_result_t sensor_light_has_new_data(zos_bool_t *has_data);
  * @return @ref zos_result_t
  */
 zos_result_t sensor_light_get_data(light_data_t *data);
+
+/**
+ * Get up to `max_samples` samples from light sensor
+ *
+ * @param[out] data: Buffer of light in lux, oldest first
+ * @param[in] max_samples: Number of entries available in `data` and `timestamps`
+ * @param[out] sample_count: Number of samples written
+ * @param[out] timestamps: Optional capture time of each sample in ms, may be NULL
+ * @return @ref zos_result_t
+ */
+zos_result_t sensor_light_get_data_batch(light_data_t *data, uint16_t max_samples, uint16_t *sample_count, uint32_t *timestamps);
+
+/**
+ * Enable or disable the light sensor data ready signal on its interrupt pin
+ *
+ * @param[in] enabled: True to signal data ready on the interrupt pin
+ * @return @ref zos_result_t, ZOS_UNSUPPORTED if the driver has no data ready interrupt
+ */
+zos_result_t sensor_light_set_data_ready_irq(zos_bool_t enabled);
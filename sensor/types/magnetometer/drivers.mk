@@ -15,6 +15,11 @@ GLOBAL_DEFINES += SENSOR_LIB_MAGNETOMETER
 $(NAME)_COMPONENTS += libraries/drivers/magnetometers/hmc5883l
 endif
 
+ifneq ($(filter DRIVER_IMU_MPU9250,$(PROCESSED_SDK_DEFINES)),)
+GLOBAL_DEFINES += SENSOR_LIB_MAGNETOMETER
+$(NAME)_COMPONENTS += libraries/drivers/imu/mpu9250
+endif
+
 ifneq ($(filter SENSOR_LIB_MAGNETOMETER,$(GLOBAL_DEFINES) $(PROCESSED_SDK_DEFINES)),)
 GLOBAL_INCLUDES += types/magnetometer
 endif
\ No newline at end of file
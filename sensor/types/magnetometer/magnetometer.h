@@ -66,3 +66,22 @@ zos_result_t sensor_magnetometer_has_new_data(zos_bool_t *has_data);
  */
 zos_result_t sensor_magnetometer_get_data(magnetometer_data_t *data);
 
+/**
+ * Get up to `max_samples` samples from magnetometer sensor
+ *
+ * @param[out] data: Buffer of samples from sensor, oldest first
+ * @param[in] max_samples: Number of entries available in `data` and `timestamps`
+ * @param[out] sample_count: Number of samples written
+ * @param[out] timestamps: Optional capture time of each sample in ms, may be NULL
+ * @return @ref zos_result_t
+ */
+zos_result_t sensor_magnetometer_get_data_batch(magnetometer_data_t *data, uint16_t max_samples, uint16_t *sample_count, uint32_t *timestamps);
+
+/**
+ * Enable or disable the magnetometer data ready signal on its interrupt pin
+ *
+ * @param[in] enabled: True to signal data ready on the interrupt pin
+ * @return @ref zos_result_t, ZOS_UNSUPPORTED if the driver has no data ready interrupt
+ */
+zos_result_t sensor_magnetometer_set_data_ready_irq(zos_bool_t enabled);
+
@@ -65,6 +65,25 @@ zos_result_t sensor_thermometer_has_new_data(zos_bool_t *has_data);
  */
 zos_result_t sensor_thermometer_get_data(thermometer_data_t *data);
 
+/**
+ * Get up to `max_samples` samples from thermometer
+ *
+ * @param[out] data: Buffer of temperature in degC x 100, oldest first
+ * @param[in] max_samples: Number of entries available in `data` and `timestamps`
+ * @param[out] sample_count: Number of samples written
+ * @param[out] timestamps: Optional capture time of each sample in ms, may be NULL
+ * @return @ref zos_result_t
+ */
+zos_result_t sensor_thermometer_get_data_batch(thermometer_data_t *data, uint16_t max_samples, uint16_t *sample_count, uint32_t *timestamps);
+
+/**
+ * Enable or disable the thermometer data ready signal on its interrupt pin
+ *
+ * @param[in] enabled: True to signal data ready on the interrupt pin
+ * @return @ref zos_result_t, ZOS_UNSUPPORTED if the driver has no data ready interrupt
+ */
+zos_result_t sensor_thermometer_set_data_ready_irq(zos_bool_t enabled);
+
 
 /**
  * Read raw data from sensor
@@ -81,4 +100,10 @@ zos_result_t sensor_thermometer_read(uint16_t *raw_data);
  */
 int32_t sensor_thermometer_convert(uint16_t raw_value);
 
-
+/**
+ * Fill thermometer data from a normalized value
+ *
+ * @param[in] temp: Temperature in degC x @ref SENSOR_THERMOMETER_OUTPUT_SCALE
+ * @param[out] data: Thermometer data
+ */
+void sensor_thermometer_set_data(int32_t temp, thermometer_data_t *data);
@@ -0,0 +1,94 @@
+/*
+ * ZentriOS SDK LICENSE AGREEMENT | Zentri.com, 2016.
+ *
+ * Use of source code and/or libraries contained in the ZentriOS SDK is
+ * subject to the Zentri Operating System SDK license agreement and
+ * applicable open source license agreements.
+ *
+ */
+
+#include "reg_shadow.h"
+
+
+#define BIT_IS_SET(bitmap, i)   (((bitmap)[(i) >> 3] & (1 << ((i) & 7))) != 0)
+#define BIT_SET(bitmap, i)      (bitmap)[(i) >> 3] |= (1 << ((i) & 7))
+
+
+
+static zos_bool_t get_index(const reg_shadow_t *shadow, uint8_t reg, uint8_t *index);
+
+
+
+/*************************************************************************************************/
+void reg_shadow_init(reg_shadow_t *shadow, uint8_t first, uint8_t count)
+{
+    memset(shadow, 0, sizeof(reg_shadow_t));
+    shadow->first = first;
+    shadow->count = MIN(count, REG_SHADOW_MAX_REGISTERS);
+}
+
+/*************************************************************************************************/
+void reg_shadow_set_volatile(reg_shadow_t *shadow, uint8_t reg)
+{
+    uint8_t i;
+
+    if(get_index(shadow, reg, &i))
+    {
+        BIT_SET(shadow->volatile_regs, i);
+    }
+}
+
+/*************************************************************************************************/
+void reg_shadow_invalidate(reg_shadow_t *shadow)
+{
+    memset(shadow->valid, 0, sizeof(shadow->valid));
+}
+
+/*************************************************************************************************/
+zos_bool_t reg_shadow_get(const reg_shadow_t *shadow, uint8_t reg, uint8_t *value)
+{
+    uint8_t i;
+
+    if(get_index(shadow, reg, &i) && BIT_IS_SET(shadow->valid, i))
+    {
+        *value = shadow->values[i];
+        return ZOS_TRUE;
+    }
+
+    return ZOS_FALSE;
+}
+
+/*************************************************************************************************/
+void reg_shadow_set(reg_shadow_t *shadow, uint8_t reg, uint8_t value)
+{
+    uint8_t i;
+
+    if(get_index(shadow, reg, &i) && !BIT_IS_SET(shadow->volatile_regs, i))
+    {
+        shadow->values[i] = value;
+        BIT_SET(shadow->valid, i);
+    }
+}
+
+/*************************************************************************************************/
+zos_bool_t reg_shadow_is_current(const reg_shadow_t *shadow, uint8_t reg, uint8_t value)
+{
+    uint8_t known;
+
+    return (reg_shadow_get(shadow, reg, &known) && (known == value)) ? ZOS_TRUE : ZOS_FALSE;
+}
+
+
+
+/*************************************************************************************************/
+static zos_bool_t get_index(const reg_shadow_t *shadow, uint8_t reg, uint8_t *index)
+{
+    if((reg < shadow->first) || (reg - shadow->first >= shadow->count))
+    {
+        return ZOS_FALSE;
+    }
+
+    *index = reg - shadow->first;
+
+    return ZOS_TRUE;
+}
@@ -0,0 +1,95 @@
+/*
+ * ZentriOS SDK LICENSE AGREEMENT | Zentri.com, 2016.
+ *
+ * Use of source code and/or libraries contained in the ZentriOS SDK is
+ * subject to the Zentri Operating System SDK license agreement and
+ * applicable open source license agreements.
+ *
+ */
+
+#pragma once
+
+
+#include "zos.h"
+
+
+/** Maximum number of consecutive registers one shadow can cover */
+#define REG_SHADOW_MAX_REGISTERS 64
+
+
+/**
+ * Host copy of a window of device configuration registers.
+ *
+ * A register value is only served from the shadow once it is known, i.e. it
+ * was read from or written to the device. Datasheet reset values are not
+ * assumed: the device keeps its configuration across a host-only reset.
+ * Registers the device changes on its own (status, data output, self-clearing
+ * command bits) must be marked volatile so they always hit the bus.
+ *
+ * The shadow does no I/O itself, drivers consult it from their register
+ * read/write helpers so the bus access and error conventions stay their own.
+ */
+typedef struct
+{
+    uint8_t first;                                      //!< Address of the first shadowed register
+    uint8_t count;                                      //!< Number of shadowed registers
+    uint8_t valid[REG_SHADOW_MAX_REGISTERS/8];          //!< Bit set: register value is known
+    uint8_t volatile_regs[REG_SHADOW_MAX_REGISTERS/8];  //!< Bit set: register is never cached
+    uint8_t values[REG_SHADOW_MAX_REGISTERS];           //!< Known register values
+} reg_shadow_t;
+
+
+/**
+ * Initialise an empty shadow covering registers `first` .. `first + count - 1`
+ *
+ * @param[out] shadow: Shadow to initialise
+ * @param[in] first: Address of the first shadowed register
+ * @param[in] count: Number of registers, clamped to @ref REG_SHADOW_MAX_REGISTERS
+ */
+void reg_shadow_init(reg_shadow_t *shadow, uint8_t first, uint8_t count);
+
+/**
+ * Mark a register as volatile, it will never be served from or stored in the shadow
+ *
+ * @param[in] shadow: Shadow
+ * @param[in] reg: Register address
+ */
+void reg_shadow_set_volatile(reg_shadow_t *shadow, uint8_t reg);
+
+/**
+ * Forget all known register values, e.g. after a reset with unknown outcome
+ *
+ * @param[in] shadow: Shadow
+ */
+void reg_shadow_invalidate(reg_shadow_t *shadow);
+
+/**
+ * Get the known value of a register
+ *
+ * @param[in] shadow: Shadow
+ * @param[in] reg: Register address
+ * @param[out] value: Known register value, only written when ZOS_TRUE is returned
+ * @return ZOS_TRUE if the value is known and the device does not need to be read
+ */
+zos_bool_t reg_shadow_get(const reg_shadow_t *shadow, uint8_t reg, uint8_t *value);
+
+/**
+ * Record a value read from or written to the device
+ *
+ * Does nothing for volatile registers and registers outside the shadow.
+ *
+ * @param[in] shadow: Shadow
+ * @param[in] reg: Register address
+ * @param[in] value: Register value
+ */
+void reg_shadow_set(reg_shadow_t *shadow, uint8_t reg, uint8_t value);
+
+/**
+ * Check whether writing a value would leave the register unchanged
+ *
+ * @param[in] shadow: Shadow
+ * @param[in] reg: Register address
+ * @param[in] value: Value about to be written
+ * @return ZOS_TRUE if the register is known to hold `value` and the write can be skipped
+ */
+zos_bool_t reg_shadow_is_current(const reg_shadow_t *shadow, uint8_t reg, uint8_t value);
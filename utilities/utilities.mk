@@ -1,6 +1,7 @@
 NAME := lib_utilities
 
 
-$(NAME)_SOURCES := crc32.c
+$(NAME)_SOURCES := crc32.c \
+                   reg_shadow.c
 
 GLOBAL_INCLUDES := .
\ No newline at end of file
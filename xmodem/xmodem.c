@@ -40,6 +40,15 @@
 #define XMODEM_STX4K 0x21
 #define XMODEM_STX8K 0x22
 
+typedef enum
+{
+    STATE_WRITE_IDLE,
+    STATE_WRITE_WAIT_START,
+    STATE_WRITE_WAIT_DATA,
+    STATE_WRITE_WAIT_ACK,
+    STATE_WRITE_WAIT_EOT_ACK
+} xmodem_tx_state_t;
+
 typedef enum
 {
     STATE_READ_SOH,
@@ -69,9 +78,36 @@ typedef struct
     zos_bool_t halted;
     uint8_t can_count;
     zos_bool_t block_received;
+
+    xmodem_tx_state_t tx_state;
+    uint8_t *tx_frame;
+    uint16_t tx_block_len;
+    uint16_t tx_fill;
+    const uint8_t *tx_src;
+    uint32_t tx_file;
+    zos_bool_t tx_from_file;
+    uint32_t tx_remaining;
+    zos_bool_t tx_eot;
+    uint8_t tx_blk_num;
+    uint8_t tx_retries;
+    uint8_t tx_can_count;
+    uint32_t tx_timestamp;
 } xmodem_context_t;
 
 
+static const struct
+{
+    uint8_t header;
+    uint16_t length;
+} block_types[XMODEM_BLOCK_SIZE_MAX] =
+{
+    [XMODEM_BLOCK_SIZE_128] = { XMODEM_SOH,     XMODEM_PACKET_SIZE_LEGACY },
+    [XMODEM_BLOCK_SIZE_1K]  = { XMODEM_STX,     XMODEM_PACKET_SIZE_1K },
+    [XMODEM_BLOCK_SIZE_2K]  = { XMODEM_STX2K,   2048 },
+    [XMODEM_BLOCK_SIZE_4K]  = { XMODEM_STX4K,   4096 },
+    [XMODEM_BLOCK_SIZE_8K]  = { XMODEM_STX8K,   8192 },
+};
+
 static xmodem_context_t context;
 
 
@@ -85,6 +121,10 @@ zos_result_t xmodem_init(const xmodem_config_t *config)
     {
         context.config.idle_period = IDLE_TIMEOUT;
     }
+    if(context.config.write_block_size >= XMODEM_BLOCK_SIZE_MAX)
+    {
+        context.config.write_block_size = XMODEM_BLOCK_SIZE_1K;
+    }
 
     context.saved_uart_callback = zn_uart_register_rx_callback(context.config.uart, uart_rx_callback);
     zn_uart_register_rx_callback(context.config.uart, context.saved_uart_callback );
@@ -95,6 +135,11 @@ zos_result_t xmodem_init(const xmodem_config_t *config)
 /*************************************************************************************************/
 zos_result_t xmodem_read_start(void)
 {
+    if(context.tx_state != STATE_WRITE_IDLE)
+    {
+        return ZOS_PENDING;
+    }
+
     DEBUG_XMODEM("Xmodem RX started");
     zn_cmd_set_console_enabled(ZOS_FALSE);
     zn_event_register_periodic(xmodem_read_event_handler, NULL, MIN(context.config.idle_period, 100), 0);
@@ -140,7 +185,42 @@ zos_result_t xmodem_read_stop(void)
 /*************************************************************************************************/
 zos_result_t xmodem_write(void *data, uint32_t length, zos_bool_t eot)
 {
-    return ZOS_UNIMPLEMENTED;
+    zos_result_t result;
+
+    if(!ZOS_FAILED(result, write_prepare(length, eot)))
+    {
+        context.tx_src = data;
+        context.tx_from_file = ZOS_FALSE;
+        write_begin();
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+zos_result_t xmodem_write_file(uint32_t file_handle, uint32_t length, zos_bool_t eot)
+{
+    zos_result_t result;
+
+    if(!ZOS_FAILED(result, write_prepare(length, eot)))
+    {
+        context.tx_file = file_handle;
+        context.tx_from_file = ZOS_TRUE;
+        write_begin();
+    }
+
+    return result;
+}
+
+/*************************************************************************************************/
+zos_result_t xmodem_write_stop(void)
+{
+    if(context.tx_state != STATE_WRITE_IDLE)
+    {
+        write_finish(ZOS_ABORTED);
+    }
+
+    return ZOS_SUCCESS;
 }
 
 /*************************************************************************************************/
@@ -154,6 +234,11 @@ static void uart_rx_callback(uint32_t unused)
     {
         return;
     }
+    else if(context.tx_state != STATE_WRITE_IDLE)
+    {
+        // only ACK/NAK/CAN are expected while writing, no need to throttle
+        zn_event_issue(xmodem_write_event_handler, NULL, EVENT_FLAGS1(FROM_IRQ));
+    }
     else if(context.rx_state == STATE_READ_PACKET)
     {
         if(length >= MIN(context.rx_bytes_remaining, 128))
@@ -207,10 +292,13 @@ static void xmodem_read_event_handler(void *arg)
         {
             //DEBUG_XMODEM("STATE_READ_SOH: STX");
             context.rx_state = STATE_READ_BLK_NUM;
-            context.packet_len = (rx_value == XMODEM_STX8K) ? 8092 :
-                                 (rx_value == XMODEM_STX4K) ? 4096 :
-                                 (rx_value == XMODEM_STX2K) ? 2048 :
-                                 (rx_value == XMODEM_STX)   ? 1024 : 128;
+            for(int i = 0; i < XMODEM_BLOCK_SIZE_MAX; ++i)
+            {
+                if(block_types[i].header == rx_value)
+                {
+                    context.packet_len = block_types[i].length;
+                }
+            }
             context.block_received = ZOS_FALSE;
             goto loop;
         }
@@ -488,3 +576,281 @@ static void send_cancel_sequence(void)
         send_byte(XMODEM_CAN);
     }
 }
+
+/*************************************************************************************************/
+static zos_result_t write_prepare(uint32_t length, zos_bool_t eot)
+{
+    if(context.tx_state == STATE_WRITE_IDLE)
+    {
+        const uint16_t block_len = block_types[context.config.write_block_size].length;
+
+        if(context.buffer != NULL || context.rx_state != STATE_READ_SOH)
+        {
+            return ZOS_PENDING;
+        }
+        // header, block number, inverted block number, data, checksum
+        else if((context.tx_frame = zn_malloc_ptr(block_len + 4)) == NULL)
+        {
+            return ZOS_NO_MEM;
+        }
+
+        DEBUG_XMODEM("Xmodem TX started");
+        zn_cmd_set_console_enabled(ZOS_FALSE);
+        zn_event_register_periodic(xmodem_write_event_handler, NULL, 100, 0);
+        zn_uart_register_rx_callback(context.config.uart, uart_rx_callback);
+
+        context.tx_block_len = block_len;
+        context.tx_fill = 0;
+        context.tx_blk_num = 1;
+        context.tx_retries = 0;
+        context.tx_can_count = 0;
+        context.tx_timestamp = zn_rtos_get_time();
+        context.tx_state = STATE_WRITE_WAIT_START;
+    }
+    else if(context.tx_state != STATE_WRITE_WAIT_DATA &&
+           (context.tx_remaining > 0 || context.tx_eot))
+    {
+        return ZOS_PENDING;
+    }
+
+    context.tx_remaining = length;
+    context.tx_eot = eot;
+
+    return ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+static void write_begin(void)
+{
+    // the first block goes out once the receiver sent its NAK
+    if(context.tx_state == STATE_WRITE_WAIT_DATA)
+    {
+        write_next();
+    }
+}
+
+/*************************************************************************************************
+ * Send the next block or EOT once the previous block was acknowledged
+ */
+static void write_next(void)
+{
+    zos_result_t result;
+
+    context.tx_retries = 0;
+
+    if(ZOS_FAILED(result, fill_tx_block()))
+    {
+        write_finish(result);
+    }
+    else if(context.tx_fill == context.tx_block_len || (context.tx_fill > 0 && context.tx_eot))
+    {
+        uint8_t *data = &context.tx_frame[3];
+        uint8_t checksum = 0;
+
+        memset(&data[context.tx_fill], XMODEM_EOF, context.tx_block_len - context.tx_fill);
+        for(const uint8_t *ptr = data, *end = &data[context.tx_block_len]; ptr < end; ++ptr)
+        {
+            checksum += *ptr;
+        }
+
+        context.tx_frame[0] = block_types[context.config.write_block_size].header;
+        context.tx_frame[1] = context.tx_blk_num;
+        context.tx_frame[2] = ~context.tx_blk_num;
+        data[context.tx_block_len] = checksum;
+
+        context.tx_state = STATE_WRITE_WAIT_ACK;
+        send_tx_frame();
+    }
+    else if(context.tx_eot)
+    {
+        context.tx_state = STATE_WRITE_WAIT_EOT_ACK;
+        send_tx_frame();
+    }
+    else
+    {
+        // all data consumed, a partial block waits for the next write
+        context.tx_state = STATE_WRITE_WAIT_DATA;
+        if(context.config.callback.write_done != NULL)
+        {
+            context.config.callback.write_done(ZOS_SUCCESS);
+        }
+    }
+}
+
+/*************************************************************************************************/
+static zos_result_t fill_tx_block(void)
+{
+    while(context.tx_fill < context.tx_block_len && context.tx_remaining > 0)
+    {
+        uint8_t *ptr = &context.tx_frame[3 + context.tx_fill];
+        uint32_t chunk = MIN(context.tx_block_len - context.tx_fill, context.tx_remaining);
+
+        if(context.tx_from_file)
+        {
+            uint32_t bytes_read;
+            zos_result_t result;
+
+            if(ZOS_FAILED(result, zn_file_read(context.tx_file, ptr, chunk, &bytes_read)))
+            {
+                return result;
+            }
+            else if(bytes_read == 0)
+            {
+                return ZOS_ERROR;
+            }
+            chunk = bytes_read;
+        }
+        else
+        {
+            memcpy(ptr, context.tx_src, chunk);
+            context.tx_src += chunk;
+        }
+
+        context.tx_fill += chunk;
+        context.tx_remaining -= chunk;
+    }
+
+    return ZOS_SUCCESS;
+}
+
+/*************************************************************************************************/
+static void send_tx_frame(void)
+{
+    context.tx_timestamp = zn_rtos_get_time();
+
+    if(context.tx_state == STATE_WRITE_WAIT_EOT_ACK)
+    {
+        send_byte(XMODEM_EOT);
+    }
+    else
+    {
+        // the whole block in one transfer keeps the UART busy at wire speed
+        zn_uart_transmit_bytes(context.config.uart, context.tx_frame, context.tx_block_len + 4);
+    }
+}
+
+/*************************************************************************************************
+ * Executes when the receiver responds and periodically to check for timeouts
+ */
+static void xmodem_write_event_handler(void *arg)
+{
+    uint8_t rx_value;
+
+    while(context.tx_state != STATE_WRITE_IDLE &&
+          zn_uart_receive_bytes(context.config.uart, &rx_value, 1, ZOS_NO_WAIT) == ZOS_SUCCESS)
+    {
+        if(rx_value == XMODEM_CAN)
+        {
+            if(++context.tx_can_count > 1)
+            {
+                DEBUG_XMODEM("TX: receiver cancelled");
+                write_finish(ZOS_ABORTED);
+            }
+            continue;
+        }
+
+        context.tx_can_count = 0;
+
+        switch(context.tx_state)
+        {
+        case STATE_WRITE_WAIT_START:
+            if(rx_value == XMODEM_NAK)
+            {
+                context.tx_state = STATE_WRITE_WAIT_DATA;
+                write_next();
+            }
+            break;
+
+        case STATE_WRITE_WAIT_ACK:
+            if(rx_value == XMODEM_ACK)
+            {
+                context.tx_fill = 0;
+                ++context.tx_blk_num;
+                write_next();
+            }
+            else if(rx_value == XMODEM_NAK)
+            {
+                write_retry();
+            }
+            break;
+
+        case STATE_WRITE_WAIT_EOT_ACK:
+            if(rx_value == XMODEM_ACK)
+            {
+                DEBUG_XMODEM("TX: complete");
+                write_finish(ZOS_SUCCESS);
+            }
+            else if(rx_value == XMODEM_NAK)
+            {
+                write_retry();
+            }
+            break;
+
+        default:
+            // the receiver NAKs while idle, nothing to resend until more data is written
+            break;
+        }
+    }
+
+    if((context.tx_state == STATE_WRITE_WAIT_START ||
+        context.tx_state == STATE_WRITE_WAIT_ACK ||
+        context.tx_state == STATE_WRITE_WAIT_EOT_ACK) &&
+       (zn_rtos_get_time() - context.tx_timestamp) > PACKET_TIMEOUT)
+    {
+        DEBUG_XMODEM("TX: PACKET_TIMEOUT");
+        if(context.tx_state == STATE_WRITE_WAIT_START)
+        {
+            context.tx_timestamp = zn_rtos_get_time();
+            if(++context.tx_retries > MAX_ERROR_COUNT)
+            {
+                write_finish(ZOS_TIMEOUT);
+            }
+        }
+        else
+        {
+            write_retry();
+        }
+    }
+}
+
+/*************************************************************************************************/
+static void write_retry(void)
+{
+    if(++context.tx_retries > MAX_ERROR_COUNT)
+    {
+        write_finish(ZOS_ERROR);
+    }
+    else
+    {
+        send_tx_frame();
+    }
+}
+
+/*************************************************************************************************/
+static void write_finish(zos_result_t result)
+{
+    // no need to cancel if the receiver did
+    if(result != ZOS_SUCCESS && context.tx_can_count < 2)
+    {
+        send_cancel_sequence();
+    }
+
+    context.tx_state = STATE_WRITE_IDLE;
+    context.tx_remaining = 0;
+    context.tx_eot = ZOS_FALSE;
+
+    zn_event_unregister_all(xmodem_write_event_handler);
+    zn_uart_register_rx_callback(context.config.uart, context.saved_uart_callback);
+    zn_cmd_set_console_enabled(ZOS_TRUE);
+
+    if(context.tx_frame != NULL)
+    {
+        zn_free(context.tx_frame);
+        context.tx_frame = NULL;
+    }
+
+    if(context.config.callback.write_done != NULL)
+    {
+        context.config.callback.write_done(result);
+    }
+}
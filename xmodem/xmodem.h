@@ -15,6 +15,26 @@
 
 typedef void (*xmodem_read_error_t)(zos_result_t error);
 
+/**
+ * Called once the data given to xmodem_write()/xmodem_write_file() has been
+ * sent and acknowledged (a trailing partial block is kept and sent with the
+ * next write) or, after an EOT write, once the receiver acknowledged the EOT.
+ * Any other result means the transfer was aborted.
+ * Until then xmodem_write() keeps reading blocks from the caller's buffer.
+ */
+typedef void (*xmodem_write_done_t)(zos_result_t result);
+
+
+typedef enum
+{
+    XMODEM_BLOCK_SIZE_128,  // SOH, standard XMODEM
+    XMODEM_BLOCK_SIZE_1K,   // STX, XMODEM-1K
+    XMODEM_BLOCK_SIZE_2K,   // STX2K
+    XMODEM_BLOCK_SIZE_4K,   // STX4K
+    XMODEM_BLOCK_SIZE_8K,   // STX8K
+    XMODEM_BLOCK_SIZE_MAX
+} xmodem_block_size_t;
+
 
 typedef struct
 {
@@ -22,9 +42,11 @@ typedef struct
     {
         zos_event_handler_t block_read;
         xmodem_read_error_t read_error;
+        xmodem_write_done_t write_done;
     } callback;
     zos_uart_t uart;
     uint16_t idle_period;
+    xmodem_block_size_t write_block_size;
 } xmodem_config_t;
 
 
@@ -37,4 +59,14 @@ zos_result_t xmodem_read_stop(void);
 
 zos_result_t xmodem_read_halt(void);
 
+/**
+ * Send `length` bytes as XMODEM blocks, ending the transfer with EOT if `eot` is set.
+ *
+ * Blocks are copied from `data` one at a time as the receiver acknowledges the
+ * previous one, so `data` must stay valid until the write_done callback fires.
+ */
 zos_result_t xmodem_write(void *data, uint32_t length, zos_bool_t eot);
+
+zos_result_t xmodem_write_file(uint32_t file_handle, uint32_t length, zos_bool_t eot);
+
+zos_result_t xmodem_write_stop(void);